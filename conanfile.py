@@ -65,9 +65,7 @@ class CynlrCameraConan(ConanFile):
         self.requires("opencv/4.12.0", transitive_headers=True)
     
     def build_requirements(self):
-        # Uncomment when adding proper GTest unit tests
-        # self.test_requires("gtest/1.17.0")
-        pass
+        self.test_requires("gtest/1.17.0")
     
     def layout(self):
         cmake_layout(self)
@@ -93,9 +91,8 @@ class CynlrCameraConan(ConanFile):
         cmake.configure()
         cmake.build()
         
-        # Uncomment when adding proper GTest unit tests
-        # if not self.conf.get("tools.build:skip_test", default=False, check_type=bool):
-        #     cmake.test()
+        if not self.conf.get("tools.build:skip_test", default=False, check_type=bool):
+            cmake.test()
     
     def package(self):
         cmake = CMake(self)
@@ -9,8 +9,10 @@ extern "C" {
     #include <arv.h>
 }
 
+#include "BufferPool.hpp"
 #include "CameraBackend.hpp"
 #include "Frame.hpp"
+#include "GigETransport.hpp"
 #include "Stream.hpp"
 #include "AravisStream.hpp"
 
@@ -25,6 +27,10 @@ static const std::unordered_map<PixelFormat, ArvPixelFormat> pixel_format_map =
     { PixelFormat::MONO12,         ARV_PIXEL_FORMAT_MONO_12 },
     { PixelFormat::MONO14,         ARV_PIXEL_FORMAT_MONO_14 },
     { PixelFormat::MONO16,         ARV_PIXEL_FORMAT_MONO_16 },
+    { PixelFormat::MONO10P,        ARV_PIXEL_FORMAT_MONO_10_P },
+    { PixelFormat::MONO12P,        ARV_PIXEL_FORMAT_MONO_12_P },
+    { PixelFormat::MONO10_PACKED,  ARV_PIXEL_FORMAT_MONO_10_PACKED },
+    { PixelFormat::MONO12_PACKED,  ARV_PIXEL_FORMAT_MONO_12_PACKED },
 };
 
 static const std::unordered_map<AcquisitionMode, ArvAcquisitionMode> acq_mode_map = {
@@ -33,32 +39,97 @@ static const std::unordered_map<AcquisitionMode, ArvAcquisitionMode> acq_mode_ma
     { AcquisitionMode::ACQUISITION_MODE_MULTI_FRAME, ARV_ACQUISITION_MODE_MULTI_FRAME }
 };
 
+static const std::unordered_map<TriggerSource, const char*> trigger_source_map = {
+    { TriggerSource::SOFTWARE, "Software" },
+    { TriggerSource::LINE0,    "Line0" },
+    { TriggerSource::LINE1,    "Line1" },
+    { TriggerSource::LINE2,    "Line2" },
+    { TriggerSource::LINE3,    "Line3" },
+};
+
+static const std::unordered_map<TriggerActivation, const char*> trigger_activation_map = {
+    { TriggerActivation::RISING_EDGE,  "RisingEdge" },
+    { TriggerActivation::FALLING_EDGE, "FallingEdge" },
+    { TriggerActivation::ANY_EDGE,     "AnyEdge" },
+    { TriggerActivation::LEVEL_HIGH,   "LevelHigh" },
+    { TriggerActivation::LEVEL_LOW,    "LevelLow" },
+};
+
+/* ChunkSelector entry of each chunk, and the node holding its value in the chunk data */
+static const std::unordered_map<ChunkSelector, pair<const char*, const char*>> chunk_selector_map = {
+    { ChunkSelector::EXPOSURE_TIME,   { "ExposureTime",  "ChunkExposureTime" } },
+    { ChunkSelector::GAIN,            { "Gain",          "ChunkGain" } },
+    { ChunkSelector::TIMESTAMP,       { "Timestamp",     "ChunkTimestamp" } },
+    { ChunkSelector::FRAME_ID,        { "FrameID",       "ChunkFrameID" } },
+    { ChunkSelector::LINE_STATUS_ALL, { "LineStatusAll", "ChunkLineStatusAll" } },
+    { ChunkSelector::COUNTER_VALUE,   { "CounterValue",  "ChunkCounterValue" } },
+};
+
 class AravisBackend : public ICameraBackend {
 public:
     ~AravisBackend();
 
     static unique_ptr<AravisBackend> create(
         const char* name,
-        uint32_t stream_buffer_count = DEFAULT_NUM_BUFFERS);
+        uint32_t stream_buffer_count = DEFAULT_NUM_BUFFERS,
+        BufferPoolConfig pool_config = BufferPoolConfig());
 
     static std::vector<std::string> listCameras();
 
+    /* Probe the largest packet size on every camera, then set each one's
+     * packet delay so that together they fit on one NIC. Each camera gets a
+     * share of `headroom` times the link speed in proportion to the
+     * bandwidth it needs at its frame rate, so bursts from different
+     * cameras interleave instead of overflowing the NIC's buffers.
+     *
+     * @param cameras GigE cameras sharing one network interface.
+     * @param headroom Fraction of the link the cameras may use together.
+     * @return An error if a camera is not GigE, or if the cameras need more
+     *         than the link carries, or nullopt if successful. */
+    static optional<CamError> autoConfigureTransport(
+        const vector<AravisBackend*> &cameras,
+        double headroom = GIGE_DEFAULT_HEADROOM);
+
     optional<CamError> startAcquisition() override;
     optional<CamError> stopAcquisition() override;
     optional<CamError> setAcquisitionMode(AcquisitionMode mode) override;
     optional<CamError> setPixelFormat(PixelFormat format) override;
     optional<CamError> setBinning(int dx, int dy) override;
+    optional<CamError> setRegion(int x, int y, int width, int height) override;
+    optional<CamError> setRegions(const vector<Region> &regions) override;
     optional<CamError> setGain(double gain) override;
     optional<CamError> setAutoExposure(bool setAuto) override;
     optional<CamError> setExposureTime(double exposure_time_us) override;
     optional<CamError> setFrameRate(double framerate) override;
+    optional<CamError> enablePtp(bool enable) override;
+
+    optional<CamError> setTriggerMode(bool enable) override;
+    optional<CamError> setTriggerSource(TriggerSource source) override;
+    optional<CamError> setTriggerActivation(TriggerActivation activation) override;
+    optional<CamError> setTriggerDelay(double delay_us) override;
+    optional<CamError> fireSoftwareTrigger() override;
 
     optional<CamError> enableLensPower(bool enable) override;
     optional<CamError> setupLensSerial(const char* baudRate) override;
     optional<CamError> setLensFocus(double voltage) override;
+    optional<CamError> setLensResultCheck(bool enable) override;
+    optional<CamError> checkLensResult() override;
+    optional<CamError> enableChunks(const vector<ChunkSelector> &chunks) override;
 
     shared_ptr<IStream> getStream() override;
 
+    /* Apply GigE transport settings, camera and receiver side.
+     *
+     * @param config The settings; unset fields are left alone.
+     * @return An error if a setting was rejected, or nullopt if successful. */
+    optional<CamError> configureTransport(const TransportConfig &config);
+
+    /* Report the link usage of this camera's stream.
+     *
+     * @param report Filled with the packet settings and bandwidth figures.
+     * @return An error if this is not a GigE camera, or nullopt if successful. */
+    optional<CamError> getTransportReport(TransportReport &report);
+
 private:
     AravisBackend(
         ArvCamera *camera,
@@ -67,12 +138,43 @@ private:
         camera(camera), stream(stream), stream_buffer_count(stream_buffer_count) {}
 
     optional<CamError> writeSerialFileAccess(const void* data, size_t length);
+    optional<CamError> readSerialResult();
+    optional<CamError> checkRegion(const Region &region);
+
+    /* Link speed from GevLinkSpeed, or GIGE_DEFAULT_LINK_BPS if not reported */
+    double linkSpeed();
+
+    /* GenICam node by name, resolved on first use and cached, or NULL if the
+     * camera has no such feature. The setters below go through this cache
+     * instead of looking the node up by name on every write. */
+    ArvGcNode *feature(const char *name);
+
+    /* Value of entry `entry` of enumeration `name`, cached after the first
+     * lookup, so setting an enumeration by name skips the entry search. */
+    optional<CamError> enumEntryValue(const char *name, ArvGcNode *node, const char *entry, gint64 &value);
+
+    optional<CamError> setStringFeature(const char *name, const char *value);
+    optional<CamError> setIntegerFeature(const char *name, gint64 value);
+    optional<CamError> setFloatFeature(const char *name, double value);
+    optional<CamError> setBooleanFeature(const char *name, bool value);
+    optional<CamError> executeCommand(const char *name);
+
+    /* Address of a register node, cached after the first lookup */
+    optional<CamError> registerAddress(const char *name, guint64 &address);
 
     ArvCamera *camera;
     shared_ptr<AravisStream> stream;
     uint32_t stream_buffer_count;
-    GError *error = NULL;
     bool serial_port_open = false;
+    bool lens_result_check = false;
+    /* FileAccessLength of the last serial write, or -1 when FileSelector,
+     * FileAccessOffset and FileOperationSelector must be sent again. Those
+     * keep their values between writes, so a lens command normally costs
+     * only the buffer write and the execute. */
+    gint64 serial_write_length = -1;
+    unordered_map<string, ArvGcNode*> feature_nodes;
+    unordered_map<string, gint64> enum_entries;     // "Feature/Entry" -> entry value
+    unordered_map<string, guint64> register_addresses;
 };
 
 }  // namespace camera
@@ -1,39 +1,111 @@
+#pragma once
+
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <optional>
-#include "Stream.hpp"
+#include <vector>
+#include "BufferPool.hpp"
+#include "BufferedStream.hpp"
+#include "Constants.hpp"
+#include "GigETransport.hpp"
 
 extern "C" {
     #include <arv.h>
 }
 
-#define DEFAULT_NUM_BUFFERS 10
-
 namespace cynlr {
 namespace camera {
 
 using namespace std;
 
-class AravisStream : public IStream {
+class AravisStream : public BufferedStream {
 public:
 
     /* Constructor for AravisStream.
      *
-     * @param stream The ArvStream to wrap. */
-    AravisStream(ArvStream *stream) : m_stream(stream) {}
+     * @param stream The ArvStream to wrap.
+     * @param pool_config Options for the buffer pool backing the stream.
+     * @param thread_priority Priority the stream's callback applies to the
+     *        receive thread, or nullptr if the stream has no such callback. */
+    AravisStream(
+        ArvStream *stream,
+        BufferPoolConfig pool_config = BufferPoolConfig(),
+        unique_ptr<atomic<StreamThreadPriority>> thread_priority = nullptr) :
+        m_stream(stream), m_pool_config(pool_config), m_thread_priority(move(thread_priority)) {}
     ~AravisStream() {
+        stopWorker();
+        void *latest = takeLatest();
+        if (latest != nullptr) {
+            pushBuffer(latest);
+        }
         g_clear_object(&m_stream);
+        g_clear_object(&m_chunk_genicam);
     };
 
-    optional<StreamError> borrowOldestFrame(FrameBuffer &frame) override;
-    optional<StreamError> borrowNewestFrame(FrameBuffer &frame) override;
-    optional<StreamError> borrowNextNewFrame(FrameBuffer &frame) override;
-    void releaseFrame(FrameBuffer &frame) override;
+    /* Make sure the stream has `count` buffers of `payload` bytes queued.
+     * The pool is reused as-is when nothing changed, so restarting the
+     * acquisition costs no allocation; frames left over from the previous
+     * acquisition are recycled. When the payload changes the pool is
+     * reallocated, and frames still borrowed from the old pool are freed
+     * when released instead of being re-queued.
+     *
+     * @param payload Size of each buffer in bytes.
+     * @param count Number of buffers.
+     * @return An error if the operation failed, or nullopt if successful. */
+    optional<StreamError> prepareBuffers(size_t payload, uint32_t count);
+
+    /* Parse the given chunks into FrameBuffer::chunks from now on. The chunk
+     * nodes are looked up here, once, so parsing a frame costs no lookup or
+     * allocation. An empty list stops parsing.
+     *
+     * @param device Device whose GenICam description lays out the chunks.
+     * @param chunks The chunks to parse.
+     * @return An error if the camera describes no node for one of them, or nullopt if successful. */
+    optional<StreamError> setChunks(ArvDevice *device, const vector<ChunkSelector> &chunks);
+
+    /* Apply the receive-side settings of `config`: socket buffer, packet
+     * resend and timeouts, and the receive thread priority. A new priority
+     * restarts the receive thread, losing any frame in transit.
+     *
+     * @param config Transport settings; camera-side fields are ignored.
+     * @return An error if this is not a GigE stream, or nullopt if successful. */
+    optional<StreamError> configureReceiver(const TransportConfig &config);
 
     ArvStream *m_stream;
 
+protected:
+    void *popBuffer(chrono::microseconds timeout) override;
+    void pushBuffer(void *buffer) override;
+    int queuedFrameCount() override;
+    int freeBufferCount() override;
+    void transportCounters(StreamStats &stats) override;
+    FrameStatus bufferStatus(void *buffer) override;
+    uint64_t bufferCompletedNs(void *buffer) override;
+    void fillFrameBuffer(void *buffer, FrameBuffer &frame) override;
+
 private:
-    optional<StreamError> populateFrameBuffer(FrameBuffer &frame);
+    typedef struct ChunkNode {
+        ChunkSelector chunk;
+        ArvGcNode *node;        // owned by m_chunk_genicam
+        bool is_float;
+    } ChunkNode;
+
+    void parseChunks(ArvBuffer *buffer, FrameChunks &chunks);
+
+    BufferPoolConfig m_pool_config;
+    shared_ptr<BufferPool> m_pool;
+    atomic<const BufferPool*> m_current_pool{nullptr};
+    unique_ptr<atomic<StreamThreadPriority>> m_thread_priority;
+
+    /* Chunk parsing. A private copy of the GenICam description reads the
+     * chunk nodes out of one buffer at a time, so it never touches the
+     * control channel. Guarded by m_chunk_mutex. */
+    mutex m_chunk_mutex;
+    ArvGc *m_chunk_genicam = nullptr;
+    vector<ChunkNode> m_chunk_nodes;
+    atomic<bool> m_parse_chunks{false};
 };
- 
-}  // namespace camera 
-}  // namespace cynlr
\ No newline at end of file
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "Camera.hpp"
+#include "CameraBackend.hpp"
+#include "Error.hpp"
+#include "Frame.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+enum class SharpnessMetric {
+    LAPLACIAN_VARIANCE,     // variance of the 3x3 Laplacian; responds to the finest detail
+    TENENGRAD,              // mean squared Sobel gradient; less sensitive to noise
+};
+
+enum class FocusSearch {
+    GOLDEN_SECTION,         // fewest frames; assumes one sharpness peak in the range
+    COARSE_TO_FINE,         // evenly spaced passes narrowing around the best; tolerates side peaks
+};
+
+typedef struct AutofocusConfig {
+    SharpnessMetric metric = SharpnessMetric::LAPLACIAN_VARIANCE;
+    FocusSearch search = FocusSearch::GOLDEN_SECTION;
+    Region roi;                             // in frame pixels; zero size for the whole frame
+    double min_voltage = 24.0;
+    double max_voltage = 70.0;
+    double tolerance = 0.25;                // stop once the peak is bracketed this closely, in volts
+    int coarse_steps = 8;                   // voltages per COARSE_TO_FINE pass, at least 3
+    uint32_t settle_time_us = 10000;        // time the lens takes to reach a new voltage
+    uint32_t frame_latency_us = 0;          // exposure start to host receive: exposure plus transfer time
+    uint32_t max_frames = 60;               // frames the search may consume, skipped ones included
+    chrono::microseconds frame_timeout = chrono::seconds(1);
+} AutofocusConfig;
+
+typedef struct AutofocusResult {
+    double voltage = 0.0;                   // sharpest voltage found; the lens is left there
+    double sharpness = 0.0;                 // its score
+    uint32_t evaluations = 0;               // voltages scored
+    uint32_t frames = 0;                    // frames consumed, including those exposed during a lens move
+    bool converged = false;                 // false if max_frames ran out first
+    chrono::microseconds time_to_focus{0};  // from the start until the lens settled at `voltage`
+} AutofocusResult;
+
+/* Contrast autofocus with the liquid lens. Each candidate voltage is sent
+ * through the camera's control queue, and a frame only counts for it when
+ * it was exposed after the lens settled: its host receive time must be at
+ * least settle_time_us + frame_latency_us past the command's completion.
+ * The camera must be acquiring in pull mode, with the lens serial port set
+ * up and powered. */
+class Autofocus {
+public:
+    Autofocus(Camera &camera, AutofocusConfig config = AutofocusConfig()) :
+        m_camera(camera), m_config(config) {}
+
+    /* Search for the sharpest voltage and leave the lens there.
+     *
+     * @param result Receives the best voltage, its score and the cost of the search.
+     * @return An error if the configuration is invalid or the camera failed, or nullopt
+     *         if successful. Running out of frames is not an error; see result.converged. */
+    optional<CamError> run(AutofocusResult &result);
+
+    /* Score a frame's region of interest with the configured metric. Higher
+     * is sharper; scores are only comparable for one format and region.
+     *
+     * @param frame Any supported mono format.
+     * @param sharpness Receives the score.
+     * @return An error if the format is unsupported or the region lies outside
+     *         the frame, or nullopt if successful. */
+    optional<ConvertError> measure(const FrameBuffer &frame, double &sharpness);
+
+private:
+    optional<CamError> evaluate(double voltage, double &sharpness);
+    optional<CamError> goldenSection();
+    optional<CamError> coarseToFine();
+
+    Camera &m_camera;
+    AutofocusConfig m_config;
+
+    /* Search state of the current run */
+    uint32_t m_frames = 0;
+    uint32_t m_evaluations = 0;
+    bool m_exhausted = false;
+    double m_best_voltage = 0.0;
+    double m_best_sharpness = -1.0;
+
+    /* Reused between frames so scoring does not allocate */
+    vector<uint16_t> m_unpacked;
+    cv::Mat m_dx;
+    cv::Mat m_dy;
+};
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "MappedFile.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+typedef struct BufferPoolConfig {
+    size_t alignment = 64;      // alignment of every buffer, power of two up to the page size
+    bool huge_pages = false;    // back the pool with huge pages when the OS allows it; not for shared pools
+    string shared_name;         // if set, place the pool in shared memory so FramePublisher can hand it to other processes
+} BufferPoolConfig;
+
+/* Arena of equally sized frame buffers carved out of a single page-aligned
+ * allocation. All pages are faulted in at creation so the first frames do not
+ * pay for it. The memory is released when the last owner drops the pool. */
+class BufferPool {
+public:
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /* Allocate a pool.
+     *
+     * @param buffer_size Usable size of each buffer in bytes.
+     * @param count Number of buffers.
+     * @param config Alignment and huge page options.
+     * @return The pool, or nullptr if the alignment is invalid or the allocation failed. */
+    static shared_ptr<BufferPool> create(
+        size_t buffer_size,
+        uint32_t count,
+        const BufferPoolConfig &config = BufferPoolConfig());
+
+    void *buffer(uint32_t index) const {
+        return static_cast<uint8_t*>(m_memory) + static_cast<size_t>(index) * m_slot_size;
+    }
+
+    /* The live shared pool containing `address`, or nullptr if it is not in
+     * one. The pool stays alive as long as the caller holds a frame from it. */
+    static const BufferPool *findShared(const void *address);
+
+    /* Shared memory segment name of a shared pool, for MappedFile::openShared. */
+    const string &sharedName() const { return m_shared_name; }
+
+    /* Byte offset of `address` from the start of the pool. */
+    size_t offsetOf(const void *address) const {
+        return static_cast<size_t>(static_cast<const uint8_t*>(address) - static_cast<const uint8_t*>(m_memory));
+    }
+
+    size_t bufferSize() const { return m_buffer_size; }
+    size_t slotSize() const { return m_slot_size; }
+    uint32_t count() const { return m_count; }
+    bool usesHugePages() const { return m_huge_pages; }
+
+private:
+    BufferPool() = default;
+
+    void *m_memory = nullptr;
+    size_t m_mapped_size = 0;
+    size_t m_buffer_size = 0;
+    size_t m_slot_size = 0;
+    uint32_t m_count = 0;
+    bool m_huge_pages = false;
+    unique_ptr<MappedFile> m_segment;   // backing of a shared pool
+    string m_shared_name;
+};
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "Frame.hpp"
+#include "Stream.hpp"
+
+/* How long the acquisition thread sleeps in the output queue before it
+ * re-checks whether it has been asked to stop. */
+#define STREAM_WORKER_WAKEUP_US 100000
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Borrow, push-mode and latest-frame logic shared by every stream built on a
+ * pair of buffer queues: buffers waiting to be filled, and completed frames
+ * waiting to be consumed. Implementations only provide the queue primitives
+ * below. They must call stopWorker() in their destructor, before tearing
+ * down their queues, since the acquisition thread calls into them. */
+class BufferedStream : public IStream {
+public:
+    optional<StreamError> borrowOldestFrame(FrameBuffer &frame) override;
+    optional<StreamError> borrowNewestFrame(FrameBuffer &frame) override;
+    optional<StreamError> borrowNextNewFrame(FrameBuffer &frame) override;
+    optional<StreamError> borrowOldestFrame(FrameBuffer &frame, chrono::microseconds timeout) override;
+    optional<StreamError> borrowNewestFrame(FrameBuffer &frame, chrono::microseconds timeout) override;
+    optional<StreamError> borrowNextNewFrame(FrameBuffer &frame, chrono::microseconds timeout) override;
+    void releaseFrame(FrameBuffer &frame) override;
+
+    optional<StreamError> registerFrameCallback(FrameCallback callback) override;
+    void unregisterFrameCallback() override;
+    optional<StreamError> setLatestFrameMode(bool enable) override;
+    void setDeliverIncompleteFrames(bool enable) override { m_deliver_incomplete = enable; }
+
+    StreamStats getStreamStats() override;
+
+    /* Note that a software trigger was fired at host time `host_ns`. The next
+     * frame delivered after it is taken as its response, for the trigger
+     * latency statistics. Call once the trigger was accepted, passing the
+     * time taken before it was sent. */
+    void recordTrigger(uint64_t host_ns);
+
+protected:
+    /* Sentinel timeouts accepted by popBuffer */
+    static constexpr chrono::microseconds NO_WAIT = chrono::microseconds::zero();
+    static constexpr chrono::microseconds WAIT_FOREVER = chrono::microseconds::max();
+
+    /* Pop the oldest completed buffer.
+     *
+     * @param timeout How long to wait for one; NO_WAIT or WAIT_FOREVER allowed.
+     * @return The buffer, or nullptr if none arrived in time. */
+    virtual void *popBuffer(chrono::microseconds timeout) = 0;
+
+    /* Hand a buffer back to the queue of buffers waiting to be filled. */
+    virtual void pushBuffer(void *buffer) = 0;
+
+    /* Number of completed buffers waiting to be consumed. */
+    virtual int queuedFrameCount() = 0;
+
+    /* Number of empty buffers waiting to be filled. */
+    virtual int freeBufferCount() = 0;
+
+    /* Fill in the transport counters of `stats` (completed, failures,
+     * underruns and packet counts). */
+    virtual void transportCounters(StreamStats &stats) = 0;
+
+    virtual FrameStatus bufferStatus(void *buffer) = 0;
+
+    /* Host time in ns at which the buffer was completed. */
+    virtual uint64_t bufferCompletedNs(void *buffer) = 0;
+
+    /* Describe a completed buffer, including parent_buffer = buffer. */
+    virtual void fillFrameBuffer(void *buffer, FrameBuffer &frame) = 0;
+
+    bool workerRunning() const { return m_worker_running; }
+    void startWorker();
+    void stopWorker();
+
+    /* Remove the frame parked in the latest-frame slot, if any. */
+    void *takeLatest() { return m_latest.exchange(nullptr); }
+
+    /* Recycle completed frames until at most `keep` remain queued. */
+    void discardQueuedFrames(int keep);
+
+private:
+    /* popBuffer, recording the frame in the statistics */
+    void *takeCompleted(chrono::microseconds timeout);
+    void recordFrame(void *buffer);
+    void countDelivered(void *buffer);
+    void countDiscarded();
+
+    /* Whether a completed buffer should reach the consumer */
+    bool isDeliverable(void *buffer);
+
+    optional<StreamError> populateFrameBuffer(FrameBuffer &frame, chrono::microseconds timeout);
+    void workerLoop();
+
+    void publishLatest(void *buffer);
+    optional<StreamError> borrowLatestFrame(FrameBuffer &frame, bool discard_current, chrono::microseconds timeout);
+
+    thread m_worker;
+    atomic<bool> m_worker_running{false};
+    FrameCallback m_callback;
+    atomic<bool> m_deliver_incomplete{false};
+
+    /* Latest-frame mode. The drainer thread holds the buffer it is publishing,
+     * m_latest holds the most recent completed frame and the consumer holds
+     * the one it borrowed, so exchanging m_latest never blocks either side. */
+    bool m_latest_mode = false;
+    atomic<void*> m_latest{nullptr};
+    atomic<int> m_latest_waiters{0};
+    mutex m_latest_mutex;
+    condition_variable m_latest_cv;
+
+    /* Frame statistics, guarded by m_stats_mutex. Completion times of the
+     * last STREAM_FPS_WINDOW frames are kept in a ring for the fps estimate. */
+    mutex m_stats_mutex;
+    StreamStats m_stats;
+    uint64_t m_frame_times[STREAM_FPS_WINDOW] = {};
+    size_t m_frame_count = 0;
+    double m_mean_interval_ns = 0.0;
+
+    /* Software triggers still waiting for their frame, oldest first */
+    deque<uint64_t> m_trigger_times;
+    double m_trigger_frame_m2 = 0.0;
+    double m_trigger_delivery_m2 = 0.0;
+};
+
+}  // namespace camera
+}  // namespace cynlr
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
 
 #include "Constants.hpp"
 #include "Frame.hpp"
+#include "FrameHandle.hpp"
 #include "Error.hpp"
 #include "CameraBackend.hpp"
+#include "CameraConfig.hpp"
+#include "ControlQueue.hpp"
 
 namespace cynlr {
 namespace camera {
@@ -37,20 +44,95 @@ public:
     optional<CamError> setAcquisitionMode(AcquisitionMode mode);
     optional<CamError> setPixelFormat(PixelFormat format);
     optional<CamError> setBinning(int dx, int dy);
+    optional<CamError> setRegion(int x, int y, int width, int height);
+    optional<CamError> setRegions(const vector<Region> &regions);
     optional<CamError> setGain(double gain);
     optional<CamError> setAutoExposure(bool setAuto);
     optional<CamError> setExposureTime(double exposure_time_us);
     optional<CamError> setFrameRate(double framerate);
+    optional<CamError> enablePtp(bool enable);
+    optional<CamError> setTriggerMode(bool enable);
+    optional<CamError> setTriggerSource(TriggerSource source);
+    optional<CamError> setTriggerActivation(TriggerActivation activation);
+    optional<CamError> setTriggerDelay(double delay_us);
+    optional<CamError> fireSoftwareTrigger();
     optional<CamError> enableLensPower(bool enable);
     optional<CamError> setupLensSerial(const char* baudRate);
     optional<CamError> setLensFocus(double voltage);
+    optional<CamError> setLensResultCheck(bool enable);
+    optional<CamError> checkLensResult();
+    optional<CamError> enableChunks(const vector<ChunkSelector> &chunks);
+
+    /* Queue a focus change on the camera's control thread and return at
+     * once, so frame handling never waits for the serial transaction. A
+     * setpoint still waiting to be sent is replaced by a newer one (its
+     * result is marked superseded), so only the latest voltage goes out.
+     * ControlResult::completed_ns tells when the lens had the command.
+     *
+     * @param voltage Focus voltage, clamped to 24.0–70.0 V.
+     * @return A future for the command's result. */
+    future<ControlResult> setLensFocusAsync(double voltage);
+
+    /* Run any control call on the control thread, after the commands queued
+     * before it. The command runs as a whole: control calls made directly
+     * from other threads wait until it returns.
+     *
+     * @param command Called on the control thread with this camera.
+     * @return A future for the command's result; it rethrows what the command throws. */
+    future<ControlResult> submitControl(function<optional<CamError>(Camera&)> command);
+
+    /* Apply several settings in dependency order (format and geometry,
+     * trigger, exposure, frame rate). A setting the camera already has,
+     * as last written through this Camera, is skipped. Stops at the first
+     * failure.
+     *
+     * @param config The settings to apply; unset fields are left alone.
+     * @param report If given, receives the written/skipped counts and the total time.
+     * @return An error if a setting was rejected, or nullopt if successful. */
+    optional<CamError> applyConfig(const CameraConfig &config, ConfigApplyReport *report = nullptr);
+
     optional<StreamError> borrowOldestFrame(FrameBuffer &frame);
     optional<StreamError> borrowNewestFrame(FrameBuffer &frame);
     optional<StreamError> borrowNextNewFrame(FrameBuffer &frame);
+    optional<StreamError> borrowOldestFrame(FrameBuffer &frame, chrono::microseconds timeout);
+    optional<StreamError> borrowNewestFrame(FrameBuffer &frame, chrono::microseconds timeout);
+    optional<StreamError> borrowNextNewFrame(FrameBuffer &frame, chrono::microseconds timeout);
     void releaseFrame(FrameBuffer &frame);
 
+    /* RAII variants: the frame is released when the handle goes out of scope
+     * or is overwritten, so no releaseFrame call is needed. */
+    optional<StreamError> borrowOldestFrame(FrameHandle &frame);
+    optional<StreamError> borrowNewestFrame(FrameHandle &frame);
+    optional<StreamError> borrowNextNewFrame(FrameHandle &frame);
+    optional<StreamError> borrowOldestFrame(FrameHandle &frame, chrono::microseconds timeout);
+    optional<StreamError> borrowNewestFrame(FrameHandle &frame, chrono::microseconds timeout);
+    optional<StreamError> borrowNextNewFrame(FrameHandle &frame, chrono::microseconds timeout);
+
+    optional<StreamError> registerFrameCallback(FrameCallback callback);
+    void unregisterFrameCallback();
+    optional<StreamError> setLatestFrameMode(bool enable);
+    void setDeliverIncompleteFrames(bool enable);
+    StreamStats getStreamStats();
+
 private:
     unique_ptr<ICameraBackend> m_backend;
+
+    /* Held by every call into the backend, so direct control calls and the
+     * commands on the control thread never reach the device at the same
+     * time. Recursive, as applyConfig and queued commands call the setters. */
+    recursive_mutex m_backend_mutex;
+
+    /* Settings last written successfully, so applyConfig can skip them. A
+     * field is cleared when a write fails or another write may have changed
+     * it on the device (binning resets the region, auto exposure the
+     * exposure, exposure the achievable frame rate). */
+    CameraConfig m_applied;
+
+    /* Started on first use; declared last so queued commands finish
+     * before the backend goes away */
+    ControlQueue &control();
+    once_flag m_control_once;
+    unique_ptr<ControlQueue> m_control;
 };
 
 }  // namespace camera
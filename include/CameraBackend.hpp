@@ -1,6 +1,7 @@
 #pragma once
 
 #include <optional>
+#include <vector>
 
 #include "Error.hpp"
 #include "Constants.hpp"
@@ -12,22 +13,59 @@ namespace camera {
 
 using namespace std;
 
+/* Sensor window in pixels after binning, as the GenICam OffsetX/OffsetY/Width/Height */
+typedef struct Region {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool operator==(const Region&) const = default;
+} Region;
+
 class ICameraBackend {
 public:
+    virtual ~ICameraBackend() = default;
+
     virtual optional<CamError> startAcquisition() = 0;
     virtual optional<CamError> stopAcquisition() = 0;
     virtual optional<CamError> setAcquisitionMode(AcquisitionMode mode) = 0;
     virtual optional<CamError> setPixelFormat(PixelFormat format) = 0;
     virtual optional<CamError> setBinning(int dx, int dy) = 0;
+    virtual optional<CamError> setRegion(int x, int y, int width, int height) = 0;
+    virtual optional<CamError> setRegions(const vector<Region> &regions) = 0;
     virtual optional<CamError> setGain(double gain) = 0;
     virtual optional<CamError> setAutoExposure(bool setAuto) = 0;
     virtual optional<CamError> setExposureTime(double exposure_time_us) = 0;
     virtual optional<CamError> setFrameRate(double framerate) = 0;
+    virtual optional<CamError> enablePtp(bool enable) = 0;
+
+    virtual optional<CamError> setTriggerMode(bool enable) = 0;
+    virtual optional<CamError> setTriggerSource(TriggerSource source) = 0;
+    virtual optional<CamError> setTriggerActivation(TriggerActivation activation) = 0;
+    virtual optional<CamError> setTriggerDelay(double delay_us) = 0;
+    virtual optional<CamError> fireSoftwareTrigger() = 0;
 
     virtual optional<CamError> enableLensPower(bool enable) = 0;
     virtual optional<CamError> setupLensSerial(const char* baudRate) = 0;
     virtual optional<CamError> setLensFocus(double voltage) = 0;
 
+    /* Read the lens link's write result back after every setLensFocus.
+     * Off by default, as it adds a control round trip to each command. */
+    virtual optional<CamError> setLensResultCheck(bool enable) = 0;
+
+    /* Check that the last lens command was written in full, e.g. once
+     * after a focus sweep instead of after every step. */
+    virtual optional<CamError> checkLensResult() = 0;
+
+    /* Have the camera append the given chunks to every frame and parse them
+     * into FrameBuffer::chunks. An empty list turns chunk data off. Set this
+     * before starting the acquisition, as it changes the payload size.
+     *
+     * @param chunks The chunks to turn on; all others are turned off.
+     * @return An error if the camera cannot send one of them, or nullopt if successful. */
+    virtual optional<CamError> enableChunks(const vector<ChunkSelector> &chunks) = 0;
+
     virtual shared_ptr<IStream> getStream() = 0;
 };
 
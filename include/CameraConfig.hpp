@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <utility>
+
+#include "CameraBackend.hpp"
+#include "Constants.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Camera settings applied in one batch by Camera::applyConfig. Unset fields
+ * are left as they are on the camera. */
+typedef struct CameraConfig {
+    optional<AcquisitionMode> acquisition_mode;
+    optional<PixelFormat> pixel_format;
+    optional<pair<int, int>> binning;           // dx, dy
+    optional<Region> region;
+    optional<bool> trigger_mode;
+    optional<TriggerSource> trigger_source;
+    optional<TriggerActivation> trigger_activation;
+    optional<double> trigger_delay_us;
+    optional<bool> auto_exposure;
+    optional<double> exposure_time_us;
+    optional<double> gain;
+    optional<double> frame_rate;
+    optional<bool> ptp;
+} CameraConfig;
+
+typedef struct ConfigApplyReport {
+    int written = 0;                    // settings sent to the camera
+    int skipped = 0;                    // settings the camera already had
+    chrono::microseconds elapsed{0};    // wall time of the whole batch
+} ConfigApplyReport;
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "Camera.hpp"
+#include "CameraBackend.hpp"
+#include "Error.hpp"
+#include "FrameHandle.hpp"
+#include "SpscRing.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Clock the group matches frames on */
+enum class TimestampSource {
+    DEVICE,     // FrameBuffer::timestamp_ns; needs PTP or a shared hardware clock
+    HOST,       // FrameBuffer::system_timestamp_ns; works everywhere, less precise
+};
+
+typedef struct CameraGroupConfig {
+    chrono::nanoseconds tolerance = chrono::microseconds(500);   // max timestamp spread within a set
+    TimestampSource timestamp_source = TimestampSource::HOST;
+    size_t queue_depth = 8;     // frames held per camera while waiting for a match
+} CameraGroupConfig;
+
+/* One time-aligned frame per camera, in the order the cameras were added. */
+typedef struct FrameSet {
+    vector<FrameHandle> frames;
+    uint64_t timestamp_ns = 0;  // earliest matched timestamp in the set
+    uint64_t spread_ns = 0;     // latest minus earliest timestamp
+} FrameSet;
+
+/* Frame set sink, called from the matcher thread. Handles moved out of the
+ * set stay valid; the rest are released when the callback returns. */
+using FrameSetCallback = function<void(FrameSet &set)>;
+
+typedef struct CameraGroupStats {
+    uint64_t sets = 0;              // frame sets delivered
+    vector<uint64_t> unmatched;     // per camera: frames dropped for lack of partners
+    vector<uint64_t> overflows;     // per camera: frames dropped because the matcher fell behind
+} CameraGroupStats;
+
+/* Several cameras acquiring together. Each camera has its own acquisition
+ * thread that borrows frames into a lock-free ring; a single matcher thread
+ * pairs up the heads of the rings whose timestamps lie within the tolerance
+ * and drops frames that are too old to ever be matched. The cameras' streams
+ * must stay in the default pull mode while the group is acquiring. */
+class CameraGroup {
+public:
+    CameraGroup(CameraGroupConfig config = CameraGroupConfig()) : m_config(config) {}
+    ~CameraGroup() { stopAcquisition(); }
+
+    CameraGroup(const CameraGroup&) = delete;
+    CameraGroup& operator=(const CameraGroup&) = delete;
+
+    /* Add a camera. Its index in every FrameSet is size() - 1 after the call.
+     *
+     * @param backend The camera backend; the group takes ownership.
+     * @return An error if the group is acquiring or the backend is null, or nullopt if successful. */
+    optional<CamError> addCamera(unique_ptr<ICameraBackend> backend);
+
+    size_t size() const { return m_members.size(); }
+
+    /* Access a single camera, e.g. for per-camera exposure. */
+    Camera &camera(size_t index) { return *m_members[index]->camera; }
+
+    /* Apply a setting to every camera. Stops at the first failure.
+     *
+     * @return An error if any camera rejected the setting, or nullopt if successful. */
+    optional<CamError> setAcquisitionMode(AcquisitionMode mode);
+    optional<CamError> setPixelFormat(PixelFormat format);
+    optional<CamError> setBinning(int dx, int dy);
+    optional<CamError> setGain(double gain);
+    optional<CamError> setExposureTime(double exposure_time_us);
+    optional<CamError> setFrameRate(double framerate);
+
+    /* Enable PTP on every camera so device timestamps share one clock.
+     * Use with TimestampSource::DEVICE. */
+    optional<CamError> enablePtp(bool enable);
+
+    /* Trigger settings for every camera. With a hardware trigger wired to
+     * all cameras, frames of one trigger share an exposure start. */
+    optional<CamError> setTriggerMode(bool enable);
+    optional<CamError> setTriggerSource(TriggerSource source);
+    optional<CamError> setTriggerActivation(TriggerActivation activation);
+    optional<CamError> setTriggerDelay(double delay_us);
+
+    /* Fire a software trigger on every camera, back to back. */
+    optional<CamError> fireSoftwareTrigger();
+
+    /* Apply a batch of settings to every camera (see Camera::applyConfig).
+     * The cameras are configured in parallel, one thread each, so the
+     * total time is that of the slowest camera rather than the sum.
+     *
+     * @param config The settings to apply; unset fields are left alone.
+     * @param report If given, receives the summed counts and the wall time.
+     * @return The first camera's error if any camera failed, or nullopt if successful. */
+    optional<CamError> applyConfig(const CameraConfig &config, ConfigApplyReport *report = nullptr);
+
+    /* Start every camera and the matcher.
+     *
+     * @param callback Receives each matched frame set.
+     * @return An error if a camera failed to start, or nullopt if successful. */
+    optional<CamError> startAcquisition(FrameSetCallback callback);
+
+    /* Stop the matcher and every camera. Frames still waiting for a match
+     * are released. */
+    optional<CamError> stopAcquisition();
+
+    CameraGroupStats getStats() const;
+
+private:
+    typedef struct Member {
+        unique_ptr<Camera> camera;
+        unique_ptr<SpscRing<FrameHandle>> ring;
+        thread acquisition;
+        atomic<uint64_t> unmatched{0};
+        atomic<uint64_t> overflows{0};
+    } Member;
+
+    optional<CamError> applyAll(const function<optional<CamError>(Camera&)> &setter);
+    void acquisitionLoop(Member &member);
+    void matcherLoop();
+    uint64_t timestampOf(const FrameHandle &frame) const;
+
+    CameraGroupConfig m_config;
+    vector<unique_ptr<Member>> m_members;
+    FrameSetCallback m_callback;
+
+    thread m_matcher;
+    atomic<bool> m_running{false};
+    atomic<uint64_t> m_sets{0};
+
+    /* Bumped by the acquisition threads after each push; the matcher
+     * sleeps on it when some camera has nothing queued */
+    atomic<uint32_t> m_arrivals{0};
+};
+
+}  // namespace camera
+}  // namespace cynlr
@@ -1,5 +1,8 @@
 #pragma once
 
+/* Stream buffers a backend allocates unless told otherwise */
+#define DEFAULT_NUM_BUFFERS 10
+
 namespace cynlr {
 namespace camera {
 
@@ -9,14 +12,45 @@ enum class AcquisitionMode {
     ACQUISITION_MODE_MULTI_FRAME = 2,
 };
 
+enum class TriggerSource {
+    SOFTWARE = 0,
+    LINE0 = 1,
+    LINE1 = 2,
+    LINE2 = 3,
+    LINE3 = 4,
+};
+
+enum class TriggerActivation {
+    RISING_EDGE = 0,
+    FALLING_EDGE = 1,
+    ANY_EDGE = 2,
+    LEVEL_HIGH = 3,
+    LEVEL_LOW = 4,
+};
+
 enum class PixelFormat {
+    UNKNOWN = -1,
     MONO8 = 0,
     MONO10 = 1,
     MONO12 = 2,
     MONO14 = 3,
     MONO16 = 4,
+    MONO10P = 5,            // PFNC Mono10p: 4 pixels in 5 bytes, LSB first
+    MONO12P = 6,            // PFNC Mono12p: 2 pixels in 3 bytes, LSB first
+    MONO10_PACKED = 7,      // GigE Vision Mono10Packed: 2 pixels in 3 bytes
+    MONO12_PACKED = 8,      // GigE Vision Mono12Packed: 2 pixels in 3 bytes
     // TODO : many more to add
 };
 
+/* Per-frame values the camera can append to each buffer as GenICam chunks */
+enum class ChunkSelector {
+    EXPOSURE_TIME = 0,
+    GAIN = 1,
+    TIMESTAMP = 2,
+    FRAME_ID = 3,
+    LINE_STATUS_ALL = 4,    // I/O line levels when the frame was exposed, one bit per line
+    COUNTER_VALUE = 5,      // value of the counter selected with CounterSelector
+};
+
 }
 }
\ No newline at end of file
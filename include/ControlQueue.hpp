@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "Error.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Outcome of a queued control command. Times are host wall-clock ns, on the
+ * same base as FrameBuffer::system_timestamp_ns, so a completion can be
+ * compared with frame arrival times. */
+typedef struct ControlResult {
+    optional<CamError> error;
+    bool superseded = false;    // replaced by a newer command with the same key before it was sent
+    uint64_t queued_ns = 0;     // when the command was submitted
+    uint64_t started_ns = 0;    // when the control thread began sending it; 0 if superseded
+    uint64_t completed_ns = 0;  // when the device had accepted it; 0 if superseded
+} ControlResult;
+
+using ControlCommand = function<optional<CamError>()>;
+
+/* Runs device control commands in submission order on a dedicated thread,
+ * so a slow control transaction never blocks the caller. A command with a
+ * coalesce key replaces one with the same key that is still waiting at the
+ * back of the queue, so a burst of setpoints only sends the latest. */
+class ControlQueue {
+public:
+    ControlQueue();
+
+    /* Runs the commands still queued, then stops the thread. */
+    ~ControlQueue();
+
+    ControlQueue(const ControlQueue&) = delete;
+    ControlQueue& operator=(const ControlQueue&) = delete;
+
+    /* Queue a command.
+     *
+     * @param command Called on the control thread.
+     * @param coalesce_key If not nullptr, commands with an equal key may replace each other.
+     * @return A future that becomes ready when the command ran or was superseded.
+     *         If the command throws, get() rethrows the exception. */
+    future<ControlResult> submit(ControlCommand command, const char *coalesce_key = nullptr);
+
+    /* Commands waiting to be sent, not counting the one being sent. */
+    size_t pending();
+
+private:
+    typedef struct Entry {
+        ControlCommand command;
+        const char *coalesce_key = nullptr;
+        uint64_t queued_ns = 0;
+        promise<ControlResult> result;
+    } Entry;
+
+    void controlLoop();
+
+    mutex m_mutex;
+    condition_variable m_cv;
+    deque<Entry> m_queue;
+    bool m_running = true;
+    thread m_thread;
+};
+
+}  // namespace camera
+}  // namespace cynlr
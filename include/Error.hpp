@@ -4,6 +4,20 @@ typedef struct CamError {
     const char *message;
 } CamError;
 
+enum class StreamErrorCode {
+    FAILED = 0,
+    TIMEOUT = 1,    // no frame arrived within the requested timeout
+};
+
 typedef struct StreamError {
     const char *message;
-} StreamError;
\ No newline at end of file
+    StreamErrorCode code = StreamErrorCode::FAILED;
+} StreamError;
+
+typedef struct ConvertError {
+    const char *message;
+} ConvertError;
+
+typedef struct RecordError {
+    const char *message;
+} RecordError;
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "Constants.hpp"
+
 extern "C" {
     #include <arv.h>
 }
@@ -7,12 +14,58 @@ extern "C" {
 namespace cynlr {
 namespace camera {
 
+/* Completion status of a stream buffer, mirroring ArvBufferStatus */
+enum class FrameStatus {
+    UNKNOWN = -1,
+    SUCCESS = 0,
+    CLEARED = 1,
+    TIMEOUT = 2,
+    MISSING_PACKETS = 3,
+    WRONG_PACKET_ID = 4,
+    SIZE_MISMATCH = 5,
+    FILLING = 6,
+    ABORTED = 7,
+    PAYLOAD_NOT_SUPPORTED = 8,
+};
+
+/* Number of FrameStatus values, UNKNOWN included */
+#define FRAME_STATUS_COUNT 10
+
+/* Host wall-clock time in ns, on the same base as FrameBuffer::system_timestamp_ns. */
+inline uint64_t hostTimeNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+/* Chunk data the camera sent with a frame. Only the chunks turned on with
+ * enableChunks are filled in; the rest stay empty, as do all of them when the
+ * buffer carried no chunk data. */
+typedef struct FrameChunks {
+    std::optional<double> exposure_time_us;
+    std::optional<double> gain;
+    std::optional<uint64_t> timestamp;          // device clock ticks, ns on most cameras
+    std::optional<uint64_t> frame_id;
+    std::optional<uint64_t> line_status_all;    // bit n is the level of line n
+    std::optional<uint64_t> counter_value;
+} FrameChunks;
+
 typedef struct FrameBuffer {
     void *parent_buffer = nullptr;
     void *data = nullptr;
     int width = 0;
     int height = 0;
     int channels = 0;
+
+    int offset_x = 0;                   // region origin on the sensor, in pixels
+    int offset_y = 0;
+    size_t stride = 0;                  // bytes per row, including padding; 0 when packed rows are not byte aligned (one bit stream)
+    size_t payload_size = 0;            // bytes of valid data behind `data`
+    PixelFormat pixel_format = PixelFormat::UNKNOWN;
+    uint64_t frame_id = 0;              // device frame counter, gaps mean dropped frames
+    uint64_t timestamp_ns = 0;          // device timestamp
+    uint64_t system_timestamp_ns = 0;   // host wall-clock time the transport received the frame
+    FrameStatus status = FrameStatus::UNKNOWN;  // anything but SUCCESS marks an incomplete frame
+    FrameChunks chunks;                 // settings the frame was taken with, see enableChunks
 } FrameBuffer;
 
 }  // namespace camera
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "Constants.hpp"
+#include "FrameHandle.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+class FrameFanout;
+
+/* Copyable, reference-counted view of a frame shared by several consumers.
+ * Copies are cheap (an atomic increment) and alias the same stream buffer;
+ * the frame goes back to its stream when the last reference is dropped.
+ * Each reference is attributed to one consumer of its FrameFanout, or to
+ * none for the producer's own reference. Frame data must not be modified. */
+class SharedFrame {
+public:
+    SharedFrame() = default;
+    ~SharedFrame() { reset(); }
+
+    SharedFrame(const SharedFrame &other);
+    SharedFrame& operator=(const SharedFrame &other);
+    SharedFrame(SharedFrame &&other) noexcept;
+    SharedFrame& operator=(SharedFrame &&other) noexcept;
+
+    bool valid() const { return m_block != nullptr; }
+    explicit operator bool() const { return valid(); }
+
+    const FrameBuffer &frame() const;
+    const FrameBuffer *operator->() const { return &frame(); }
+
+    /* Views as in FrameHandle, valid while this reference is held. */
+    cv::Mat mat() const;
+    span<const uint8_t> bytes() const;
+
+    /* Consumer this reference counts against, or -1 for none. */
+    int consumer() const { return m_consumer; }
+
+    /* References to the frame across all consumers. */
+    uint32_t useCount() const;
+
+    /* Drop this reference. */
+    void reset();
+
+private:
+    friend class FrameFanout;
+
+    struct Block;
+
+    SharedFrame(Block *block, int consumer) : m_block(block), m_consumer(consumer) {}
+
+    Block *m_block = nullptr;
+    int m_consumer = -1;
+};
+
+typedef struct FanoutConsumer {
+    string name;                // for statistics
+    uint32_t max_held = 0;      // references the consumer may hold at once, 0 for no limit
+} FanoutConsumer;
+
+typedef struct FanoutConsumerStats {
+    string name;
+    uint32_t held = 0;          // references held right now
+    uint32_t peak_held = 0;     // most references held at once
+    uint64_t retained = 0;      // references handed out
+    uint64_t refused = 0;       // references refused because max_held was reached
+} FanoutConsumerStats;
+
+typedef struct FanoutStats {
+    uint64_t shared = 0;        // frames shared
+    uint32_t in_flight = 0;     // frames not yet back in their stream
+    uint64_t exhausted = 0;     // frames released at once because every slot was in use
+    vector<FanoutConsumerStats> consumers;
+} FanoutStats;
+
+/* Hands one borrowed frame to several consumer threads without copying it.
+ * The producer wraps each frame with share() and gives every consumer its
+ * own reference with retain(); the stream buffer is released when the
+ * last reference goes. Per-consumer limits keep one slow consumer from
+ * holding every stream buffer, and the statistics show which consumer
+ * holds how many. Reference blocks are preallocated, so sharing a frame
+ * does not allocate. The fanout must outlive every SharedFrame it made. */
+class FrameFanout {
+public:
+    /* @param consumers Consumers, indexed in order from 0.
+     * @param capacity Frames that can be shared at once; at least the stream's buffer count. */
+    FrameFanout(vector<FanoutConsumer> consumers, uint32_t capacity = DEFAULT_NUM_BUFFERS);
+    ~FrameFanout();
+
+    FrameFanout(const FrameFanout&) = delete;
+    FrameFanout& operator=(const FrameFanout&) = delete;
+
+    /* Take ownership of a frame for sharing.
+     *
+     * @param frame The borrowed frame.
+     * @return The producer's reference, or an empty SharedFrame (and the frame
+     *         released) if `frame` is empty or `capacity` frames are already shared. */
+    SharedFrame share(FrameHandle &&frame);
+
+    /* A new reference to `frame` held by `consumer`.
+     *
+     * @param frame Any reference to the frame.
+     * @param consumer Consumer index.
+     * @return The reference, or an empty SharedFrame if the consumer is at its limit. */
+    SharedFrame retain(const SharedFrame &frame, size_t consumer);
+
+    size_t consumerCount() const { return m_consumers.size(); }
+
+    FanoutStats getStats() const;
+
+private:
+    friend class SharedFrame;
+
+    typedef struct ConsumerState {
+        FanoutConsumer config;
+        atomic<uint32_t> held{0};
+        atomic<uint32_t> peak_held{0};
+        atomic<uint64_t> retained{0};
+        atomic<uint64_t> refused{0};
+    } ConsumerState;
+
+    void addReference(SharedFrame::Block *block, int consumer);
+    void dropReference(SharedFrame::Block *block, int consumer);
+
+    vector<unique_ptr<ConsumerState>> m_consumers;
+    vector<unique_ptr<SharedFrame::Block>> m_blocks;
+
+    /* Blocks not in use, guarded by m_free_mutex */
+    mutable mutex m_free_mutex;
+    vector<SharedFrame::Block*> m_free;
+
+    atomic<uint64_t> m_shared{0};
+    atomic<uint64_t> m_exhausted{0};
+};
+
+/* Defined here so SharedFrame can reach the frame without a call */
+struct SharedFrame::Block {
+    FrameHandle handle;
+    atomic<uint32_t> refs{0};
+    FrameFanout *owner = nullptr;
+};
+
+inline const FrameBuffer &SharedFrame::frame() const {
+    return m_block->handle.frame();
+}
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include <opencv2/opencv.hpp>
+
+#include "Frame.hpp"
+#include "Stream.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Move-only owner of a borrowed frame. The frame is handed back to its
+ * stream when the handle is destroyed, reset or overwritten, so every borrow
+ * is released exactly once. All views alias the stream buffer and are only
+ * valid while the handle owns the frame. */
+class FrameHandle {
+public:
+    FrameHandle() = default;
+
+    /* Take ownership of a frame borrowed from `stream`.
+     *
+     * @param stream The stream the frame was borrowed from.
+     * @param frame The borrowed frame. */
+    FrameHandle(shared_ptr<IStream> stream, const FrameBuffer &frame) :
+        m_stream(move(stream)), m_frame(frame) {}
+
+    ~FrameHandle() { reset(); }
+
+    FrameHandle(const FrameHandle&) = delete;
+    FrameHandle& operator=(const FrameHandle&) = delete;
+    FrameHandle(FrameHandle &&other) noexcept;
+    FrameHandle& operator=(FrameHandle &&other) noexcept;
+
+    bool valid() const { return m_stream != nullptr; }
+    explicit operator bool() const { return valid(); }
+
+    const FrameBuffer &frame() const { return m_frame; }
+    const FrameBuffer *operator->() const { return &m_frame; }
+
+    /* OpenCV view with the frame's stride: CV_8UC1 for MONO8, CV_16UC1 for
+     * MONO10/12/14/16. Packed formats have no direct Mat layout and yield an
+     * empty Mat; unpack them with PixelConvert.hpp instead. */
+    cv::Mat mat() const;
+
+    /* Raw payload bytes. */
+    span<const uint8_t> bytes() const;
+
+    /* One row of raw bytes, `stride` long. Empty when the stride is 0, as
+     * rows of a bit-stream frame do not start on a byte boundary. */
+    span<const uint8_t> row(int y) const;
+
+    /* Pixels of a 16-bit container format (MONO10/12/14/16), including any
+     * row padding. Empty for other formats. */
+    span<const uint16_t> pixels16() const;
+
+    /* Release the frame back to its stream now. */
+    void reset();
+
+    /* Give up ownership without releasing; the caller becomes responsible
+     * for calling releaseFrame. */
+    FrameBuffer detach();
+
+private:
+    shared_ptr<IStream> m_stream;
+    FrameBuffer m_frame;
+};
+
+}  // namespace camera
+}  // namespace cynlr
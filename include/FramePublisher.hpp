@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "FrameHandle.hpp"
+#include "MappedFile.hpp"
+#include "SharedFrames.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+typedef struct FramePublisherConfig {
+    string name;                // segment name subscribers open (letters, digits, '-', '_', '.')
+    uint32_t hold_frames = 4;   // newest frames kept from the stream so subscribers can read them
+} FramePublisherConfig;
+
+typedef struct FramePublisherStats {
+    uint64_t published = 0;     // frames announced to subscribers
+    uint64_t rejected = 0;      // frames not in a shared BufferPool, or empty handles
+} FramePublisherStats;
+
+/* Shares one camera's frames with other processes without copying them.
+ * The camera's buffer pool must live in shared memory: set
+ * BufferPoolConfig::shared_name when creating the backend. Each published
+ * frame is announced in a lock-free ring that any number of FrameSubscriber
+ * processes read, and kept out of the stream until `hold_frames` newer
+ * frames have been published; that bounds how long subscribers can look at
+ * it. The stream therefore needs more than `hold_frames` buffers.
+ * Publishing never waits for subscribers: one that falls behind skips
+ * frames. publish() must be called from one thread at a time. */
+class FramePublisher {
+public:
+    ~FramePublisher();
+
+    FramePublisher(const FramePublisher&) = delete;
+    FramePublisher& operator=(const FramePublisher&) = delete;
+
+    /* Create the shared segment.
+     *
+     * @param config Segment name and hold depth.
+     * @return The publisher, or nullptr if the name is taken or invalid. */
+    static unique_ptr<FramePublisher> create(const FramePublisherConfig &config);
+
+    /* Announce a frame to subscribers and take ownership of it. Returns at once.
+     *
+     * @param frame A frame from a stream with a shared buffer pool.
+     * @return False if the frame was rejected, in which case it is released. */
+    bool publish(FrameHandle &&frame);
+
+    FramePublisherStats getStats() const;
+
+private:
+    FramePublisher(const FramePublisherConfig &config, unique_ptr<MappedFile> segment);
+
+    FramePublisherConfig m_config;
+    unique_ptr<MappedFile> m_segment;
+    PublisherHeader *m_header = nullptr;
+    PublishedFrame *m_ring = nullptr;
+
+    /* Published frames still out of the stream, oldest first, with their numbers */
+    deque<pair<uint64_t, FrameHandle>> m_held;
+
+    atomic<uint64_t> m_published{0};
+    atomic<uint64_t> m_rejected{0};
+};
+
+}  // namespace camera
+}  // namespace cynlr
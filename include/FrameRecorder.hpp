@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "Error.hpp"
+#include "FrameHandle.hpp"
+#include "MappedFile.hpp"
+#include "Recording.hpp"
+#include "SpscRing.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+typedef struct FrameRecorderConfig {
+    string path;                            // recording file, overwritten if it exists
+    uint64_t max_frames = 100000;           // index entries reserved
+    uint64_t max_bytes = 4ull << 30;        // payload space reserved
+    size_t queue_depth = 4;                 // frames waiting for the writer; each holds a stream buffer
+} FrameRecorderConfig;
+
+typedef struct FrameRecorderStats {
+    uint64_t submitted = 0;     // frames passed to submit()
+    uint64_t written = 0;       // frames in the file
+    uint64_t dropped = 0;       // frames rejected because the writer was behind
+    uint64_t skipped = 0;       // frames rejected because the file was full
+    uint64_t bytes = 0;         // payload bytes written
+} FrameRecorderStats;
+
+/* Records frames into a preallocated, memory-mapped file (see Recording.hpp).
+ * submit() only moves the frame handle into a lock-free ring, so the
+ * acquisition thread never waits on the disk; a writer thread copies each
+ * payload into the mapping and then releases the frame to its stream. When
+ * the ring is full the frame is released at once and counted as dropped.
+ *
+ * Queued frames keep their stream buffers, so queue_depth must stay below
+ * the stream's buffer count or the stream will run out of buffers itself. */
+class FrameRecorder {
+public:
+    ~FrameRecorder() { close(); }
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    /* Create the recording file and start the writer.
+     *
+     * @param config File path, capacity and queue depth.
+     * @return The recorder, or nullptr if the file could not be created. */
+    static unique_ptr<FrameRecorder> create(const FrameRecorderConfig &config);
+
+    /* Queue a frame for writing. Must always be called from the same
+     * thread. Never blocks.
+     *
+     * @param frame The frame; the recorder takes it over in any case.
+     * @return True if the frame was queued, false if it was dropped. */
+    bool submit(FrameHandle &&frame);
+
+    /* Write out the queued frames, stop the writer and trim the file to
+     * the data actually recorded. Further submits are dropped.
+     *
+     * @return An error if the file could not be finalized, or nullopt if successful. */
+    optional<RecordError> close();
+
+    FrameRecorderStats getStats() const;
+
+private:
+    FrameRecorder(const FrameRecorderConfig &config, unique_ptr<MappedFile> file);
+
+    void writerLoop();
+    void writeFrame(const FrameBuffer &frame);
+
+    FrameRecorderConfig m_config;
+    unique_ptr<MappedFile> m_file;
+    RecordingHeader *m_header = nullptr;
+    RecordingIndexEntry *m_index = nullptr;
+
+    SpscRing<FrameHandle> m_ring;
+    thread m_writer;
+    atomic<bool> m_running{false};
+
+    /* Bumped after each submit; the writer sleeps on it while the ring is empty */
+    atomic<uint32_t> m_submits{0};
+
+    atomic<uint64_t> m_submitted{0};
+    atomic<uint64_t> m_written{0};
+    atomic<uint64_t> m_dropped{0};
+    atomic<uint64_t> m_skipped{0};
+    atomic<uint64_t> m_bytes{0};
+};
+
+}  // namespace camera
+}  // namespace cynlr
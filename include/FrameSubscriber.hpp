@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BufferedStream.hpp"
+#include "Constants.hpp"
+#include "MappedFile.hpp"
+#include "SharedFrames.hpp"
+
+/* Polling interval while waiting for frames where the platform has no
+ * cross-process futex (everything but Linux) */
+#define SUBSCRIBER_POLL_US 200
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Stream of the frames a FramePublisher in another process shares. Frames
+ * are mapped read-only straight from the camera's shared buffer pool, so
+ * nothing is copied, and are borrowed and released like frames of any
+ * other stream. The buffers are only descriptors; their count bounds how
+ * many frames can be borrowed at once.
+ *
+ * The subscriber never holds up the publisher. Frames it was too slow to
+ * take are skipped and counted as underruns, and show as gaps in
+ * frame_id. A borrowed frame is only guaranteed intact while the publisher
+ * holds it (see FramePublisherConfig::hold_frames); isCurrent tells
+ * whether that is still the case. */
+class FrameSubscriber : public BufferedStream {
+public:
+    ~FrameSubscriber();
+
+    /* Attach to a publisher. Only frames published from now on are seen.
+     *
+     * @param name The publisher's segment name.
+     * @param buffer_count Number of frames that can be borrowed at once.
+     * @return The subscriber, or nullptr if there is no such publisher. */
+    static shared_ptr<FrameSubscriber> create(const string &name, uint32_t buffer_count = DEFAULT_NUM_BUFFERS);
+
+    /* Whether a frame borrowed from this subscriber is still intact. Check
+     * it after processing: once it returns false the publisher has handed
+     * the buffer back to the camera and the data may have been overwritten
+     * while it was read. */
+    bool isCurrent(const FrameBuffer &frame) const;
+
+    /* Whether the publisher has shut down; no more frames will arrive. */
+    bool publisherClosed() const;
+
+protected:
+    void *popBuffer(chrono::microseconds timeout) override;
+    void pushBuffer(void *buffer) override;
+    int queuedFrameCount() override;
+    int freeBufferCount() override;
+    void transportCounters(StreamStats &stats) override;
+    FrameStatus bufferStatus(void *buffer) override;
+    uint64_t bufferCompletedNs(void *buffer) override;
+    void fillFrameBuffer(void *buffer, FrameBuffer &frame) override;
+
+private:
+    typedef struct SubscriberBuffer {
+        uint64_t number = 0;        // publisher's frame number
+        FrameBuffer frame;          // copy of the descriptor, data pointing into the pool mapping
+    } SubscriberBuffer;
+
+    FrameSubscriber(unique_ptr<MappedFile> segment, uint32_t buffer_count);
+
+    void *takeNext();
+    bool readDescriptor(uint64_t number, SubscriberBuffer &buffer);
+    const MappedFile *mapSegment(const char *name);
+    void waitForFrame(uint32_t seen, chrono::microseconds timeout);
+
+    unique_ptr<MappedFile> m_segment;
+    PublisherHeader *m_header = nullptr;
+    const PublishedFrame *m_ring = nullptr;
+
+    /* Descriptors and read position, guarded by m_mutex */
+    mutex m_mutex;
+    vector<unique_ptr<SubscriberBuffer>> m_buffers;
+    deque<SubscriberBuffer*> m_free;
+    uint64_t m_next = 0;            // next frame number to take
+    unordered_map<string, unique_ptr<MappedFile>> m_pools;
+
+    atomic<uint64_t> m_completed{0};
+    atomic<uint64_t> m_failures{0};
+    atomic<uint64_t> m_missed{0};
+};
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "FrameHandle.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* What submit() does when every worker queue is full */
+enum class BackpressurePolicy {
+    BLOCK,          // wait for room; the stream's buffers absorb the delay
+    DROP_OLDEST,    // release the oldest queued frame to make room
+    DROP_NEWEST,    // release the submitted frame
+};
+
+typedef struct FrameWorkerPoolConfig {
+    uint32_t workers = 4;
+    size_t queue_depth = 2;     // frames queued per worker, besides the one it is processing
+    BackpressurePolicy backpressure = BackpressurePolicy::DROP_OLDEST;
+    bool ordered = false;       // deliver results in submission order instead of completion order
+} FrameWorkerPoolConfig;
+
+typedef struct FrameWorkerPoolStats {
+    uint64_t submitted = 0;
+    uint64_t processed = 0;
+    uint64_t dropped = 0;           // frames released unprocessed by the backpressure policy
+    uint64_t stolen = 0;            // frames a worker took from another worker's queue
+    uint64_t delivered = 0;
+    size_t peak_reorder = 0;        // most results waiting for an earlier one (ordered mode)
+    vector<uint64_t> per_worker;    // frames processed by each worker
+} FrameWorkerPoolStats;
+
+/* Spreads frames over worker threads. Frames are dealt round-robin to
+ * per-worker queues; an idle worker steals from the others, so one slow
+ * frame does not hold up the ones behind it. Results go to a single
+ * output thread, which calls `deliver` one at a time: in completion order,
+ * or, with `ordered`, in submission order, skipping frames that were
+ * dropped. Each frame is released once `process` returns, unless
+ * `process` moves it out of the handle (e.g. into its Result).
+ *
+ * submit() must be called from one thread at a time.
+ *
+ * @tparam Result Value `process` returns for each frame; must be movable. */
+template <typename Result>
+class FrameWorkerPool {
+public:
+    using Process = function<Result(FrameHandle &frame)>;
+    using Deliver = function<void(uint64_t frame_id, Result &result)>;
+
+    /* Start the workers and the output thread.
+     *
+     * @param config Worker count, queue depth, backpressure and ordering.
+     * @param process Called on a worker thread for each frame.
+     * @param deliver Called on the output thread for each result. */
+    FrameWorkerPool(FrameWorkerPoolConfig config, Process process, Deliver deliver) :
+        m_config(config), m_process(move(process)), m_deliver(move(deliver))
+    {
+        if (m_config.workers == 0) {
+            m_config.workers = 1;
+        }
+        if (m_config.queue_depth == 0) {
+            m_config.queue_depth = 1;
+        }
+        m_queues.resize(m_config.workers);
+        m_per_worker.resize(m_config.workers, 0);
+
+        m_output = thread(&FrameWorkerPool::outputLoop, this);
+        for (uint32_t i = 0; i < m_config.workers; i++) {
+            m_workers.emplace_back(&FrameWorkerPool::workerLoop, this, i);
+        }
+    }
+
+    ~FrameWorkerPool() { stop(); }
+
+    FrameWorkerPool(const FrameWorkerPool&) = delete;
+    FrameWorkerPool& operator=(const FrameWorkerPool&) = delete;
+
+    /* Queue a frame for processing.
+     *
+     * @param frame The borrowed frame; the pool takes ownership.
+     * @return False if the frame was released instead: the pool is stopped,
+     *         or DROP_NEWEST found every queue full. */
+    bool submit(FrameHandle &&frame) {
+        Job job { move(frame), 0 };
+        if (!job.frame.valid()) {
+            return false;
+        }
+
+        unique_lock<mutex> lock(m_mutex);
+        if (m_stopping) {
+            return false;
+        }
+        m_submitted++;
+
+        size_t worker = pickQueue();
+        if (worker == NO_QUEUE) {
+            switch (m_config.backpressure) {
+                case BackpressurePolicy::BLOCK:
+                    m_space_cv.wait(lock, [&] { return m_stopping || (worker = pickQueue()) != NO_QUEUE; });
+                    if (m_stopping) {
+                        return false;
+                    }
+                    break;
+                case BackpressurePolicy::DROP_OLDEST:
+                    worker = dropOldest();
+                    break;
+                case BackpressurePolicy::DROP_NEWEST:
+                    m_dropped++;
+                    return false;
+            }
+        }
+
+        job.sequence = m_next_sequence++;
+        m_queues[worker].push_back(move(job));
+        m_next_queue = (worker + 1) % m_queues.size();
+        lock.unlock();
+        m_work_cv.notify_all();
+        return true;
+    }
+
+    /* Finish the queued frames, deliver their results and join all threads. */
+    void stop() {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (m_stopping && m_workers.empty()) {
+                return;
+            }
+            m_stopping = true;
+        }
+        m_work_cv.notify_all();
+        m_space_cv.notify_all();
+        for (thread &worker : m_workers) {
+            worker.join();
+        }
+        m_workers.clear();
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_workers_done = true;
+        }
+        m_result_cv.notify_all();
+        if (m_output.joinable()) {
+            m_output.join();
+        }
+    }
+
+    FrameWorkerPoolStats getStats() {
+        lock_guard<mutex> lock(m_mutex);
+        FrameWorkerPoolStats stats;
+        stats.submitted = m_submitted;
+        stats.processed = m_processed;
+        stats.dropped = m_dropped;
+        stats.stolen = m_stolen;
+        stats.delivered = m_delivered;
+        stats.peak_reorder = m_peak_reorder;
+        stats.per_worker = m_per_worker;
+        return stats;
+    }
+
+private:
+    static constexpr size_t NO_QUEUE = static_cast<size_t>(-1);
+
+    typedef struct Job {
+        FrameHandle frame;
+        uint64_t sequence = 0;          // submission order
+    } Job;
+
+    typedef struct Completed {
+        uint64_t frame_id = 0;
+        optional<Result> result;        // empty for a dropped frame
+    } Completed;
+
+    /* Next queue with room, round-robin. Called with m_mutex held. */
+    size_t pickQueue() {
+        for (size_t i = 0; i < m_queues.size(); i++) {
+            size_t worker = (m_next_queue + i) % m_queues.size();
+            if (m_queues[worker].size() < m_config.queue_depth) {
+                return worker;
+            }
+        }
+        return NO_QUEUE;
+    }
+
+    /* Release the oldest queued frame; return the queue it left room in.
+     * Called with m_mutex held and every queue full. */
+    size_t dropOldest() {
+        size_t oldest = 0;
+        for (size_t i = 1; i < m_queues.size(); i++) {
+            if (m_queues[i].front().sequence < m_queues[oldest].front().sequence) {
+                oldest = i;
+            }
+        }
+
+        Job job = move(m_queues[oldest].front());
+        m_queues[oldest].pop_front();
+        m_dropped++;
+        if (m_config.ordered) {
+            /* The output thread must not wait for it */
+            m_reorder.emplace(job.sequence, Completed { job.frame->frame_id, nullopt });
+            m_result_cv.notify_one();
+        }
+        /* job.frame is released when it goes out of scope */
+        return oldest;
+    }
+
+    /* Take the next job for `worker`, stealing if its own queue is empty.
+     * Called with m_mutex held. */
+    bool takeJob(size_t worker, Job &job) {
+        if (!m_queues[worker].empty()) {
+            job = move(m_queues[worker].front());
+            m_queues[worker].pop_front();
+            return true;
+        }
+
+        /* Steal the oldest waiting frame, to keep results close to frame order */
+        size_t victim = NO_QUEUE;
+        for (size_t i = 0; i < m_queues.size(); i++) {
+            if (!m_queues[i].empty()
+                && (victim == NO_QUEUE || m_queues[i].front().sequence < m_queues[victim].front().sequence)) {
+                victim = i;
+            }
+        }
+        if (victim == NO_QUEUE) {
+            return false;
+        }
+        job = move(m_queues[victim].front());
+        m_queues[victim].pop_front();
+        m_stolen++;
+        return true;
+    }
+
+    void workerLoop(size_t worker) {
+        unique_lock<mutex> lock(m_mutex);
+        while (true) {
+            Job job;
+            m_work_cv.wait(lock, [&] { return takeJob(worker, job) || m_stopping; });
+            if (!job.frame.valid()) {
+                /* Stopping and nothing left to do */
+                break;
+            }
+            lock.unlock();
+            m_space_cv.notify_one();
+
+            uint64_t frame_id = job.frame->frame_id;
+            Result result = m_process(job.frame);
+            job.frame.reset();
+
+            lock.lock();
+            m_processed++;
+            m_per_worker[worker]++;
+            if (m_config.ordered) {
+                m_reorder.emplace(job.sequence, Completed { frame_id, move(result) });
+                m_peak_reorder = max(m_peak_reorder, m_reorder.size());
+            } else {
+                m_results.push_back(Completed { frame_id, move(result) });
+            }
+            m_result_cv.notify_one();
+        }
+    }
+
+    /* Pop the next result to deliver, if one is ready. Called with m_mutex held. */
+    bool nextResult(Completed &completed) {
+        if (!m_config.ordered) {
+            if (m_results.empty()) {
+                return false;
+            }
+            completed = move(m_results.front());
+            m_results.pop_front();
+            return true;
+        }
+
+        auto first = m_reorder.begin();
+        if (first == m_reorder.end() || first->first != m_next_delivery) {
+            return false;
+        }
+        completed = move(first->second);
+        m_reorder.erase(first);
+        m_next_delivery++;
+        return true;
+    }
+
+    void outputLoop() {
+        unique_lock<mutex> lock(m_mutex);
+        while (true) {
+            Completed completed;
+            bool ready = false;
+            m_result_cv.wait(lock, [&] { return (ready = nextResult(completed)) || m_workers_done; });
+            if (!ready) {
+                /* Workers are done and every result has been delivered */
+                break;
+            }
+            if (!completed.result.has_value()) {
+                /* A dropped frame: nothing to deliver */
+                continue;
+            }
+
+            lock.unlock();
+            m_deliver(completed.frame_id, *completed.result);
+            lock.lock();
+            m_delivered++;
+        }
+    }
+
+    FrameWorkerPoolConfig m_config;
+    Process m_process;
+    Deliver m_deliver;
+
+    /* Queues, results and counters, guarded by m_mutex */
+    mutex m_mutex;
+    condition_variable m_work_cv;       // jobs queued, or stopping
+    condition_variable m_space_cv;      // room freed in some queue
+    condition_variable m_result_cv;     // results ready, or workers done
+    vector<deque<Job>> m_queues;
+    size_t m_next_queue = 0;
+    uint64_t m_next_sequence = 0;
+    deque<Completed> m_results;         // unordered mode
+    map<uint64_t, Completed> m_reorder; // ordered mode, by sequence
+    uint64_t m_next_delivery = 0;
+    bool m_stopping = false;
+    bool m_workers_done = false;
+
+    uint64_t m_submitted = 0;
+    uint64_t m_processed = 0;
+    uint64_t m_dropped = 0;
+    uint64_t m_stolen = 0;
+    uint64_t m_delivered = 0;
+    size_t m_peak_reorder = 0;
+    vector<uint64_t> m_per_worker;
+
+    vector<thread> m_workers;
+    thread m_output;
+};
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Link speed assumed when the camera does not report GevLinkSpeed */
+#define GIGE_DEFAULT_LINK_BPS 1e9
+
+/* Share of the link the cameras on one NIC may use together */
+#define GIGE_DEFAULT_HEADROOM 0.9
+
+/* IP, UDP and GVSP headers, counted in GevSCPSPacketSize */
+#define GIGE_PACKET_HEADER_BYTES 36
+
+/* Ethernet header, FCS, preamble and inter-frame gap around every packet */
+#define GIGE_ETHERNET_OVERHEAD_BYTES 38
+
+/* Nice level and SCHED_RR priority for StreamThreadPriority::HIGH and REALTIME */
+#define STREAM_THREAD_NICE -10
+#define STREAM_THREAD_RT_PRIORITY 10
+
+enum class PacketResend {
+    NEVER,      // lost packets leave the frame incomplete
+    ALWAYS,     // ask the camera to send lost packets again
+};
+
+enum class StreamThreadPriority {
+    NORMAL,
+    HIGH,       // raised nice level
+    REALTIME,   // real-time scheduling; needs rtkit or CAP_SYS_NICE
+};
+
+/* GigE Vision transport settings. Unset fields keep their current value.
+ * Apply them before starting the acquisition: the thread priority restarts
+ * the receive thread, and the packet size changes the payload layout. */
+typedef struct TransportConfig {
+    bool auto_packet_size = false;          // probe the largest packet the path carries (jumbo frames)
+    optional<uint32_t> packet_size;         // GevSCPSPacketSize in bytes, when not probed
+    optional<int64_t> packet_delay_ns;      // GevSCPD, the gap the camera leaves between packets
+    optional<size_t> socket_buffer_size;    // receive socket buffer in bytes; 0 lets Aravis size it
+    optional<PacketResend> packet_resend;
+    optional<uint32_t> packet_timeout_us;   // wait for a missing packet before asking for a resend
+    optional<uint32_t> frame_retention_us;  // give up on an incomplete frame after this long
+    optional<StreamThreadPriority> thread_priority;
+} TransportConfig;
+
+/* What the stream takes on the camera's link. Rates are on-wire bits per
+ * second, Ethernet framing included. */
+typedef struct TransportReport {
+    uint32_t packet_size = 0;           // GevSCPSPacketSize in bytes
+    int64_t packet_delay_ns = 0;        // GevSCPD
+    size_t payload_size = 0;            // bytes per frame
+    double link_bps = 0.0;              // link speed
+    double burst_bps = 0.0;             // rate while a frame is sent, as the packet delay allows
+    double required_bps = 0.0;          // rate at the configured frame rate
+    double achieved_bps = 0.0;          // rate at the measured frame rate (StreamStats::fps)
+    double utilization = 0.0;           // achieved_bps / link_bps
+    uint64_t missing_packets = 0;
+    uint64_t resent_packets = 0;
+} TransportReport;
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,38 @@
+#pragma once
+
+namespace cynlr {
+namespace camera {
+
+enum class LogLevel {
+    LOG_LEVEL_NONE = 0,
+    LOG_LEVEL_ERROR = 1,
+    LOG_LEVEL_WARNING = 2,
+    LOG_LEVEL_INFO = 3,
+    LOG_LEVEL_DEBUG = 4,
+};
+
+/* Library diagnostics at or below this level are printed. Defaults to
+ * LOG_LEVEL_WARNING, so per-command traces such as the lens serial writes
+ * cost nothing unless LOG_LEVEL_DEBUG is set. */
+void setLogLevel(LogLevel level);
+LogLevel getLogLevel();
+
+bool logEnabled(LogLevel level);
+
+/* printf-style message; use CYNLR_LOG so arguments are only evaluated when
+ * the level is enabled. */
+void logMessage(LogLevel level, const char *format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+}  // namespace camera
+}  // namespace cynlr
+
+#define CYNLR_LOG(level, ...) \
+    do { \
+        if (cynlr::camera::logEnabled(level)) { \
+            cynlr::camera::logMessage(level, __VA_ARGS__); \
+        } \
+    } while (0)
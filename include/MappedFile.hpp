@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "Error.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* A file mapped into memory in one piece, either created read-write at a
+ * fixed, preallocated size or opened read-only at its current size. Named
+ * shared memory segments, which other processes open by name, are mapped
+ * the same way. The mapping is released when the object is destroyed. */
+class MappedFile {
+public:
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /* Create (or overwrite) a file of `size` bytes and map it read-write.
+     * The blocks are reserved up front where the file system allows it, so
+     * writes through the mapping never wait for allocation.
+     *
+     * @param path File to create.
+     * @param size File size in bytes.
+     * @return The mapping, or nullptr if the file could not be created or mapped. */
+    static unique_ptr<MappedFile> create(const string &path, size_t size);
+
+    /* Map an existing file read-only.
+     *
+     * @param path File to open.
+     * @return The mapping, or nullptr if the file could not be opened or mapped. */
+    static unique_ptr<MappedFile> open(const string &path);
+
+    /* Create a named shared memory segment of `size` zeroed bytes and map it
+     * read-write. The name is removed when this object is destroyed;
+     * processes that mapped the segment keep their mapping.
+     *
+     * @param name Segment name: letters, digits, '-', '_' and '.' only.
+     * @param size Segment size in bytes.
+     * @return The mapping, or nullptr if the name is taken or the segment could not be mapped. */
+    static unique_ptr<MappedFile> createShared(const string &name, size_t size);
+
+    /* Map a shared memory segment created by another object, in this or
+     * another process.
+     *
+     * @param name Segment name passed to createShared.
+     * @param writable Map read-write instead of read-only.
+     * @return The mapping, or nullptr if there is no such segment. */
+    static unique_ptr<MappedFile> openShared(const string &name, bool writable);
+
+    uint8_t *data() const { return static_cast<uint8_t*>(m_memory); }
+    size_t size() const { return m_size; }
+
+    /* Write dirty pages of a read-write mapping back to the file.
+     *
+     * @return An error if the flush failed, or nullopt if successful. */
+    optional<RecordError> flush();
+
+    /* Unmap, then cut a read-write file down to `length` bytes. The object
+     * holds no mapping afterwards.
+     *
+     * @param length Final file size in bytes.
+     * @return An error if the file could not be truncated, or nullopt if successful. */
+    optional<RecordError> close(size_t length);
+
+private:
+    MappedFile() = default;
+
+    void unmap();
+
+    void *m_memory = nullptr;
+    size_t m_size = 0;
+    bool m_writable = false;
+    bool m_shared_owner = false;    // unlink the shared memory name on destruction
+    string m_path;
+#if defined(_WIN32)
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+}  // namespace camera
+}  // namespace cynlr
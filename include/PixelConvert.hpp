@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "Constants.hpp"
+#include "Error.hpp"
+#include "Frame.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Pixel unpack and down-conversion kernels. Each function picks the widest
+ * instruction set available at runtime (AVX2, SSE4.1 or NEON) and falls back
+ * to scalar code, so results are identical on every machine. */
+
+/* Number of significant bits per pixel, or 0 for PixelFormat::UNKNOWN. */
+int pixelBitDepth(PixelFormat format);
+
+/* Number of bits a pixel occupies in the transport buffer. */
+int pixelStorageBits(PixelFormat format);
+
+/* Unpack a contiguous run of packed pixels into one 16-bit value per pixel.
+ * `src` must start on a pixel group boundary (5 bytes for Mono10p, 3 bytes
+ * for the others).
+ *
+ * @param src Packed source bytes.
+ * @param dst Destination, `count` pixels.
+ * @param count Number of pixels to unpack. */
+void unpackMono10p(const uint8_t *src, uint16_t *dst, size_t count);
+void unpackMono12p(const uint8_t *src, uint16_t *dst, size_t count);
+void unpackMono10Packed(const uint8_t *src, uint16_t *dst, size_t count);
+void unpackMono12Packed(const uint8_t *src, uint16_t *dst, size_t count);
+
+/* Unpack a whole frame of any supported mono format into 16-bit pixels,
+ * honouring the frame's row stride. Mono8 is widened, 16-bit containers are
+ * copied. A stride of 0 with rows that are not byte aligned is read as one
+ * continuous bit stream and needs `dst_stride == frame.width * 2`.
+ *
+ * @param frame The frame to convert.
+ * @param dst Destination, `frame.height` rows of `dst_stride` bytes.
+ * @param dst_stride Bytes per destination row.
+ * @return An error if the format is unsupported, or nullopt if successful. */
+optional<ConvertError> unpackToMono16(const FrameBuffer &frame, uint16_t *dst, size_t dst_stride);
+
+/* Down-convert 16-bit pixels to 8 bits by dropping the low `shift` bits,
+ * saturating at 255. For N-bit data use shift = N - 8. */
+void shift16To8(const uint16_t *src, uint8_t *dst, size_t count, int shift);
+
+/* Linearly map [low, high] to [0, 255], clamping values outside the window. */
+void window16To8(const uint16_t *src, uint8_t *dst, size_t count, uint16_t low, uint16_t high);
+
+/* Down-convert through a lookup table. Values at or beyond `lut_size` map to
+ * the last entry. */
+void lut16To8(const uint16_t *src, uint8_t *dst, size_t count, const uint8_t *lut, size_t lut_size);
+
+/* Name of the instruction set the kernels dispatched to ("avx2", "sse4.1",
+ * "neon" or "scalar"). */
+const char *pixelKernelIsa();
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cynlr {
+namespace camera {
+
+/* On-disk layout of a frame recording, shared by FrameRecorder and the
+ * replay side. All fields are little-endian, as written by the host.
+ *
+ *   [RecordingHeader, padded to RECORDING_ALIGNMENT]
+ *   [RecordingIndexEntry x capacity, padded to RECORDING_ALIGNMENT]
+ *   [payloads, each starting on a RECORDING_ALIGNMENT boundary]
+ *
+ * The index is preallocated, so a payload's place never depends on later
+ * frames. frame_count is only bumped after the entry and payload are in
+ * place, which keeps a file cut short by a crash readable up to there. */
+
+#define RECORDING_MAGIC "CYNLRREC"
+#define RECORDING_VERSION 1
+
+/* Page-sized, so every section and payload can be mapped and handed out directly */
+#define RECORDING_ALIGNMENT 4096
+
+typedef struct RecordingHeader {
+    char magic[8];                  // RECORDING_MAGIC, without the terminator
+    uint32_t version;               // RECORDING_VERSION
+    uint32_t entry_size;            // sizeof(RecordingIndexEntry)
+    uint64_t capacity;              // index entries reserved
+    uint64_t frame_count;           // index entries written
+    uint64_t index_offset;          // file offset of the index
+    uint64_t data_offset;           // file offset of the first payload
+    uint64_t data_used;             // payload bytes written, alignment padding included
+    uint64_t created_ns;            // host time the recording was created
+} RecordingHeader;
+
+typedef struct RecordingIndexEntry {
+    uint64_t offset;                // file offset of the payload
+    uint64_t payload_size;          // payload bytes
+    uint64_t frame_id;
+    uint64_t timestamp_ns;          // device timestamp
+    uint64_t system_timestamp_ns;   // host receive time
+    int32_t width;
+    int32_t height;
+    int32_t offset_x;
+    int32_t offset_y;
+    uint32_t stride;
+    int32_t pixel_format;           // PixelFormat value
+    int32_t status;                 // FrameStatus value
+    uint32_t reserved;
+} RecordingIndexEntry;
+
+static_assert(sizeof(RecordingHeader) == 64, "RecordingHeader layout changed");
+static_assert(sizeof(RecordingIndexEntry) == 72, "RecordingIndexEntry layout changed");
+
+}  // namespace camera
+}  // namespace cynlr
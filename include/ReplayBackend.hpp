@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+
+#include "CameraBackend.hpp"
+#include "Constants.hpp"
+#include "ReplayStream.hpp"
+#include "Stream.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Camera backend that plays back a recording made with FrameRecorder, so a
+ * vision pipeline can run against recorded data with the exact consumer code
+ * used on a live camera. The image itself is fixed by the recording: a pixel
+ * format or region other than the recorded one, or any binning, fails with a
+ * "not supported by replay" error, while requesting the recorded values
+ * succeeds so setup code runs unchanged. Gain, exposure, frame rate, PTP,
+ * trigger activation and delay, and the lens have nothing to act on in a
+ * recording; their setters are accepted and have no effect.
+ * Trigger mode plays one frame per software trigger. */
+class ReplayBackend : public ICameraBackend {
+public:
+    /* Open a recording.
+     *
+     * @param config Recording path and playback mode.
+     * @param stream_buffer_count Number of frames that can be borrowed at once.
+     * @return The backend, or nullptr if the recording could not be opened. */
+    static unique_ptr<ReplayBackend> create(
+        const ReplayConfig &config,
+        uint32_t stream_buffer_count = DEFAULT_NUM_BUFFERS);
+
+    optional<CamError> startAcquisition() override;
+    optional<CamError> stopAcquisition() override;
+    optional<CamError> setAcquisitionMode(AcquisitionMode mode) override;
+    optional<CamError> setPixelFormat(PixelFormat format) override;
+    optional<CamError> setBinning(int dx, int dy) override;
+    optional<CamError> setRegion(int x, int y, int width, int height) override;
+    optional<CamError> setRegions(const vector<Region> &regions) override;
+    optional<CamError> setGain(double gain) override;
+    optional<CamError> setAutoExposure(bool setAuto) override;
+    optional<CamError> setExposureTime(double exposure_time_us) override;
+    optional<CamError> setFrameRate(double framerate) override;
+    optional<CamError> enablePtp(bool enable) override;
+
+    optional<CamError> setTriggerMode(bool enable) override;
+    optional<CamError> setTriggerSource(TriggerSource source) override;
+    optional<CamError> setTriggerActivation(TriggerActivation activation) override;
+    optional<CamError> setTriggerDelay(double delay_us) override;
+    optional<CamError> fireSoftwareTrigger() override;
+
+    optional<CamError> enableLensPower(bool enable) override;
+    optional<CamError> setupLensSerial(const char* baudRate) override;
+    optional<CamError> setLensFocus(double voltage) override;
+    optional<CamError> setLensResultCheck(bool enable) override;
+    optional<CamError> checkLensResult() override;
+    optional<CamError> enableChunks(const vector<ChunkSelector> &chunks) override;
+
+    shared_ptr<IStream> getStream() override;
+
+    /* Playback controls, also allowed while acquiring */
+    uint64_t frameCount() const { return stream->frameCount(); }
+    optional<CamError> setReplayMode(ReplayMode mode, double speed = 1.0);
+    void setLoop(bool loop) { stream->setLoop(loop); }
+    optional<CamError> seekToFrameId(uint64_t frame_id);
+    optional<CamError> seekToTimestamp(uint64_t system_timestamp_ns);
+
+private:
+    ReplayBackend(shared_ptr<ReplayStream> stream, uint32_t stream_buffer_count) :
+        stream(stream), stream_buffer_count(stream_buffer_count) {}
+
+    shared_ptr<ReplayStream> stream;
+    uint32_t stream_buffer_count;
+    bool acquiring = false;
+    bool trigger_mode = false;
+    TriggerSource trigger_source = TriggerSource::SOFTWARE;
+};
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BufferedStream.hpp"
+#include "CameraBackend.hpp"
+#include "MappedFile.hpp"
+#include "Recording.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+enum class ReplayMode {
+    REAL_TIME,      // frames spaced as recorded, scaled by ReplayConfig::speed, late frames play at once
+    FAST,           // as fast as the consumer releases buffers, never dropping
+};
+
+typedef struct ReplayConfig {
+    string path;                            // recording written by FrameRecorder
+    ReplayMode mode = ReplayMode::REAL_TIME;
+    double speed = 1.0;                     // REAL_TIME playback speed, 2.0 plays twice as fast
+    bool loop = false;                      // start over after the last frame
+} ReplayConfig;
+
+/* Stream that plays back a recording (see Recording.hpp). The file is mapped
+ * read-only and frames point straight into the mapping, so nothing is
+ * copied; the stream buffers are only descriptors and their count bounds how
+ * many frames can be borrowed at once. Frame data is read-only and keeps the
+ * recorded timestamps, while the stream statistics follow the playback. */
+class ReplayStream : public BufferedStream {
+public:
+    ReplayStream(const ReplayConfig &config, unique_ptr<MappedFile> file);
+    ~ReplayStream();
+
+    /* Check the header and every index entry against the file.
+     *
+     * @return An error if the recording is malformed, or nullopt if successful. */
+    optional<StreamError> loadIndex();
+
+    uint64_t frameCount() const { return m_count; }
+
+    /* Recorded format of the first frame, or UNKNOWN for an empty recording. */
+    PixelFormat pixelFormat() const;
+
+    /* Recorded region of the first frame, or an empty Region for an empty recording. */
+    Region region() const;
+
+    void setMode(ReplayMode mode, double speed);
+    void setLoop(bool loop);
+    void setSingleFrame(bool single_frame);
+
+    /* In trigger mode every software trigger plays exactly one frame. */
+    void setTriggerMode(bool enable);
+
+    /* Continue playback at the first frame with an id, or a host timestamp,
+     * at or after the given one. Frames queued but not yet borrowed are
+     * dropped.
+     *
+     * @return An error if no frame is that late, or nullopt if successful. */
+    optional<StreamError> seekToFrameId(uint64_t frame_id);
+    optional<StreamError> seekToTimestamp(uint64_t system_timestamp_ns);
+
+    /* Set up `count` descriptors and start playing from the current position.
+     *
+     * @param count Number of frames that can be in flight.
+     * @return An error if the stream is already playing, or nullopt if successful. */
+    optional<StreamError> start(uint32_t count);
+
+    /* Stop playing. Completed frames stay queued until borrowed. */
+    void stop();
+
+    /* Play one frame in trigger mode.
+     *
+     * @return An error if the stream is not playing, or nullopt if successful. */
+    optional<StreamError> softwareTrigger();
+
+protected:
+    void *popBuffer(chrono::microseconds timeout) override;
+    void pushBuffer(void *buffer) override;
+    int queuedFrameCount() override;
+    int freeBufferCount() override;
+    void transportCounters(StreamStats &stats) override;
+    FrameStatus bufferStatus(void *buffer) override;
+    uint64_t bufferCompletedNs(void *buffer) override;
+    void fillFrameBuffer(void *buffer, FrameBuffer &frame) override;
+
+private:
+    typedef struct ReplayBuffer {
+        uint32_t generation = 0;                    // m_generation when the descriptor was made
+        const RecordingIndexEntry *entry = nullptr;
+        uint64_t completed_ns = 0;                  // host time the frame was played
+    } ReplayBuffer;
+
+    void playerLoop();
+    optional<StreamError> seekTo(uint64_t position);
+
+    ReplayConfig m_config;
+    unique_ptr<MappedFile> m_file;
+    const RecordingIndexEntry *m_index = nullptr;
+    uint64_t m_count = 0;
+
+    /* Playback state and buffer queues, guarded by m_queue_mutex */
+    mutex m_queue_mutex;
+    condition_variable m_output_cv;
+    condition_variable m_player_cv;
+    deque<ReplayBuffer*> m_input;
+    deque<ReplayBuffer*> m_output;
+    uint32_t m_generation = 0;
+    uint32_t m_buffer_count = 0;
+    uint64_t m_position = 0;            // next frame to play
+    bool m_reanchor = true;             // restart the REAL_TIME schedule at m_position
+    bool m_single_frame = false;
+    bool m_trigger_mode = false;
+    uint32_t m_pending_triggers = 0;
+
+    thread m_player;
+    atomic<bool> m_playing{false};
+
+    /* Transport counters, written by the player */
+    atomic<uint64_t> m_completed{0};
+    atomic<uint64_t> m_failures{0};
+    atomic<uint64_t> m_underruns{0};
+};
+
+}  // namespace camera
+}  // namespace cynlr
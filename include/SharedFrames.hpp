@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Layout of the shared memory segment a FramePublisher announces frames in,
+ * read by FrameSubscriber in other processes. Frame data is not in this
+ * segment: it stays in the camera's shared BufferPool segment, named in
+ * each descriptor, so nothing is copied.
+ *
+ *   [PublisherHeader]
+ *   [PublishedFrame x capacity]
+ *
+ * Frame n (counting from 0) goes to descriptor n % capacity. The publisher
+ * keeps the newest frames out of the camera's stream; once a frame goes
+ * back, `released` moves past it and its data may be overwritten. Readers
+ * never block the publisher: a descriptor is rewritten under a per-slot
+ * sequence tag, so a reader that was lapped sees the tag change and skips
+ * the frame. */
+
+#define PUBLISHER_MAGIC "CYNLRPUB"
+#define PUBLISHER_VERSION 1
+
+/* Room for a shared pool name, terminator included */
+#define SHARED_SEGMENT_NAME_SIZE 64
+
+typedef struct PublishedFrame {
+    atomic<uint64_t> tag;                       // frame number + 1 once written, 0 while being rewritten
+    char segment[SHARED_SEGMENT_NAME_SIZE];     // shared BufferPool segment holding the payload
+    uint64_t offset;                            // payload offset in that segment
+    uint64_t payload_size;
+    uint64_t frame_id;
+    uint64_t timestamp_ns;
+    uint64_t system_timestamp_ns;
+    int32_t width;
+    int32_t height;
+    int32_t offset_x;
+    int32_t offset_y;
+    uint32_t stride;
+    int32_t pixel_format;                       // PixelFormat
+    int32_t status;                             // FrameStatus
+    int32_t reserved;
+} PublishedFrame;
+
+typedef struct PublisherHeader {
+    char magic[8];                              // PUBLISHER_MAGIC, without the terminator
+    uint32_t version;                           // PUBLISHER_VERSION
+    uint32_t descriptor_size;                   // sizeof(PublishedFrame)
+    uint32_t capacity;                          // descriptors, a power of two
+    uint32_t hold_frames;                       // newest frames kept valid for readers
+    alignas(64) atomic<uint64_t> published;     // frames announced so far
+    alignas(64) atomic<uint64_t> released;      // frames below this number may be overwritten
+    alignas(64) atomic<uint32_t> wake;          // bumped on every frame; readers sleep on it
+    atomic<uint32_t> sleepers;                  // readers sleeping on `wake`
+    atomic<uint32_t> closed;                    // set when the publisher shuts down
+} PublisherHeader;
+
+static_assert(atomic<uint64_t>::is_always_lock_free && atomic<uint32_t>::is_always_lock_free,
+    "Shared memory counters must be lock-free to work across processes");
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+
+#include "CameraBackend.hpp"
+#include "Constants.hpp"
+#include "SimulatedStream.hpp"
+#include "Stream.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Camera backend that needs no hardware. Frames come from a SimulatedStream
+ * and every setter acts on the simulated sensor: binning and pixel format
+ * change the frame layout, frame rate and exposure the timing, exposure and
+ * gain the brightness, and the lens calls drive a defocus blur model. */
+class SimulatedBackend : public ICameraBackend {
+public:
+    /* Create a simulated camera.
+     *
+     * @param config Sensor geometry, scene and lens model.
+     * @param stream_buffer_count Number of stream buffers.
+     * @return The backend, or nullptr if the scene could not be loaded. */
+    static unique_ptr<SimulatedBackend> create(
+        const SimulatedConfig &config = SimulatedConfig(),
+        uint32_t stream_buffer_count = DEFAULT_NUM_BUFFERS);
+
+    optional<CamError> startAcquisition() override;
+    optional<CamError> stopAcquisition() override;
+    optional<CamError> setAcquisitionMode(AcquisitionMode mode) override;
+    optional<CamError> setPixelFormat(PixelFormat format) override;
+    optional<CamError> setBinning(int dx, int dy) override;
+    optional<CamError> setRegion(int x, int y, int width, int height) override;
+    optional<CamError> setRegions(const vector<Region> &regions) override;
+    optional<CamError> setGain(double gain) override;
+    optional<CamError> setAutoExposure(bool setAuto) override;
+    optional<CamError> setExposureTime(double exposure_time_us) override;
+    optional<CamError> setFrameRate(double framerate) override;
+    optional<CamError> enablePtp(bool enable) override;
+
+    optional<CamError> setTriggerMode(bool enable) override;
+    optional<CamError> setTriggerSource(TriggerSource source) override;
+    optional<CamError> setTriggerActivation(TriggerActivation activation) override;
+    optional<CamError> setTriggerDelay(double delay_us) override;
+    optional<CamError> fireSoftwareTrigger() override;
+
+    optional<CamError> enableLensPower(bool enable) override;
+    optional<CamError> setupLensSerial(const char* baudRate) override;
+    optional<CamError> setLensFocus(double voltage) override;
+    optional<CamError> setLensResultCheck(bool enable) override;
+    optional<CamError> checkLensResult() override;
+    optional<CamError> enableChunks(const vector<ChunkSelector> &chunks) override;
+
+    shared_ptr<IStream> getStream() override;
+
+private:
+    SimulatedBackend(const SimulatedConfig &config, shared_ptr<SimulatedStream> stream, uint32_t stream_buffer_count) :
+        config(config), stream(stream), stream_buffer_count(stream_buffer_count) {}
+
+    SimulatedConfig config;
+    shared_ptr<SimulatedStream> stream;
+    uint32_t stream_buffer_count;
+    SimulatedSettings settings;
+    bool acquiring = false;
+    bool serial_port_open = false;
+};
+
+}  // namespace camera
+}  // namespace cynlr
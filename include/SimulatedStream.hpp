@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "BufferPool.hpp"
+#include "BufferedStream.hpp"
+#include "CameraBackend.hpp"
+#include "Constants.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+enum class SimulatedPattern {
+    GRADIENT,       // diagonal ramp over the full dynamic range
+    CHECKERBOARD,   // high-contrast squares, useful for focus metrics
+    NOISE,          // fresh uniform noise every frame
+    FILES,          // images from SimulatedConfig::files, replayed in order
+};
+
+/* Liquid lens model. Sharpness falls off linearly with the distance from the
+ * in-focus voltage, and a new voltage takes settle_time_us to reach. */
+typedef struct SimulatedLens {
+    double focus_voltage = 47.0;        // voltage at which the scene is sharp
+    double blur_per_volt = 0.25;        // blur sigma in sensor pixels per volt of defocus
+    double max_blur = 12.0;             // blur sigma far out of focus or with the lens unpowered
+    uint32_t settle_time_us = 10000;    // time a focus change takes to complete
+} SimulatedLens;
+
+typedef struct SimulatedConfig {
+    int width = 1280;                   // sensor width before binning
+    int height = 1024;                  // sensor height before binning
+    PixelFormat pixel_format = PixelFormat::MONO8;
+    double frame_rate = 30.0;
+    double exposure_time_us = 10000.0;  // exposure that renders the pattern at nominal brightness
+    SimulatedPattern pattern = SimulatedPattern::GRADIENT;
+    vector<string> files;               // images for SimulatedPattern::FILES
+    int scroll_px = 4;                  // horizontal scene motion per frame, in sensor pixels
+    double failure_rate = 0.0;          // probability of a frame completing with MISSING_PACKETS
+    SimulatedLens lens;
+    BufferPoolConfig pool_config;
+} SimulatedConfig;
+
+/* Runtime settings of the simulated sensor, changed through the backend */
+typedef struct SimulatedSettings {
+    int binning_x = 1;
+    int binning_y = 1;
+    Region region;          // in binned pixels; zero width or height means the full sensor
+    PixelFormat pixel_format = PixelFormat::MONO8;
+    double frame_rate = 30.0;
+    double exposure_time_us = 10000.0;
+    double gain_db = 0.0;
+    bool auto_exposure = false;
+    bool single_frame = false;
+    bool lens_powered = false;
+    double lens_voltage = 24.0;
+    bool trigger_mode = false;
+    TriggerSource trigger_source = TriggerSource::SOFTWARE;
+    TriggerActivation trigger_activation = TriggerActivation::RISING_EDGE;
+    double trigger_delay_us = 0.0;
+    uint32_t chunks = 0;    // bit n set when chunk ChunkSelector(n) is enabled
+} SimulatedSettings;
+
+/* Stream fed by an in-process frame generator instead of a camera. Frames are
+ * rendered at the configured rate into a BufferPool and flow through the same
+ * queues and borrow paths as a hardware stream, so everything above IStream
+ * behaves as it would with a real device. When the consumer holds on to every
+ * buffer the generator drops frames, and frame_id skips accordingly. */
+class SimulatedStream : public BufferedStream {
+public:
+    SimulatedStream(const SimulatedConfig &config);
+    ~SimulatedStream();
+
+    /* Render the static scene, loading the replay images if any.
+     *
+     * @return An error if an image could not be loaded, or nullopt if successful. */
+    optional<StreamError> loadScene();
+
+    /* Apply new sensor settings. Takes effect from the next rendered frame.
+     *
+     * @param settings The settings to apply. */
+    void applySettings(const SimulatedSettings &settings);
+
+    /* Stamp frames from the host wall clock, shared by every simulated
+     * camera in the process, instead of a per-camera clock starting at zero. */
+    void setPtpEnabled(bool enable) { m_ptp = enable; }
+
+    /* Bytes per frame under the given settings. */
+    size_t payloadSize(const SimulatedSettings &settings) const;
+
+    /* Allocate `count` buffers of the current payload and start generating.
+     *
+     * @param count Number of buffers.
+     * @return An error if the operation failed, or nullopt if successful. */
+    optional<StreamError> start(uint32_t count);
+
+    /* Stop generating. Completed frames stay queued until borrowed. */
+    void stop();
+
+    /* Start one exposure in trigger mode. There are no I/O lines, so this
+     * is the only way a simulated trigger fires.
+     *
+     * @return An error if the stream is not generating, or nullopt if successful. */
+    optional<StreamError> softwareTrigger();
+
+protected:
+    void *popBuffer(chrono::microseconds timeout) override;
+    void pushBuffer(void *buffer) override;
+    int queuedFrameCount() override;
+    int freeBufferCount() override;
+    void transportCounters(StreamStats &stats) override;
+    FrameStatus bufferStatus(void *buffer) override;
+    uint64_t bufferCompletedNs(void *buffer) override;
+    void fillFrameBuffer(void *buffer, FrameBuffer &frame) override;
+
+private:
+    typedef struct SimulatedBuffer {
+        shared_ptr<BufferPool> pool;
+        void *data = nullptr;
+        FrameStatus status = FrameStatus::UNKNOWN;
+        int width = 0;
+        int height = 0;
+        int offset_x = 0;
+        int offset_y = 0;
+        size_t stride = 0;
+        size_t payload_size = 0;
+        PixelFormat pixel_format = PixelFormat::UNKNOWN;
+        uint64_t frame_id = 0;
+        uint64_t timestamp_ns = 0;
+        uint64_t system_timestamp_ns = 0;
+        FrameChunks chunks;
+    } SimulatedBuffer;
+
+    void generatorLoop();
+    void renderFrame(SimulatedBuffer &buffer, const SimulatedSettings &settings, double lens_voltage);
+    void packFrame(const cv::Mat &image, SimulatedBuffer &buffer);
+    void stampChunks(SimulatedBuffer &buffer, const SimulatedSettings &settings) const;
+    double lensVoltageAt(uint64_t now_ns) const;
+    uint64_t deviceTimeNs() const;
+
+    SimulatedConfig m_config;
+    chrono::steady_clock::time_point m_epoch;
+    atomic<bool> m_ptp{false};
+
+    /* Sensor settings and lens transition, guarded by m_settings_mutex */
+    mutable mutex m_settings_mutex;
+    SimulatedSettings m_settings;
+    double m_lens_from = 0.0;
+    uint64_t m_lens_changed_ns = 0;
+
+    /* Buffer queues, guarded by m_queue_mutex */
+    mutex m_queue_mutex;
+    condition_variable m_output_cv;
+    condition_variable m_generator_cv;
+    deque<SimulatedBuffer*> m_input;
+    deque<SimulatedBuffer*> m_output;
+    shared_ptr<BufferPool> m_pool;
+
+    thread m_generator;
+    atomic<bool> m_generating{false};
+    uint64_t m_frame_id = 0;
+    uint32_t m_pending_triggers = 0;    // guarded by m_queue_mutex
+
+    /* Transport counters, written by the generator */
+    atomic<uint64_t> m_completed{0};
+    atomic<uint64_t> m_failures{0};
+    atomic<uint64_t> m_underruns{0};
+
+    /* Generator-owned render state */
+    vector<cv::Mat> m_scenes;
+    cv::Mat m_sensor;
+    cv::Mat m_binned;
+    vector<uint16_t> m_row;
+    mt19937 m_rng;
+};
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Bounded lock-free queue for exactly one producer thread and one consumer
+ * thread. Head and tail live on separate cache lines, and each side caches
+ * the other's index so the common case touches no shared line. */
+template <typename T>
+class SpscRing {
+public:
+    /* @param capacity Maximum number of queued items, rounded up to a power of two. */
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_slots = make_unique<T[]>(size);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /* Producer: move `item` in if there is room. `item` is left untouched
+     * when the ring is full.
+     *
+     * @return True if the item was queued. */
+    bool tryPush(T &item) {
+        size_t tail = m_tail.load(memory_order_relaxed);
+        if (tail - m_cached_head > m_mask) {
+            m_cached_head = m_head.load(memory_order_acquire);
+            if (tail - m_cached_head > m_mask) {
+                return false;
+            }
+        }
+        m_slots[tail & m_mask] = move(item);
+        m_tail.store(tail + 1, memory_order_release);
+        return true;
+    }
+
+    /* Consumer: oldest item, or nullptr if the ring is empty. The pointer
+     * stays valid until pop(). */
+    T *front() {
+        size_t head = m_head.load(memory_order_relaxed);
+        if (head == m_cached_tail) {
+            m_cached_tail = m_tail.load(memory_order_acquire);
+            if (head == m_cached_tail) {
+                return nullptr;
+            }
+        }
+        return &m_slots[head & m_mask];
+    }
+
+    /* Consumer: remove the item returned by front(). */
+    void pop() {
+        size_t head = m_head.load(memory_order_relaxed);
+        m_slots[head & m_mask] = T();
+        m_head.store(head + 1, memory_order_release);
+    }
+
+    /* Consumer: move the oldest item out.
+     *
+     * @return True if an item was taken. */
+    bool tryPop(T &item) {
+        T *slot = front();
+        if (slot == nullptr) {
+            return false;
+        }
+        item = move(*slot);
+        pop();
+        return true;
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    alignas(CACHE_LINE) atomic<size_t> m_head{0};
+    size_t m_cached_tail = 0;       // consumer's view of m_tail
+
+    alignas(CACHE_LINE) atomic<size_t> m_tail{0};
+    size_t m_cached_head = 0;       // producer's view of m_head
+
+    alignas(CACHE_LINE) size_t m_mask = 0;
+    unique_ptr<T[]> m_slots;
+};
+
+}  // namespace camera
+}  // namespace cynlr
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <optional>
 #include "Error.hpp"
 #include "Frame.hpp"
@@ -8,17 +11,79 @@ namespace cynlr {
 namespace camera {
 
 using namespace std;
+
+/* Timing information delivered alongside each frame in push mode. */
+typedef struct FrameDispatchInfo {
+    uint64_t completed_ns = 0;   // host time the transport timestamped the buffer
+    uint64_t dispatched_ns = 0;  // host time the callback was invoked
+    uint64_t latency_ns = 0;     // dispatched_ns - completed_ns
+} FrameDispatchInfo;
+
+/* Number of log2 buckets in StreamStats::jitter_histogram */
+#define STREAM_JITTER_BUCKETS 16
+
+/* Frames over which StreamStats::fps is measured */
+#define STREAM_FPS_WINDOW 32
+
+/* Running summary of a latency, in ns */
+typedef struct LatencyStats {
+    uint64_t count = 0;
+    uint64_t last_ns = 0;
+    uint64_t min_ns = 0;
+    uint64_t max_ns = 0;
+    double mean_ns = 0.0;
+    double stddev_ns = 0.0;
+} LatencyStats;
+
+/* Snapshot of a stream's counters. The transport counters come from the
+ * backend; the others describe the frames this library took off the stream. */
+typedef struct StreamStats {
+    uint64_t completed = 0;         // buffers completed by the transport, successfully or not
+    uint64_t failures = 0;          // buffers completed with an error status
+    uint64_t underruns = 0;         // frames lost because no empty buffer was queued
+    uint64_t missing_packets = 0;   // GigE packets never received
+    uint64_t resent_packets = 0;    // GigE packets recovered by a resend request
+
+    uint64_t delivered = 0;         // frames borrowed or passed to the frame callback
+    uint64_t discarded = 0;         // frames skipped by borrowNewest/borrowNextNew or latest-frame mode
+    uint64_t status_counts[FRAME_STATUS_COUNT] = {};   // indexed through statusCount()
+
+    double fps = 0.0;               // completion rate over the last STREAM_FPS_WINDOW frames
+
+    /* Deviation of each inter-frame interval from the running mean interval.
+     * Bucket 0 counts deviations under 1 us, bucket i those in [2^(i-1), 2^i) us,
+     * and the last bucket everything longer. */
+    uint64_t jitter_histogram[STREAM_JITTER_BUCKETS] = {};
+
+    int queued_frames = 0;          // completed frames waiting to be consumed
+    int free_buffers = 0;           // empty buffers waiting to be filled
+
+    /* Software triggers, each matched with the next frame delivered after it */
+    uint64_t triggers = 0;                  // software triggers fired
+    LatencyStats trigger_to_frame;          // trigger to the host receiving the frame
+    LatencyStats trigger_to_delivery;       // trigger to the frame reaching the application
+
+    uint64_t statusCount(FrameStatus status) const {
+        return status_counts[static_cast<int>(status) - static_cast<int>(FrameStatus::UNKNOWN)];
+    }
+} StreamStats;
+
+/* Frame sink used in push mode. The frame is only valid for the duration of
+ * the call; it is handed back to the stream as soon as the callback returns. */
+using FrameCallback = function<void(const FrameBuffer &frame, const FrameDispatchInfo &info)>;
  
 class IStream {
 public:
-    /* Borrow the oldest frame from the stream. It will discard all buffers 
-     * except the oldest one.
+    /* Borrow the oldest queued frame from the stream (FIFO order). Frames
+     * queued after it are kept.
      *
      * @param frame The frame buffer to fill.
      * @return An error if the operation failed, or nullopt if successful. */
     virtual optional<StreamError> borrowOldestFrame(FrameBuffer &frame) = 0;
 
-    /* Borrow the newest frame from the stream.
+    /* Borrow the newest frame from the stream. Older queued frames are
+     * discarded. In latest-frame mode this is a wait-free slot exchange that
+     * fails if no frame completed since the previous borrow.
      *
      * @param frame The frame buffer to fill.
      * @return An error if the operation failed, or nullopt if successful. */
@@ -31,11 +96,62 @@ public:
      * @return An error if the operation failed, or nullopt if successful. */
     virtual optional<StreamError> borrowNextNewFrame(FrameBuffer &frame) = 0;
 
+    /* Timed variants of the borrow functions above. Instead of failing on an
+     * empty queue they sleep until a frame arrives or the timeout expires, in
+     * which case the error code is StreamErrorCode::TIMEOUT.
+     *
+     * @param frame The frame buffer to fill.
+     * @param timeout Maximum time to wait for a frame.
+     * @return An error if the operation failed or timed out, or nullopt if successful. */
+    virtual optional<StreamError> borrowOldestFrame(FrameBuffer &frame, chrono::microseconds timeout) = 0;
+    virtual optional<StreamError> borrowNewestFrame(FrameBuffer &frame, chrono::microseconds timeout) = 0;
+    virtual optional<StreamError> borrowNextNewFrame(FrameBuffer &frame, chrono::microseconds timeout) = 0;
+
     /* Release a previously borrowed frame back to the stream.
      * This MUST be called for each frame borrowed.
      *
      * @param frame The frame buffer to release. */
     virtual void releaseFrame(FrameBuffer &frame) = 0;
+
+    /* Switch the stream to push mode. Completed frames are delivered to the
+     * callback from a dedicated acquisition thread, and the borrow functions
+     * fail while a callback is registered. Registering again replaces the
+     * previous callback. Must not be called from inside the callback.
+     *
+     * @param callback The frame sink to invoke for each completed frame.
+     * @return An error if the operation failed, or nullopt if successful. */
+    virtual optional<StreamError> registerFrameCallback(FrameCallback callback) = 0;
+
+    /* Leave push mode. Blocks until the acquisition thread has exited, so no
+     * callback is running once this returns. Must not be called from inside
+     * the callback. */
+    virtual void unregisterFrameCallback() = 0;
+
+    /* Enable or disable latest-frame mode. A background thread drains the
+     * stream and keeps only the most recent completed frame in a single slot,
+     * recycling older frames immediately, so borrowNewestFrame always returns
+     * the freshest frame regardless of queue depth. Cannot be combined with
+     * push mode.
+     *
+     * @param enable True to enable latest-frame mode, false to disable it.
+     * @return An error if the operation failed, or nullopt if successful. */
+    virtual optional<StreamError> setLatestFrameMode(bool enable) = 0;
+
+    /* Choose what happens to frames the transport could not complete. By
+     * default they are recycled straight back into the stream and skipped,
+     * so the borrow waits for the next good frame. When enabled, frames that
+     * still carry image data (missing packets, size mismatch, transfer
+     * timeout) are delivered with FrameBuffer::status set to the failure.
+     * Either way they are counted in StreamStats.
+     *
+     * @param enable True to deliver incomplete frames, false to skip them. */
+    virtual void setDeliverIncompleteFrames(bool enable) = 0;
+
+    /* Snapshot the stream counters. Safe to call from any thread, including
+     * from inside the frame callback.
+     *
+     * @return The current statistics. */
+    virtual StreamStats getStreamStats() = 0;
 };
 
 }
@@ -1,28 +1,33 @@
 #include <memory>
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
 
 #include "AravisBackend.hpp"
-
-#define ARV_RET_OPT(expr, error)                          \
-    do {                                                  \
-        (expr);                                           \
-        if (error != NULL) {                              \
-            return CamError { .message = error->message };\
-        } else {                                          \
-            return nullopt;                               \
-        }                                                 \
+#include "Log.hpp"
+
+/* GError messages are freed with the error, so CamError keeps an interned
+ * copy (see internErrorMessage) */
+#define ARV_RET_OPT(expr, error)                                        \
+    do {                                                                \
+        (expr);                                                         \
+        ARV_CHECK_ERROR(error);                                         \
+        return nullopt;                                                 \
     } while (0)
 
-#define ARV_CHECK_ERROR(err)                              \
-    do {                                                  \
-        if (err != NULL) {                                \
-            CamError e { .message = err->message };       \
-            g_clear_error(&err);                          \
-            return e;                                     \
-        }                                                 \
+#define ARV_CHECK_ERROR(err)                                            \
+    do {                                                                \
+        if (err != NULL) {                                              \
+            CamError e { .message = internErrorMessage(err->message) }; \
+            g_clear_error(&err);                                        \
+            return e;                                                   \
+        }                                                               \
     } while (0)
 
 namespace cynlr {
@@ -30,6 +35,54 @@ namespace camera {
 
 using namespace std;
 
+/* A copy of `message` that lives as long as the process. Each distinct
+ * message is stored once, so repeated failures do not grow the set. */
+static const char *internErrorMessage(const char *message) {
+    static mutex messages_mutex;
+    static set<string> messages;
+
+    lock_guard<mutex> lock(messages_mutex);
+    return messages.insert(message).first->c_str();
+}
+
+/* Runs on the Aravis receive thread. As the thread starts, raise it to the
+ * priority chosen with configureTransport. */
+static void streamThreadCallback(void *user_data, ArvStreamCallbackType type, ArvBuffer *buffer) {
+    (void)buffer;
+    if (type != ARV_STREAM_CALLBACK_TYPE_INIT) {
+        return;
+    }
+
+    switch (static_cast<atomic<StreamThreadPriority>*>(user_data)->load()) {
+        case StreamThreadPriority::NORMAL:
+            break;
+        case StreamThreadPriority::HIGH:
+            if (!arv_make_thread_high_priority(STREAM_THREAD_NICE)) {
+                CYNLR_LOG(LogLevel::LOG_LEVEL_WARNING, "  [transport] could not raise the receive thread priority\n");
+            }
+            break;
+        case StreamThreadPriority::REALTIME:
+            if (!arv_make_thread_realtime(STREAM_THREAD_RT_PRIORITY)) {
+                CYNLR_LOG(LogLevel::LOG_LEVEL_WARNING, "  [transport] could not make the receive thread real-time\n");
+            }
+            break;
+    }
+}
+
+/* On-wire bits of one packet of `packet_size` bytes */
+static double packetWireBits(uint32_t packet_size) {
+    return 8.0 * (packet_size + GIGE_ETHERNET_OVERHEAD_BYTES);
+}
+
+/* On-wire bits of one frame: the payload split into packets, plus headers
+ * and framing for each, plus the leader and trailer packets */
+static double frameWireBits(size_t payload, uint32_t packet_size) {
+    size_t data_per_packet = packet_size > GIGE_PACKET_HEADER_BYTES ? packet_size - GIGE_PACKET_HEADER_BYTES : 1;
+    double packets = ceil(static_cast<double>(payload) / static_cast<double>(data_per_packet));
+    return 8.0 * (static_cast<double>(payload)
+        + (packets + 2) * (GIGE_PACKET_HEADER_BYTES + GIGE_ETHERNET_OVERHEAD_BYTES));
+}
+
 std::vector<std::string> AravisBackend::listCameras() {
     arv_update_device_list();
     unsigned int n = arv_get_n_devices();
@@ -43,24 +96,31 @@ std::vector<std::string> AravisBackend::listCameras() {
 
 unique_ptr<AravisBackend> AravisBackend::create(
     const char* name,
-    uint32_t stream_buffer_count)
+    uint32_t stream_buffer_count,
+    BufferPoolConfig pool_config)
 {
-    GError *error;
+    GError *error = NULL;
 
     ArvCamera *new_camera = arv_camera_new(name, &error);
     if (!ARV_IS_CAMERA(new_camera)) {
+        g_clear_error(&error);
         return nullptr;
     }
 
-    ArvStream *new_stream = arv_camera_create_stream(new_camera, NULL, NULL, &error);
+    // Owned by the stream, which outlives its receive thread
+    auto thread_priority = make_unique<atomic<StreamThreadPriority>>(StreamThreadPriority::NORMAL);
+    ArvStream *new_stream = arv_camera_create_stream(
+        new_camera, streamThreadCallback, thread_priority.get(), &error);
     if (!ARV_IS_STREAM(new_stream)) {
         printf("Error : Stream not created at %s:%d\n", __FILE__, __LINE__);
+        g_clear_error(&error);
+        g_clear_object(&new_camera);
         return nullptr;
     }
 
     AravisBackend *backend = new AravisBackend(
         new_camera,
-        make_shared<AravisStream>(new_stream),
+        make_shared<AravisStream>(new_stream, pool_config, move(thread_priority)),
         stream_buffer_count);
 
     return unique_ptr<AravisBackend>(backend);
@@ -79,111 +139,270 @@ AravisBackend::~AravisBackend() {
 }
 
 optional<CamError> AravisBackend::startAcquisition() {
-    size_t payload = arv_camera_get_payload(camera, &error);
+    GError *err = NULL;
+    size_t payload = arv_camera_get_payload(camera, &err);
+    ARV_CHECK_ERROR(err);
 
-    // Insert some buffers in the stream buffer pool
-    for (uint32_t i = 0; i < stream_buffer_count; i++) {
-        arv_stream_push_buffer(stream->m_stream, arv_buffer_new(payload, NULL));
+    // Reuses the existing stream buffers unless the payload changed
+    if (auto stream_err = stream->prepareBuffers(payload, stream_buffer_count)) {
+        return CamError { .message = stream_err->message };
     }
 
-    ARV_RET_OPT(arv_camera_start_acquisition(camera, &error), error);
+    ARV_RET_OPT(arv_camera_start_acquisition(camera, &err), err);
 }
 
 optional<CamError> AravisBackend::stopAcquisition() {
-    ARV_RET_OPT(arv_camera_stop_acquisition(camera, &error), error);
+    GError *err = NULL;
+    ARV_RET_OPT(arv_camera_stop_acquisition(camera, &err), err);
 }
 
 optional<CamError> AravisBackend::setAcquisitionMode(AcquisitionMode mode) {
     ArvAcquisitionMode arvMode = acq_mode_map.at(mode);
-    ARV_RET_OPT(arv_camera_set_acquisition_mode(camera, arvMode, &error), error);
+    GError *err = NULL;
+    ARV_RET_OPT(arv_camera_set_acquisition_mode(camera, arvMode, &err), err);
 }
 
 optional<CamError> AravisBackend::setPixelFormat(PixelFormat format) {
     ArvPixelFormat arvFormat = pixel_format_map.at(format);
-    ARV_RET_OPT(arv_camera_set_pixel_format(camera, arvFormat, &error), error);
+    GError *err = NULL;
+    ARV_RET_OPT(arv_camera_set_pixel_format(camera, arvFormat, &err), err);
 }
 
 optional<CamError> AravisBackend::setBinning(int dx, int dy) {
-    ARV_RET_OPT(arv_camera_set_binning(camera, dx, dy, &error), error);
+    GError *err = NULL;
+    ARV_RET_OPT(arv_camera_set_binning(camera, dx, dy, &err), err);
+}
+
+optional<CamError> AravisBackend::checkRegion(const Region &region) {
+    ArvDevice *device = arv_camera_get_device(camera);
+    GError *err = NULL;
+
+    // WidthMax/HeightMax already account for binning
+    gint64 width_max = arv_device_get_integer_feature_value(device, "WidthMax", &err);
+    ARV_CHECK_ERROR(err);
+    gint64 height_max = arv_device_get_integer_feature_value(device, "HeightMax", &err);
+    ARV_CHECK_ERROR(err);
+
+    gint width_min, height_min, unused;
+    arv_camera_get_width_bounds(camera, &width_min, &unused, &err);
+    ARV_CHECK_ERROR(err);
+    arv_camera_get_height_bounds(camera, &height_min, &unused, &err);
+    ARV_CHECK_ERROR(err);
+
+    gint x_inc = arv_camera_get_x_offset_increment(camera, &err);
+    ARV_CHECK_ERROR(err);
+    gint y_inc = arv_camera_get_y_offset_increment(camera, &err);
+    ARV_CHECK_ERROR(err);
+    gint width_inc = arv_camera_get_width_increment(camera, &err);
+    ARV_CHECK_ERROR(err);
+    gint height_inc = arv_camera_get_height_increment(camera, &err);
+    ARV_CHECK_ERROR(err);
+
+    if (region.width < width_min || region.height < height_min) {
+        return CamError { .message = "Region is smaller than the sensor minimum" };
+    }
+    if (region.x < 0 || region.y < 0
+        || region.x + region.width > width_max || region.y + region.height > height_max) {
+        return CamError { .message = "Region exceeds the sensor" };
+    }
+    if (region.x % max(x_inc, 1) != 0 || region.y % max(y_inc, 1) != 0
+        || region.width % max(width_inc, 1) != 0 || region.height % max(height_inc, 1) != 0) {
+        return CamError { .message = "Region is not aligned to the sensor increments" };
+    }
+    return nullopt;
+}
+
+optional<CamError> AravisBackend::setRegion(int x, int y, int width, int height) {
+    Region region { .x = x, .y = y, .width = width, .height = height };
+    if (auto err = checkRegion(region)) {
+        return err;
+    }
+
+    // Sets the offsets to zero first, so shrinking and moving never transiently overflows.
+    // The stream buffers follow the new payload on the next startAcquisition.
+    GError *err = NULL;
+    arv_camera_set_region(camera, x, y, width, height, &err);
+    ARV_CHECK_ERROR(err);
+    return nullopt;
+}
+
+optional<CamError> AravisBackend::setRegions(const vector<Region> &regions) {
+    if (regions.empty()) {
+        return CamError { .message = "No region given" };
+    }
+
+    if (feature("RegionSelector") == NULL) {
+        if (regions.size() > 1) {
+            return CamError { .message = "Multiple regions are not supported by this camera" };
+        }
+        return setRegion(regions[0].x, regions[0].y, regions[0].width, regions[0].height);
+    }
+
+    char selector[16];
+    for (size_t i = 0; i < regions.size(); i++) {
+        const Region &region = regions[i];
+
+        snprintf(selector, sizeof(selector), "Region%zu", i);
+        if (setStringFeature("RegionSelector", selector)) {
+            return CamError { .message = "Camera supports fewer regions than requested" };
+        }
+        if (auto err = setStringFeature("RegionMode", "On")) {
+            return err;
+        }
+
+        // Bounds and increments follow the selected region
+        if (auto err = checkRegion(region)) {
+            return err;
+        }
+        // Offsets go to zero first, so the new size never overflows the sensor
+        const pair<const char*, int> writes[] = {
+            { "OffsetX", 0 },
+            { "OffsetY", 0 },
+            { "Width", region.width },
+            { "Height", region.height },
+            { "OffsetX", region.x },
+            { "OffsetY", region.y },
+        };
+        for (const auto &[name, value] : writes) {
+            if (auto err = setIntegerFeature(name, value)) {
+                return err;
+            }
+        }
+    }
+
+    // Switch off the regions left over from an earlier, longer list
+    for (size_t i = regions.size(); ; i++) {
+        snprintf(selector, sizeof(selector), "Region%zu", i);
+        if (setStringFeature("RegionSelector", selector)) {
+            break;
+        }
+        if (auto err = setStringFeature("RegionMode", "Off")) {
+            return err;
+        }
+    }
+    return nullopt;
 }
 
 optional<CamError> AravisBackend::setGain(double gain) {
-    ARV_RET_OPT(arv_camera_set_gain(camera, gain, &error), error);
+    GError *err = NULL;
+    ARV_RET_OPT(arv_camera_set_gain(camera, gain, &err), err);
 }
 
 optional<CamError> AravisBackend::setAutoExposure(bool setAuto) {
+    GError *err = NULL;
     ARV_RET_OPT(arv_camera_set_exposure_time_auto(
         camera,
         setAuto ? ARV_AUTO_CONTINUOUS : ARV_AUTO_OFF,
-        &error
-    ), error);
+        &err
+    ), err);
 }
 
 optional<CamError> AravisBackend::setExposureTime(double exposure_time_us) {
+    GError *err = NULL;
     ARV_RET_OPT(
-        arv_camera_set_exposure_time(camera, exposure_time_us, &error),
-        error);
+        arv_camera_set_exposure_time(camera, exposure_time_us, &err),
+        err);
 }
 
 optional<CamError> AravisBackend::setFrameRate(double framerate) {
-    ARV_RET_OPT(arv_camera_set_frame_rate(camera, framerate, &error), error);
+    GError *err = NULL;
+    ARV_RET_OPT(arv_camera_set_frame_rate(camera, framerate, &err), err);
 }
 
-optional<CamError> AravisBackend::enableLensPower(bool enable) {
-    ArvDevice *device = arv_camera_get_device(camera);
-    GError *err = NULL;
+optional<CamError> AravisBackend::enablePtp(bool enable) {
+    // SFNC name first, then the older GigE Vision one
+    const char *name = feature("PtpEnable") != NULL ? "PtpEnable" : "GevIEEE1588";
+    if (feature(name) == NULL) {
+        return CamError { .message = "PTP is not supported by this camera" };
+    }
+    return setBooleanFeature(name, enable);
+}
 
-    // Try direct V3_3Enable node first
-    ArvGcNode *v33node = arv_device_get_feature(device, "V3_3Enable");
-    if (v33node == NULL) {
-        return CamError { .message = "V3_3Enable feature not found" };
+optional<CamError> AravisBackend::setTriggerMode(bool enable) {
+    // Frames are started by the trigger; other selectors are left alone
+    if (auto err = setStringFeature("TriggerSelector", "FrameStart")) {
+        return err;
     }
-    arv_device_set_boolean_feature_value(device, "V3_3Enable", enable, &err);
+    return setStringFeature("TriggerMode", enable ? "On" : "Off");
+}
+
+optional<CamError> AravisBackend::setTriggerSource(TriggerSource source) {
+    GError *err = NULL;
+    arv_camera_set_trigger_source(camera, trigger_source_map.at(source), &err);
     ARV_CHECK_ERROR(err);
     return nullopt;
 }
 
-optional<CamError> AravisBackend::setupLensSerial(const char* baudRate) {
-    ArvDevice *device = arv_camera_get_device(camera);
-    GError *err = NULL;
+optional<CamError> AravisBackend::setTriggerActivation(TriggerActivation activation) {
+    return setStringFeature("TriggerActivation", trigger_activation_map.at(activation));
+}
 
-    // Line0: Input (Rx) — LineSource not applicable for input lines
-    arv_device_set_string_feature_value(device, "LineSelector", "Line0", &err);
-    ARV_CHECK_ERROR(err);
-    arv_device_set_string_feature_value(device, "LineMode", "Input", &err);
-    ARV_CHECK_ERROR(err);
+optional<CamError> AravisBackend::setTriggerDelay(double delay_us) {
+    // SFNC name first, then the pre-SFNC 2.0 one
+    const char *name = feature("TriggerDelay") != NULL ? "TriggerDelay" : "TriggerDelayAbs";
+    return setFloatFeature(name, delay_us);
+}
 
-    // Line1: Output, source from SerialPort0 (Tx)
-    arv_device_set_string_feature_value(device, "LineSelector", "Line1", &err);
-    ARV_CHECK_ERROR(err);
-    arv_device_set_string_feature_value(device, "LineMode", "Output", &err);
-    ARV_CHECK_ERROR(err);
-    arv_device_set_string_feature_value(device, "LineSource", "SerialPort0", &err);
+optional<CamError> AravisBackend::fireSoftwareTrigger() {
+    // Stamp before the command goes out, so the latency covers the round trip;
+    // a rejected trigger is not counted
+    uint64_t fired_ns = hostTimeNs();
+    GError *err = NULL;
+    arv_camera_software_trigger(camera, &err);
     ARV_CHECK_ERROR(err);
+    stream->recordTrigger(fired_ns);
+    return nullopt;
+}
 
-    // SerialPort0 source from Line0
-    arv_device_set_string_feature_value(device, "SerialPortSelector", "SerialPort0", &err);
-    ARV_CHECK_ERROR(err);
-    arv_device_set_string_feature_value(device, "SerialPortSource", "Line0", &err);
-    ARV_CHECK_ERROR(err);
+optional<CamError> AravisBackend::enableLensPower(bool enable) {
+    if (feature("V3_3Enable") == NULL) {
+        return CamError { .message = "V3_3Enable feature not found" };
+    }
+    return setBooleanFeature("V3_3Enable", enable);
+}
 
-    // Set baud rate
-    arv_device_set_string_feature_value(device, "SerialPortBaudRate", baudRate, &err);
-    ARV_CHECK_ERROR(err);
+optional<CamError> AravisBackend::setupLensSerial(const char* baudRate) {
+    static const pair<const char*, const char*> lines[] = {
+        // Line0: Input (Rx) — LineSource not applicable for input lines
+        { "LineSelector", "Line0" },
+        { "LineMode", "Input" },
+        // Line1: Output, source from SerialPort0 (Tx)
+        { "LineSelector", "Line1" },
+        { "LineMode", "Output" },
+        { "LineSource", "SerialPort0" },
+        // SerialPort0 source from Line0
+        { "SerialPortSelector", "SerialPort0" },
+        { "SerialPortSource", "Line0" },
+    };
+    for (const auto &[name, value] : lines) {
+        if (auto err = setStringFeature(name, value)) {
+            return err;
+        }
+    }
 
-    // Select SerialPort0 as the file for file access operations
-    arv_device_set_string_feature_value(device, "FileSelector", "SerialPort0", &err);
-    ARV_CHECK_ERROR(err);
+    // Set baud rate
+    if (auto err = setStringFeature("SerialPortBaudRate", baudRate)) {
+        return err;
+    }
 
-    // Open the serial port for writing
-    arv_device_set_string_feature_value(device, "FileOpenMode", "Write", &err);
-    ARV_CHECK_ERROR(err);
-    arv_device_set_string_feature_value(device, "FileOperationSelector", "Open", &err);
-    ARV_CHECK_ERROR(err);
-    arv_device_execute_command(device, "FileOperationExecute", &err);
-    ARV_CHECK_ERROR(err);
-    printf("  [serial] SerialPort0 opened for Write\n");
+    // Select SerialPort0 as the file for file access operations, and open it for writing
+    static const pair<const char*, const char*> file[] = {
+        { "FileSelector", "SerialPort0" },
+        { "FileOpenMode", "Write" },
+        { "FileOperationSelector", "Open" },
+    };
+    for (const auto &[name, value] : file) {
+        if (auto err = setStringFeature(name, value)) {
+            return err;
+        }
+    }
+    if (auto err = executeCommand("FileOperationExecute")) {
+        return err;
+    }
+    CYNLR_LOG(LogLevel::LOG_LEVEL_INFO, "  [serial] SerialPort0 opened for Write\n");
     serial_port_open = true;
+    // FileOperationSelector now reads Open
+    serial_write_length = -1;
 
     return nullopt;
 }
@@ -212,56 +431,382 @@ optional<CamError> AravisBackend::setLensFocus(double voltage) {
     return writeSerialFileAccess(packet, sizeof(packet));
 }
 
-optional<CamError> AravisBackend::writeSerialFileAccess(const void* data, size_t length) {
-    ArvDevice *device = arv_camera_get_device(camera);
+optional<CamError> AravisBackend::setLensResultCheck(bool enable) {
+    lens_result_check = enable;
+    return nullopt;
+}
+
+optional<CamError> AravisBackend::checkLensResult() {
+    if (serial_write_length < 0) {
+        return CamError { .message = "No lens command to check" };
+    }
+    return readSerialResult();
+}
+
+optional<CamError> AravisBackend::enableChunks(const vector<ChunkSelector> &chunks) {
+    if (feature("ChunkModeActive") == NULL) {
+        if (chunks.empty()) {
+            return nullopt;
+        }
+        return CamError { .message = "Camera does not support chunk data" };
+    }
+
+    // ChunkEnable is only writable while chunk mode is off on many cameras
+    if (auto err = setBooleanFeature("ChunkModeActive", false)) {
+        return err;
+    }
+    for (const auto &[chunk, names] : chunk_selector_map) {
+        bool enable = find(chunks.begin(), chunks.end(), chunk) != chunks.end();
+        if (setStringFeature("ChunkSelector", names.first)) {
+            if (enable) {
+                return CamError { .message = "Camera cannot send the chunk" };
+            }
+            // Not offered by this camera, so already off
+            continue;
+        }
+        auto err = setBooleanFeature("ChunkEnable", enable);
+        if (err && enable) {
+            return err;
+        }
+    }
+    if (!chunks.empty()) {
+        if (auto err = setBooleanFeature("ChunkModeActive", true)) {
+            return err;
+        }
+    }
+
+    if (auto err = stream->setChunks(arv_camera_get_device(camera), chunks)) {
+        return CamError { .message = err->message };
+    }
+    return nullopt;
+}
+
+optional<CamError> AravisBackend::configureTransport(const TransportConfig &config) {
+    bool camera_settings = config.auto_packet_size || config.packet_size || config.packet_delay_ns;
+    if (camera_settings && !arv_camera_is_gv_device(camera)) {
+        return CamError { .message = "Transport settings need a GigE camera" };
+    }
+
     GError *err = NULL;
+    if (config.auto_packet_size) {
+        guint packet_size = arv_camera_gv_auto_packet_size(camera, &err);
+        ARV_CHECK_ERROR(err);
+        CYNLR_LOG(LogLevel::LOG_LEVEL_INFO, "  [transport] packet size %u bytes\n", packet_size);
+    } else if (config.packet_size) {
+        arv_camera_gv_set_packet_size(camera, static_cast<gint>(*config.packet_size), &err);
+        ARV_CHECK_ERROR(err);
+    }
+    if (config.packet_delay_ns) {
+        arv_camera_gv_set_packet_delay(camera, *config.packet_delay_ns, &err);
+        ARV_CHECK_ERROR(err);
+    }
 
-    const uint8_t* bytes = static_cast<const uint8_t*>(data);
-    printf("  [serial] write len=%zu data=", length);
-    for (size_t i = 0; i < length; i++) printf("%02X", bytes[i]);
-    printf("\n");
+    if (auto stream_err = stream->configureReceiver(config)) {
+        return CamError { .message = stream_err->message };
+    }
+    return nullopt;
+}
 
-    // Ensure FileSelector points to SerialPort0 (may have changed since setupLensSerial)
-    arv_device_set_string_feature_value(device, "FileSelector", "SerialPort0", &err);
+optional<CamError> AravisBackend::getTransportReport(TransportReport &report) {
+    if (!arv_camera_is_gv_device(camera)) {
+        return CamError { .message = "Transport report needs a GigE camera" };
+    }
+
+    GError *err = NULL;
+    report = TransportReport();
+    report.packet_size = static_cast<uint32_t>(arv_camera_gv_get_packet_size(camera, &err));
+    ARV_CHECK_ERROR(err);
+    report.packet_delay_ns = arv_camera_gv_get_packet_delay(camera, &err);
     ARV_CHECK_ERROR(err);
+    report.payload_size = arv_camera_get_payload(camera, &err);
+    ARV_CHECK_ERROR(err);
+    double frame_rate = arv_camera_get_frame_rate(camera, &err);
+    ARV_CHECK_ERROR(err);
+    report.link_bps = linkSpeed();
+
+    // The camera sends a packet at link speed, then waits out the packet delay
+    double packet_bits = packetWireBits(report.packet_size);
+    report.burst_bps = packet_bits / (packet_bits / report.link_bps + report.packet_delay_ns * 1e-9);
+
+    double frame_bits = frameWireBits(report.payload_size, report.packet_size);
+    StreamStats stats = stream->getStreamStats();
+    report.required_bps = frame_bits * frame_rate;
+    report.achieved_bps = frame_bits * stats.fps;
+    report.utilization = report.achieved_bps / report.link_bps;
+    report.missing_packets = stats.missing_packets;
+    report.resent_packets = stats.resent_packets;
+    return nullopt;
+}
 
-    // FileAccessOffset = 0
-    arv_device_set_integer_feature_value(device, "FileAccessOffset", 0, &err);
+optional<CamError> AravisBackend::autoConfigureTransport(
+    const vector<AravisBackend*> &cameras,
+    double headroom)
+{
+    if (headroom <= 0.0 || headroom > 1.0) {
+        return CamError { .message = "Transport headroom out of range" };
+    }
+
+    typedef struct Demand {
+        uint32_t packet_size;
+        double link_bps;
+        double required_bps;    // on-wire rate at the camera's frame rate
+    } Demand;
+
+    vector<Demand> demands;
+    double link_bps = 0.0;
+    double total_bps = 0.0;
+    for (AravisBackend *backend : cameras) {
+        TransportConfig config;
+        config.auto_packet_size = true;
+        if (auto err = backend->configureTransport(config)) {
+            return err;
+        }
+
+        GError *err = NULL;
+        Demand demand;
+        demand.packet_size = static_cast<uint32_t>(arv_camera_gv_get_packet_size(backend->camera, &err));
+        ARV_CHECK_ERROR(err);
+        size_t payload = arv_camera_get_payload(backend->camera, &err);
+        ARV_CHECK_ERROR(err);
+        double frame_rate = arv_camera_get_frame_rate(backend->camera, &err);
+        ARV_CHECK_ERROR(err);
+        demand.link_bps = backend->linkSpeed();
+        demand.required_bps = frameWireBits(payload, demand.packet_size) * frame_rate;
+
+        // The NIC is taken to be no faster than the slowest camera link
+        link_bps = link_bps == 0.0 ? demand.link_bps : min(link_bps, demand.link_bps);
+        total_bps += demand.required_bps;
+        demands.push_back(demand);
+    }
+    if (demands.empty()) {
+        return nullopt;
+    }
+
+    double budget_bps = link_bps * headroom;
+    if (total_bps > budget_bps) {
+        return CamError { .message = "Cameras need more bandwidth than the link carries" };
+    }
+
+    for (size_t i = 0; i < demands.size(); i++) {
+        const Demand &demand = demands[i];
+        double share_bps = total_bps > 0.0
+            ? budget_bps * demand.required_bps / total_bps
+            : budget_bps / static_cast<double>(demands.size());
+
+        // Space packets so the camera's bursts stay within its share
+        double packet_bits = packetWireBits(demand.packet_size);
+        double delay_s = packet_bits / share_bps - packet_bits / demand.link_bps;
+
+        TransportConfig config;
+        config.packet_delay_ns = max<int64_t>(0, llround(delay_s * 1e9));
+        if (auto err = cameras[i]->configureTransport(config)) {
+            return err;
+        }
+        CYNLR_LOG(LogLevel::LOG_LEVEL_INFO, "  [transport] camera %zu: packet %u bytes, delay %lld ns, %.0f of %.0f Mbit/s\n",
+            i, demand.packet_size, (long long)*config.packet_delay_ns,
+            demand.required_bps / 1e6, share_bps / 1e6);
+    }
+    return nullopt;
+}
+
+double AravisBackend::linkSpeed() {
+    ArvGcNode *node = feature("GevLinkSpeed");
+    if (node != NULL) {
+        GError *err = NULL;
+        gint64 mbps = arv_gc_integer_get_value(ARV_GC_INTEGER(node), &err);
+        if (err == NULL && mbps > 0) {
+            return static_cast<double>(mbps) * 1e6;
+        }
+        g_clear_error(&err);
+    }
+    return GIGE_DEFAULT_LINK_BPS;
+}
+
+optional<CamError> AravisBackend::writeSerialFileAccess(const void* data, size_t length) {
+    if (logEnabled(LogLevel::LOG_LEVEL_DEBUG)) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        char hex[2 * 16 + 1] = "";
+        for (size_t i = 0; i < length && i < 16; i++) {
+            snprintf(hex + 2 * i, 3, "%02X", bytes[i]);
+        }
+        logMessage(LogLevel::LOG_LEVEL_DEBUG, "  [serial] write len=%zu data=%s\n", length, hex);
+    }
+
+    // Sent again from scratch if this write fails part way
+    gint64 written_length = serial_write_length;
+    serial_write_length = -1;
+
+    if (written_length < 0) {
+        // FileOperationSelector = "Write" must be set BEFORE writing FileAccessBuffer
+        if (auto err = setStringFeature("FileSelector", "SerialPort0")) {
+            return err;
+        }
+        if (auto err = setIntegerFeature("FileAccessOffset", 0)) {
+            return err;
+        }
+        if (auto err = setStringFeature("FileOperationSelector", "Write")) {
+            return err;
+        }
+    }
+    if (written_length != (gint64)length) {
+        if (auto err = setIntegerFeature("FileAccessLength", (gint64)length)) {
+            return err;
+        }
+    }
+
+    // FileAccessBuffer — write directly at physical address
+    guint64 reg_addr;
+    if (auto err = registerAddress("FileAccessBuffer", reg_addr)) {
+        return err;
+    }
+    GError *err = NULL;
+    arv_device_write_memory(arv_camera_get_device(camera), reg_addr, (guint32)length, const_cast<void*>(data), &err);
     ARV_CHECK_ERROR(err);
 
-    // FileAccessLength
-    arv_device_set_integer_feature_value(device, "FileAccessLength", (gint64)length, &err);
+    if (auto exec_err = executeCommand("FileOperationExecute")) {
+        return exec_err;
+    }
+    serial_write_length = (gint64)length;
+
+    if (lens_result_check) {
+        return readSerialResult();
+    }
+    return nullopt;
+}
+
+optional<CamError> AravisBackend::readSerialResult() {
+    ArvGcNode *node = feature("FileOperationResult");
+    if (node == NULL) {
+        return CamError { .message = "FileOperationResult feature not found" };
+    }
+
+    GError *err = NULL;
+    gint64 result = arv_gc_integer_get_value(ARV_GC_INTEGER(node), &err);
     ARV_CHECK_ERROR(err);
-    printf("  [serial] FileAccessLength=%zu OK\n", length);
 
-    // FileOperationSelector = "Write" (must be BEFORE writing FileAccessBuffer)
-    arv_device_set_string_feature_value(device, "FileOperationSelector", "Write", &err);
+    CYNLR_LOG(LogLevel::LOG_LEVEL_DEBUG, "  [serial] FileOperationExecute result=%lld bytes\n", (long long)result);
+    if (result != serial_write_length) {
+        CYNLR_LOG(LogLevel::LOG_LEVEL_WARNING, "  [serial] wrote %lld of %lld bytes\n",
+            (long long)result, (long long)serial_write_length);
+        return CamError { .message = "Lens command was not fully written" };
+    }
+    return nullopt;
+}
+
+ArvGcNode *AravisBackend::feature(const char *name) {
+    auto found = feature_nodes.find(name);
+    if (found != feature_nodes.end()) {
+        return found->second;
+    }
+
+    // Misses are cached too, so probing for optional features stays cheap
+    ArvGcNode *node = arv_device_get_feature(arv_camera_get_device(camera), name);
+    feature_nodes.emplace(name, node);
+    return node;
+}
+
+optional<CamError> AravisBackend::enumEntryValue(const char *name, ArvGcNode *node, const char *entry, gint64 &value) {
+    string key = string(name) + "/" + entry;
+    auto found = enum_entries.find(key);
+    if (found != enum_entries.end()) {
+        value = found->second;
+        return nullopt;
+    }
+
+    const GSList *entries = arv_gc_enumeration_get_entries(ARV_GC_ENUMERATION(node));
+    for (const GSList *it = entries; it != NULL; it = it->next) {
+        ArvGcFeatureNode *entry_node = ARV_GC_FEATURE_NODE(it->data);
+        if (strcmp(arv_gc_feature_node_get_name(entry_node), entry) != 0) {
+            continue;
+        }
+        GError *err = NULL;
+        value = arv_gc_enum_entry_get_value(ARV_GC_ENUM_ENTRY(it->data), &err);
+        ARV_CHECK_ERROR(err);
+        enum_entries.emplace(key, value);
+        return nullopt;
+    }
+    return CamError { .message = "GenICam enumeration entry not found" };
+}
+
+optional<CamError> AravisBackend::setStringFeature(const char *name, const char *value) {
+    ArvGcNode *node = feature(name);
+    if (node == NULL) {
+        return CamError { .message = "GenICam feature not found" };
+    }
+    GError *err = NULL;
+    if (ARV_IS_GC_ENUMERATION(node)) {
+        // Write the cached entry value rather than resolving the name again
+        gint64 entry_value;
+        if (auto entry_err = enumEntryValue(name, node, value, entry_value)) {
+            return entry_err;
+        }
+        arv_gc_enumeration_set_int_value(ARV_GC_ENUMERATION(node), entry_value, &err);
+    } else {
+        arv_gc_feature_node_set_value_from_string(ARV_GC_FEATURE_NODE(node), value, &err);
+    }
     ARV_CHECK_ERROR(err);
+    return nullopt;
+}
 
-    // FileAccessBuffer — write directly at physical address
-    ArvGc *genicam = arv_device_get_genicam(device);
-    ArvGcNode *buffer_node = arv_gc_get_node(genicam, "FileAccessBuffer");
-    if (buffer_node == NULL) {
-        return CamError { .message = "FileAccessBuffer node not found" };
+optional<CamError> AravisBackend::setIntegerFeature(const char *name, gint64 value) {
+    ArvGcNode *node = feature(name);
+    if (node == NULL) {
+        return CamError { .message = "GenICam feature not found" };
     }
+    GError *err = NULL;
+    arv_gc_integer_set_value(ARV_GC_INTEGER(node), value, &err);
+    ARV_CHECK_ERROR(err);
+    return nullopt;
+}
 
-    GError *addr_err = NULL;
-    guint64 reg_addr = arv_gc_register_get_address(ARV_GC_REGISTER(buffer_node), &addr_err);
-    arv_device_write_memory(device, reg_addr, (guint32)length, const_cast<void*>(data), &err);
+optional<CamError> AravisBackend::setFloatFeature(const char *name, double value) {
+    ArvGcNode *node = feature(name);
+    if (node == NULL) {
+        return CamError { .message = "GenICam feature not found" };
+    }
+    GError *err = NULL;
+    arv_gc_float_set_value(ARV_GC_FLOAT(node), value, &err);
     ARV_CHECK_ERROR(err);
+    return nullopt;
+}
 
-    printf("  [serial] FileAccessBuffer OK\n");
+optional<CamError> AravisBackend::setBooleanFeature(const char *name, bool value) {
+    ArvGcNode *node = feature(name);
+    if (node == NULL) {
+        return CamError { .message = "GenICam feature not found" };
+    }
+    GError *err = NULL;
+    arv_gc_boolean_set_value(ARV_GC_BOOLEAN(node), value, &err);
+    ARV_CHECK_ERROR(err);
+    return nullopt;
+}
 
-    // FileOperationExecute
-    arv_device_execute_command(device, "FileOperationExecute", &err);
+optional<CamError> AravisBackend::executeCommand(const char *name) {
+    ArvGcNode *node = feature(name);
+    if (node == NULL) {
+        return CamError { .message = "GenICam feature not found" };
+    }
+    GError *err = NULL;
+    arv_gc_command_execute(ARV_GC_COMMAND(node), &err);
     ARV_CHECK_ERROR(err);
-    gint64 result = arv_device_get_integer_feature_value(device, "FileOperationResult", &err);
-    if (err != NULL) {
-        g_clear_error(&err);
-    } else {
-        printf("  [serial] FileOperationExecute OK, result=%lld bytes\n", (long long)result);
+    return nullopt;
+}
+
+optional<CamError> AravisBackend::registerAddress(const char *name, guint64 &address) {
+    auto found = register_addresses.find(name);
+    if (found != register_addresses.end()) {
+        address = found->second;
+        return nullopt;
     }
 
+    ArvGcNode *node = feature(name);
+    if (node == NULL) {
+        return CamError { .message = "GenICam register not found" };
+    }
+    GError *err = NULL;
+    address = arv_gc_register_get_address(ARV_GC_REGISTER(node), &err);
+    ARV_CHECK_ERROR(err);
+    register_addresses.emplace(name, address);
     return nullopt;
 }
 
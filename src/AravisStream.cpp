@@ -1,59 +1,305 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
 #include "AravisStream.hpp"
+#include "AravisBackend.hpp"
 
 using namespace std;
 using namespace cynlr::camera;
 
-optional<StreamError> AravisStream::borrowOldestFrame(FrameBuffer &frame) {
-    int output_buffer_count;
-    
-    arv_stream_get_n_buffers(m_stream, NULL, &output_buffer_count);
+static PixelFormat toPixelFormat(ArvPixelFormat format) {
+    for (const auto &[pixel_format, arv_format] : pixel_format_map) {
+        if (arv_format == format) {
+            return pixel_format;
+        }
+    }
+    return PixelFormat::UNKNOWN;
+}
 
-    /* Discard all but the last buffer */
-    for (int i = 0; i < output_buffer_count-1; i++) {
-        ArvBuffer *buffer = arv_stream_pop_buffer(m_stream);
-        arv_stream_push_buffer(m_stream, buffer);
+/* Every ArvBuffer holds a reference to the arena its memory lives in, so a
+ * frame borrowed across a pool resize never points at freed memory. */
+static void releasePoolReference(gpointer user_data) {
+    delete static_cast<shared_ptr<BufferPool>*>(user_data);
+}
+
+optional<StreamError> AravisStream::prepareBuffers(size_t payload, uint32_t count) {
+    if (m_pool && m_pool->bufferSize() == payload && m_pool->count() == count) {
+        /* Same geometry: keep the buffers in circulation */
+        void *stale = takeLatest();
+        if (stale != nullptr) {
+            pushBuffer(stale);
+        }
+        discardQueuedFrames(0);
+        return nullopt;
+    }
+
+    bool restart_worker = workerRunning();
+    stopWorker();
+
+    void *stale = takeLatest();
+    if (stale != nullptr) {
+        pushBuffer(stale);
+    }
+
+    bool thread_stopped = false;
+    if (m_pool) {
+        /* Drop the stream's references to the old buffers */
+        arv_stream_stop_thread(m_stream, TRUE);
+        thread_stopped = true;
+    }
+
+    shared_ptr<BufferPool> pool = BufferPool::create(payload, count, m_pool_config);
+    if (pool) {
+        m_pool = pool;
+        m_current_pool = pool.get();
+
+        for (uint32_t i = 0; i < count; i++) {
+            ArvBuffer *buffer = arv_buffer_new_full(
+                payload,
+                m_pool->buffer(i),
+                new shared_ptr<BufferPool>(m_pool),
+                releasePoolReference);
+            arv_stream_push_buffer(m_stream, buffer);
+        }
+    } else {
+        m_pool = nullptr;
+        m_current_pool = nullptr;
     }
 
-    return populateFrameBuffer(frame);
+    if (thread_stopped) {
+        arv_stream_start_thread(m_stream);
+    }
+    if (restart_worker) {
+        startWorker();
+    }
+
+    if (!pool) {
+        return StreamError { .message = "Failed to allocate stream buffer pool" };
+    }
+    return nullopt;
 }
 
-optional<StreamError> AravisStream::borrowNewestFrame(FrameBuffer &frame) {
-    return populateFrameBuffer(frame);
+optional<StreamError> AravisStream::setChunks(ArvDevice *device, const vector<ChunkSelector> &chunks) {
+    lock_guard<mutex> lock(m_chunk_mutex);
+    m_parse_chunks = false;
+    m_chunk_nodes.clear();
+    if (chunks.empty()) {
+        return nullopt;
+    }
+
+    if (m_chunk_genicam == nullptr) {
+        /* A parser of its own: binding the device's description to a buffer
+         * would race with feature access on the control thread */
+        size_t size = 0;
+        const char *xml = arv_device_get_genicam_xml(device, &size);
+        if (xml == NULL) {
+            return StreamError { .message = "Could not read the GenICam description" };
+        }
+        m_chunk_genicam = arv_gc_new(NULL, xml, size);
+    }
+
+    for (ChunkSelector chunk : chunks) {
+        ArvGcNode *node = arv_gc_get_node(m_chunk_genicam, chunk_selector_map.at(chunk).second);
+        if (node == NULL) {
+            m_chunk_nodes.clear();
+            return StreamError { .message = "Camera describes no node for the chunk" };
+        }
+        m_chunk_nodes.push_back(ChunkNode { .chunk = chunk, .node = node, .is_float = ARV_IS_GC_FLOAT(node) != FALSE });
+    }
+    m_parse_chunks = true;
+    return nullopt;
 }
 
-optional<StreamError> AravisStream::borrowNextNewFrame(FrameBuffer &frame) {
-    int output_buffer_count;
-    
-    arv_stream_get_n_buffers(m_stream, NULL, &output_buffer_count);
+void AravisStream::parseChunks(ArvBuffer *buffer, FrameChunks &chunks) {
+    lock_guard<mutex> lock(m_chunk_mutex);
+    if (m_chunk_nodes.empty()) {
+        return;
+    }
+
+    arv_gc_set_buffer(m_chunk_genicam, buffer);
+    for (const ChunkNode &chunk : m_chunk_nodes) {
+        GError *err = NULL;
+        double float_value = 0.0;
+        gint64 integer_value = 0;
+        if (chunk.is_float) {
+            float_value = arv_gc_float_get_value(ARV_GC_FLOAT(chunk.node), &err);
+            integer_value = static_cast<gint64>(float_value);
+        } else {
+            integer_value = arv_gc_integer_get_value(ARV_GC_INTEGER(chunk.node), &err);
+            float_value = static_cast<double>(integer_value);
+        }
+        if (err != NULL) {
+            /* This buffer lacks the chunk; leave the field empty */
+            g_clear_error(&err);
+            continue;
+        }
 
-    /* Discard ALL buffers */
-    for (int i = 0; i < output_buffer_count; i++) {
-        ArvBuffer *buffer = arv_stream_pop_buffer(m_stream);
+        switch (chunk.chunk) {
+            case ChunkSelector::EXPOSURE_TIME:
+                chunks.exposure_time_us = float_value;
+                break;
+            case ChunkSelector::GAIN:
+                chunks.gain = float_value;
+                break;
+            case ChunkSelector::TIMESTAMP:
+                chunks.timestamp = static_cast<uint64_t>(integer_value);
+                break;
+            case ChunkSelector::FRAME_ID:
+                chunks.frame_id = static_cast<uint64_t>(integer_value);
+                break;
+            case ChunkSelector::LINE_STATUS_ALL:
+                chunks.line_status_all = static_cast<uint64_t>(integer_value);
+                break;
+            case ChunkSelector::COUNTER_VALUE:
+                chunks.counter_value = static_cast<uint64_t>(integer_value);
+                break;
+        }
+    }
+}
+
+optional<StreamError> AravisStream::configureReceiver(const TransportConfig &config) {
+    bool gige_settings = config.socket_buffer_size || config.packet_resend
+        || config.packet_timeout_us || config.frame_retention_us;
+    if (gige_settings && !ARV_IS_GV_STREAM(m_stream)) {
+        return StreamError { .message = "Receive settings need a GigE stream" };
+    }
+
+    if (config.socket_buffer_size) {
+        if (*config.socket_buffer_size == 0) {
+            g_object_set(m_stream, "socket-buffer", ARV_GV_STREAM_SOCKET_BUFFER_AUTO, NULL);
+        } else {
+            gint size = static_cast<gint>(min<size_t>(*config.socket_buffer_size, INT_MAX));
+            g_object_set(m_stream,
+                "socket-buffer", ARV_GV_STREAM_SOCKET_BUFFER_FIXED,
+                "socket-buffer-size", size,
+                NULL);
+        }
+    }
+    if (config.packet_resend) {
+        ArvGvStreamPacketResend resend = *config.packet_resend == PacketResend::ALWAYS
+            ? ARV_GV_STREAM_PACKET_RESEND_ALWAYS : ARV_GV_STREAM_PACKET_RESEND_NEVER;
+        g_object_set(m_stream, "packet-resend", resend, NULL);
+    }
+    if (config.packet_timeout_us) {
+        g_object_set(m_stream, "packet-timeout", static_cast<guint>(*config.packet_timeout_us), NULL);
+    }
+    if (config.frame_retention_us) {
+        g_object_set(m_stream, "frame-retention", static_cast<guint>(*config.frame_retention_us), NULL);
+    }
+
+    if (config.thread_priority) {
+        if (!m_thread_priority) {
+            return StreamError { .message = "Stream thread priority cannot be changed" };
+        }
+        if (m_thread_priority->exchange(*config.thread_priority) != *config.thread_priority) {
+            /* The stream callback applies the priority when the thread starts */
+            arv_stream_stop_thread(m_stream, FALSE);
+            arv_stream_start_thread(m_stream);
+        }
+    }
+    return nullopt;
+}
+
+void *AravisStream::popBuffer(chrono::microseconds timeout) {
+    ArvBuffer *buffer;
+    if (timeout == WAIT_FOREVER) {
+        buffer = arv_stream_pop_buffer(m_stream);
+    } else if (timeout <= NO_WAIT) {
+        buffer = arv_stream_try_pop_buffer(m_stream);
+    } else {
+        buffer = arv_stream_timeout_pop_buffer(m_stream, static_cast<guint64>(timeout.count()));
+    }
+
+    return ARV_IS_BUFFER(buffer) ? static_cast<void*>(buffer) : nullptr;
+}
+
+void AravisStream::pushBuffer(void *data) {
+    ArvBuffer *buffer = static_cast<ArvBuffer*>(data);
+    auto *owner = static_cast<shared_ptr<BufferPool>*>(arv_buffer_get_user_data(buffer));
+    if (owner != nullptr && owner->get() == m_current_pool.load()) {
         arv_stream_push_buffer(m_stream, buffer);
+    } else {
+        /* Left over from before the pool was resized */
+        g_object_unref(buffer);
     }
+}
+
+int AravisStream::queuedFrameCount() {
+    int output_buffer_count;
 
-    return populateFrameBuffer(frame);
+    arv_stream_get_n_buffers(m_stream, NULL, &output_buffer_count);
+    return output_buffer_count;
 }
 
-void AravisStream::releaseFrame(FrameBuffer &frame) {
-    arv_stream_push_buffer(m_stream, static_cast<ArvBuffer*>(frame.parent_buffer));
+int AravisStream::freeBufferCount() {
+    int input_buffer_count;
+
+    arv_stream_get_n_buffers(m_stream, &input_buffer_count, NULL);
+    return input_buffer_count;
 }
 
-optional<StreamError> AravisStream::populateFrameBuffer(FrameBuffer &frame) {
-    ArvBuffer *buffer = arv_stream_pop_buffer(m_stream);
-    if (ARV_IS_BUFFER(buffer)) {
-        if (arv_buffer_get_status(buffer) != ARV_BUFFER_STATUS_SUCCESS) {
-            printf("Warning: Borrowed frame has status %d\n", arv_buffer_get_status(buffer));
-            return StreamError { .message = "Buffer population failed" };
+void AravisStream::transportCounters(StreamStats &stats) {
+    guint64 completed, failures, underruns;
+    arv_stream_get_statistics(m_stream, &completed, &failures, &underruns);
+    stats.completed = completed;
+    stats.failures = failures;
+    stats.underruns = underruns;
+
+    /* Packet counters only exist on GigE streams */
+    guint n_infos = arv_stream_get_n_infos(m_stream);
+    for (guint i = 0; i < n_infos; i++) {
+        const char *name = arv_stream_get_info_name(m_stream, i);
+        if (strcmp(name, "n_missing_packets") == 0) {
+            stats.missing_packets = arv_stream_get_info_uint64_by_name(m_stream, name);
+        } else if (strcmp(name, "n_resent_packets") == 0) {
+            stats.resent_packets = arv_stream_get_info_uint64_by_name(m_stream, name);
         }
-        size_t size;
-        frame.parent_buffer = static_cast<void*>(buffer);
-        frame.data = const_cast<void*>(arv_buffer_get_data(buffer, &size));
-        frame.width = arv_buffer_get_image_width(buffer);
-        frame.height = arv_buffer_get_image_height(buffer);
+    }
+}
 
-        return nullopt;
+FrameStatus AravisStream::bufferStatus(void *buffer) {
+    /* FrameStatus mirrors ArvBufferStatus value for value */
+    return static_cast<FrameStatus>(arv_buffer_get_status(static_cast<ArvBuffer*>(buffer)));
+}
+
+uint64_t AravisStream::bufferCompletedNs(void *buffer) {
+    return arv_buffer_get_system_timestamp(static_cast<ArvBuffer*>(buffer));
+}
+
+void AravisStream::fillFrameBuffer(void *data, FrameBuffer &frame) {
+    ArvBuffer *buffer = static_cast<ArvBuffer*>(data);
+    size_t size;
+    frame.parent_buffer = data;
+    frame.data = const_cast<void*>(arv_buffer_get_data(buffer, &size));
+    frame.width = arv_buffer_get_image_width(buffer);
+    frame.height = arv_buffer_get_image_height(buffer);
+    frame.channels = 1;  // all supported pixel formats are monochrome
+
+    ArvPixelFormat arv_format = arv_buffer_get_image_pixel_format(buffer);
+    gint x_padding = 0;
+    gint y_padding = 0;
+    arv_buffer_get_image_padding(buffer, &x_padding, &y_padding);
+
+    frame.offset_x = arv_buffer_get_image_x(buffer);
+    frame.offset_y = arv_buffer_get_image_y(buffer);
+    /* Without line padding, packed rows that do not fill whole bytes run on
+     * into each other and the image is one bit stream (stride 0) */
+    size_t row_bits = static_cast<size_t>(frame.width) * ARV_PIXEL_FORMAT_BIT_PER_PIXEL(arv_format);
+    if (row_bits % 8 != 0 && x_padding == 0) {
+        frame.stride = 0;
+    } else {
+        frame.stride = (row_bits + 7) / 8 + static_cast<size_t>(x_padding);
     }
+    frame.payload_size = size;
+    frame.pixel_format = toPixelFormat(arv_format);
+    frame.frame_id = arv_buffer_get_frame_id(buffer);
+    frame.timestamp_ns = arv_buffer_get_timestamp(buffer);
+    frame.system_timestamp_ns = arv_buffer_get_system_timestamp(buffer);
+    frame.status = static_cast<FrameStatus>(arv_buffer_get_status(buffer));
 
-    return StreamError { .message = "Failed to populate frame buffer" };
-}
\ No newline at end of file
+    frame.chunks = FrameChunks();
+    if (m_parse_chunks && arv_buffer_has_chunks(buffer)) {
+        parseChunks(buffer, frame.chunks);
+    }
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <thread>
+
+#include "Autofocus.hpp"
+#include "PixelConvert.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+/* 1 / golden ratio */
+#define INV_PHI 0.6180339887498949
+
+optional<CamError> Autofocus::run(AutofocusResult &result) {
+    if (m_config.min_voltage < 24.0 || m_config.max_voltage > 70.0
+        || m_config.min_voltage >= m_config.max_voltage || m_config.tolerance <= 0.0
+        || m_config.coarse_steps < 3 || m_config.max_frames == 0) {
+        return CamError { .message = "Invalid autofocus configuration" };
+    }
+
+    auto start = chrono::steady_clock::now();
+    m_frames = 0;
+    m_evaluations = 0;
+    m_exhausted = false;
+    m_best_voltage = m_config.min_voltage;
+    m_best_sharpness = -1.0;
+
+    optional<CamError> err;
+    switch (m_config.search) {
+        case FocusSearch::GOLDEN_SECTION: err = goldenSection(); break;
+        case FocusSearch::COARSE_TO_FINE: err = coarseToFine(); break;
+    }
+    if (err) {
+        return err;
+    }
+    if (m_evaluations == 0) {
+        return CamError { .message = "No frame could be scored within the autofocus frame budget" };
+    }
+
+    /* Leave the lens at the best voltage seen, not the last one tried */
+    ControlResult focus = m_camera.setLensFocusAsync(m_best_voltage).get();
+    if (focus.error) {
+        return focus.error;
+    }
+    this_thread::sleep_for(chrono::microseconds(m_config.settle_time_us));
+
+    result.voltage = m_best_voltage;
+    result.sharpness = m_best_sharpness;
+    result.evaluations = m_evaluations;
+    result.frames = m_frames;
+    result.converged = !m_exhausted;
+    result.time_to_focus = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+    return nullopt;
+}
+
+optional<CamError> Autofocus::evaluate(double voltage, double &sharpness) {
+    ControlResult focus = m_camera.setLensFocusAsync(voltage).get();
+    if (focus.error) {
+        return focus.error;
+    }
+
+    /* Frames exposed while the lens was still moving show a mix of voltages */
+    uint64_t ready_ns = focus.completed_ns
+        + (static_cast<uint64_t>(m_config.settle_time_us) + m_config.frame_latency_us) * 1000;
+
+    FrameHandle frame;
+    while (m_frames < m_config.max_frames) {
+        if (auto err = m_camera.borrowNextNewFrame(frame, m_config.frame_timeout)) {
+            return CamError { .message = err->message };
+        }
+        m_frames++;
+
+        const FrameBuffer &buffer = frame.frame();
+        if (buffer.system_timestamp_ns < ready_ns || buffer.status != FrameStatus::SUCCESS) {
+            continue;
+        }
+
+        if (auto err = measure(buffer, sharpness)) {
+            return CamError { .message = err->message };
+        }
+        m_evaluations++;
+        if (sharpness > m_best_sharpness) {
+            m_best_sharpness = sharpness;
+            m_best_voltage = voltage;
+        }
+        return nullopt;
+    }
+
+    m_exhausted = true;
+    sharpness = -1.0;
+    return nullopt;
+}
+
+optional<CamError> Autofocus::goldenSection() {
+    double a = m_config.min_voltage;
+    double b = m_config.max_voltage;
+    double c = b - INV_PHI * (b - a);
+    double d = a + INV_PHI * (b - a);
+
+    double fc, fd;
+    if (auto err = evaluate(c, fc)) {
+        return err;
+    }
+    if (auto err = evaluate(d, fd)) {
+        return err;
+    }
+
+    /* Each step keeps one interior point, so it costs a single new frame */
+    while (b - a > m_config.tolerance && !m_exhausted) {
+        if (fc > fd) {
+            b = d;
+            d = c;
+            fd = fc;
+            c = b - INV_PHI * (b - a);
+            if (auto err = evaluate(c, fc)) {
+                return err;
+            }
+        } else {
+            a = c;
+            c = d;
+            fc = fd;
+            d = a + INV_PHI * (b - a);
+            if (auto err = evaluate(d, fd)) {
+                return err;
+            }
+        }
+    }
+    return nullopt;
+}
+
+optional<CamError> Autofocus::coarseToFine() {
+    double low = m_config.min_voltage;
+    double high = m_config.max_voltage;
+
+    while (!m_exhausted) {
+        double step = (high - low) / (m_config.coarse_steps - 1);
+        double pass_voltage = low;
+        double pass_sharpness = -1.0;
+
+        for (int i = 0; i < m_config.coarse_steps && !m_exhausted; i++) {
+            double voltage = low + i * step;
+            double sharpness;
+            if (auto err = evaluate(voltage, sharpness)) {
+                return err;
+            }
+            if (sharpness > pass_sharpness) {
+                pass_sharpness = sharpness;
+                pass_voltage = voltage;
+            }
+        }
+
+        if (step <= m_config.tolerance) {
+            break;
+        }
+        /* The peak lies within one step of the best sample */
+        low = max(m_config.min_voltage, pass_voltage - step);
+        high = min(m_config.max_voltage, pass_voltage + step);
+    }
+    return nullopt;
+}
+
+optional<ConvertError> Autofocus::measure(const FrameBuffer &frame, double &sharpness) {
+    if (frame.data == nullptr || frame.width <= 0 || frame.height <= 0) {
+        return ConvertError { .message = "Frame has no image data" };
+    }
+
+    cv::Mat image;
+    switch (pixelStorageBits(frame.pixel_format)) {
+        case 8:
+            image = cv::Mat(frame.height, frame.width, CV_8UC1, frame.data, frame.stride);
+            break;
+        case 16:
+            image = cv::Mat(frame.height, frame.width, CV_16UC1, frame.data, frame.stride);
+            break;
+        default: {
+            size_t stride = static_cast<size_t>(frame.width) * sizeof(uint16_t);
+            m_unpacked.resize(static_cast<size_t>(frame.width) * frame.height);
+            if (auto err = unpackToMono16(frame, m_unpacked.data(), stride)) {
+                return err;
+            }
+            image = cv::Mat(frame.height, frame.width, CV_16UC1, m_unpacked.data(), stride);
+            break;
+        }
+    }
+
+    cv::Rect area(0, 0, frame.width, frame.height);
+    const Region &roi = m_config.roi;
+    if (roi.width > 0 && roi.height > 0) {
+        area = area & cv::Rect(roi.x, roi.y, roi.width, roi.height);
+    }
+    if (area.width < 3 || area.height < 3) {
+        return ConvertError { .message = "Autofocus region is outside the frame" };
+    }
+    cv::Mat view = image(area);
+
+    /* OpenCV's filters and reductions run on its SIMD kernels */
+    switch (m_config.metric) {
+        case SharpnessMetric::LAPLACIAN_VARIANCE: {
+            cv::Laplacian(view, m_dx, CV_32F);
+            cv::Scalar mean, stddev;
+            cv::meanStdDev(m_dx, mean, stddev);
+            sharpness = stddev[0] * stddev[0];
+            break;
+        }
+        case SharpnessMetric::TENENGRAD:
+            cv::Sobel(view, m_dx, CV_32F, 1, 0);
+            cv::Sobel(view, m_dy, CV_32F, 0, 1);
+            sharpness = (m_dx.dot(m_dx) + m_dy.dot(m_dy)) / static_cast<double>(m_dx.total());
+            break;
+    }
+    return nullopt;
+}
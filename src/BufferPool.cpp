@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#include "BufferPool.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+#define HUGE_PAGE_SIZE (2u * 1024u * 1024u)
+
+/* Live shared pools, looked up by address when a frame is published */
+static mutex shared_pools_mutex;
+static vector<const BufferPool*> shared_pools;
+static atomic<uint32_t> shared_pool_counter{0};
+
+static size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+static size_t pageSize() {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<size_t>(info.dwPageSize);
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+shared_ptr<BufferPool> BufferPool::create(
+    size_t buffer_size,
+    uint32_t count,
+    const BufferPoolConfig &config)
+{
+    if (buffer_size == 0 || count == 0) {
+        return nullptr;
+    }
+    /* Buffers are aligned by the page-aligned arena, so no further than a page */
+    if (config.alignment == 0 || (config.alignment & (config.alignment - 1)) != 0
+        || config.alignment > pageSize()) {
+        return nullptr;
+    }
+
+    size_t slot_size = roundUp(buffer_size, config.alignment);
+    size_t total = slot_size * count;
+
+    if (!config.shared_name.empty()) {
+        /* Every pool gets its own segment, since a resize replaces the pool
+         * while frames of the old one may still be borrowed */
+#if defined(_WIN32)
+        int pid = _getpid();
+#else
+        int pid = static_cast<int>(getpid());
+#endif
+        string name = config.shared_name + "-" + to_string(pid) + "-" + to_string(shared_pool_counter++);
+        auto segment = MappedFile::createShared(name, total);
+        if (!segment) {
+            return nullptr;
+        }
+        /* Page alignment of the segment covers any alignment up to the page size */
+        memset(segment->data(), 0, total);
+
+        shared_ptr<BufferPool> pool(new BufferPool());
+        pool->m_memory = segment->data();
+        pool->m_mapped_size = total;
+        pool->m_buffer_size = buffer_size;
+        pool->m_slot_size = slot_size;
+        pool->m_count = count;
+        pool->m_segment = move(segment);
+        pool->m_shared_name = name;
+
+        lock_guard<mutex> lock(shared_pools_mutex);
+        shared_pools.push_back(pool.get());
+        return pool;
+    }
+
+    void *memory = nullptr;
+    size_t mapped_size = 0;
+    bool huge_pages = false;
+
+#if defined(_WIN32)
+    if (config.huge_pages) {
+        /* Needs SeLockMemoryPrivilege; fall back to regular pages without it */
+        SIZE_T large_page = GetLargePageMinimum();
+        if (large_page != 0) {
+            mapped_size = roundUp(total, large_page);
+            memory = VirtualAlloc(NULL, mapped_size,
+                MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            huge_pages = memory != NULL;
+        }
+    }
+    if (memory == NULL) {
+        mapped_size = total;
+        memory = VirtualAlloc(NULL, mapped_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (memory == NULL) {
+            return nullptr;
+        }
+    }
+#else
+#ifdef MAP_HUGETLB
+    if (config.huge_pages) {
+        /* Only succeeds if huge pages were reserved (vm.nr_hugepages) */
+        mapped_size = roundUp(total, HUGE_PAGE_SIZE);
+        memory = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED) {
+            memory = nullptr;
+        } else {
+            huge_pages = true;
+        }
+    }
+#endif
+    if (memory == nullptr) {
+        mapped_size = roundUp(total, pageSize());
+        memory = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return nullptr;
+        }
+#ifdef MADV_HUGEPAGE
+        if (config.huge_pages) {
+            /* Ask for transparent huge pages instead */
+            madvise(memory, mapped_size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+#endif
+
+    /* Fault every page in now rather than on the first frames */
+    memset(memory, 0, mapped_size);
+
+    shared_ptr<BufferPool> pool(new BufferPool());
+    pool->m_memory = memory;
+    pool->m_mapped_size = mapped_size;
+    pool->m_buffer_size = buffer_size;
+    pool->m_slot_size = slot_size;
+    pool->m_count = count;
+    pool->m_huge_pages = huge_pages;
+    return pool;
+}
+
+const BufferPool *BufferPool::findShared(const void *address) {
+    const uint8_t *byte = static_cast<const uint8_t*>(address);
+
+    lock_guard<mutex> lock(shared_pools_mutex);
+    for (const BufferPool *pool : shared_pools) {
+        const uint8_t *start = static_cast<const uint8_t*>(pool->m_memory);
+        if (byte >= start && byte < start + pool->m_mapped_size) {
+            return pool;
+        }
+    }
+    return nullptr;
+}
+
+BufferPool::~BufferPool() {
+    if (m_segment) {
+        lock_guard<mutex> lock(shared_pools_mutex);
+        shared_pools.erase(find(shared_pools.begin(), shared_pools.end(), this));
+        return;
+    }
+    if (m_memory == nullptr) {
+        return;
+    }
+#if defined(_WIN32)
+    VirtualFree(m_memory, 0, MEM_RELEASE);
+#else
+    munmap(m_memory, m_mapped_size);
+#endif
+}
@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "BufferedStream.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+/* Unanswered software triggers kept for latency matching */
+#define MAX_PENDING_TRIGGERS 64
+
+/* Add one sample to a running latency summary (Welford's algorithm) */
+static void addLatencySample(LatencyStats &stats, double &m2, uint64_t latency_ns) {
+    stats.count++;
+    stats.last_ns = latency_ns;
+    stats.min_ns = stats.count == 1 ? latency_ns : min(stats.min_ns, latency_ns);
+    stats.max_ns = max(stats.max_ns, latency_ns);
+
+    double delta = latency_ns - stats.mean_ns;
+    stats.mean_ns += delta / stats.count;
+    m2 += delta * (latency_ns - stats.mean_ns);
+}
+
+optional<StreamError> BufferedStream::borrowOldestFrame(FrameBuffer &frame) {
+    if (m_latest_mode) {
+        /* Only the most recent frame is retained in latest-frame mode */
+        return borrowLatestFrame(frame, false, NO_WAIT);
+    }
+
+    return borrowOldestFrame(frame, WAIT_FOREVER);
+}
+
+optional<StreamError> BufferedStream::borrowNewestFrame(FrameBuffer &frame) {
+    if (m_latest_mode) {
+        return borrowLatestFrame(frame, false, NO_WAIT);
+    }
+
+    return borrowNewestFrame(frame, WAIT_FOREVER);
+}
+
+optional<StreamError> BufferedStream::borrowNextNewFrame(FrameBuffer &frame) {
+    return borrowNextNewFrame(frame, WAIT_FOREVER);
+}
+
+optional<StreamError> BufferedStream::borrowOldestFrame(FrameBuffer &frame, chrono::microseconds timeout) {
+    if (m_latest_mode) {
+        return borrowLatestFrame(frame, false, timeout);
+    }
+    if (m_worker_running) {
+        return StreamError { .message = "Stream is in push mode" };
+    }
+
+    return populateFrameBuffer(frame, timeout);
+}
+
+optional<StreamError> BufferedStream::borrowNewestFrame(FrameBuffer &frame, chrono::microseconds timeout) {
+    if (m_latest_mode) {
+        return borrowLatestFrame(frame, false, timeout);
+    }
+    if (m_worker_running) {
+        return StreamError { .message = "Stream is in push mode" };
+    }
+
+    /* Discard all but the last buffer */
+    discardQueuedFrames(1);
+
+    return populateFrameBuffer(frame, timeout);
+}
+
+optional<StreamError> BufferedStream::borrowNextNewFrame(FrameBuffer &frame, chrono::microseconds timeout) {
+    if (m_latest_mode) {
+        return borrowLatestFrame(frame, true, timeout);
+    }
+    if (m_worker_running) {
+        return StreamError { .message = "Stream is in push mode" };
+    }
+
+    /* Discard ALL buffers */
+    discardQueuedFrames(0);
+
+    return populateFrameBuffer(frame, timeout);
+}
+
+void BufferedStream::releaseFrame(FrameBuffer &frame) {
+    pushBuffer(frame.parent_buffer);
+}
+
+optional<StreamError> BufferedStream::registerFrameCallback(FrameCallback callback) {
+    if (!callback) {
+        return StreamError { .message = "Frame callback is empty" };
+    }
+    if (m_latest_mode) {
+        return StreamError { .message = "Stream is in latest-frame mode" };
+    }
+
+    stopWorker();
+    m_callback = move(callback);
+    startWorker();
+
+    return nullopt;
+}
+
+void BufferedStream::unregisterFrameCallback() {
+    if (m_latest_mode) {
+        return;
+    }
+    stopWorker();
+    m_callback = nullptr;
+}
+
+optional<StreamError> BufferedStream::setLatestFrameMode(bool enable) {
+    if (enable == m_latest_mode) {
+        return nullopt;
+    }
+    if (enable && m_worker_running) {
+        return StreamError { .message = "Stream is in push mode" };
+    }
+
+    if (enable) {
+        m_latest_mode = true;
+        startWorker();
+    } else {
+        stopWorker();
+        m_latest_mode = false;
+
+        /* Hand the unclaimed frame back to the stream */
+        void *latest = takeLatest();
+        if (latest != nullptr) {
+            countDiscarded();
+            pushBuffer(latest);
+        }
+    }
+
+    return nullopt;
+}
+
+optional<StreamError> BufferedStream::populateFrameBuffer(FrameBuffer &frame, chrono::microseconds timeout) {
+    auto deadline = chrono::steady_clock::now();
+    if (timeout != WAIT_FOREVER) {
+        deadline += max(timeout, NO_WAIT);
+    }
+
+    for (void *buffer = takeCompleted(timeout); buffer != nullptr; buffer = takeCompleted(timeout)) {
+        if (isDeliverable(buffer)) {
+            fillFrameBuffer(buffer, frame);
+            countDelivered(buffer);
+
+            return nullopt;
+        }
+
+        /* Requeue failed frames so they never drain the pool, and keep
+         * waiting for a good one within what is left of the timeout */
+        pushBuffer(buffer);
+        if (timeout != WAIT_FOREVER) {
+            timeout = max(chrono::duration_cast<chrono::microseconds>(deadline - chrono::steady_clock::now()), NO_WAIT);
+        }
+    }
+
+    if (timeout != WAIT_FOREVER) {
+        return StreamError {
+            .message = "Timed out waiting for a frame",
+            .code = StreamErrorCode::TIMEOUT };
+    }
+    return StreamError { .message = "Failed to populate frame buffer" };
+}
+
+void BufferedStream::discardQueuedFrames(int keep) {
+    int output_buffer_count = queuedFrameCount();
+
+    for (int i = 0; i < output_buffer_count - keep; i++) {
+        void *buffer = takeCompleted(NO_WAIT);
+        if (buffer == nullptr) {
+            break;
+        }
+        countDiscarded();
+        pushBuffer(buffer);
+    }
+}
+
+void BufferedStream::startWorker() {
+    m_worker_running = true;
+    m_worker = thread(&BufferedStream::workerLoop, this);
+}
+
+void BufferedStream::stopWorker() {
+    m_worker_running = false;
+    {
+        /* Release any consumer parked waiting for a latest frame */
+        lock_guard<mutex> lock(m_latest_mutex);
+    }
+    m_latest_cv.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+void BufferedStream::workerLoop() {
+    while (m_worker_running) {
+        /* Sleep in the output queue instead of spinning; the timeout only
+         * bounds how long a stop request can go unnoticed. */
+        void *buffer = takeCompleted(chrono::microseconds(STREAM_WORKER_WAKEUP_US));
+        if (buffer == nullptr) {
+            continue;
+        }
+
+        if (!isDeliverable(buffer)) {
+            pushBuffer(buffer);
+            continue;
+        }
+
+        if (m_latest_mode) {
+            publishLatest(buffer);
+            continue;
+        }
+
+        FrameBuffer frame;
+        fillFrameBuffer(buffer, frame);
+
+        FrameDispatchInfo info;
+        info.completed_ns = frame.system_timestamp_ns;
+        info.dispatched_ns = hostTimeNs();
+        info.latency_ns = info.dispatched_ns > info.completed_ns
+            ? info.dispatched_ns - info.completed_ns : 0;
+
+        countDelivered(buffer);
+        m_callback(frame, info);
+
+        pushBuffer(buffer);
+    }
+}
+
+void BufferedStream::publishLatest(void *buffer) {
+    /* Replace the slot and immediately recycle whatever the consumer did not
+     * pick up, so stale frames never pile up in the queue. */
+    void *stale = m_latest.exchange(buffer);
+    if (stale != nullptr) {
+        countDiscarded();
+        pushBuffer(stale);
+    }
+
+    if (m_latest_waiters.load() > 0) {
+        /* Taking the mutex orders the slot update before a waiter re-checks
+         * its predicate, so the notification cannot be lost. */
+        { lock_guard<mutex> lock(m_latest_mutex); }
+        m_latest_cv.notify_all();
+    }
+}
+
+optional<StreamError> BufferedStream::borrowLatestFrame(
+    FrameBuffer &frame,
+    bool discard_current,
+    chrono::microseconds timeout)
+{
+    if (discard_current) {
+        /* Drop the frame currently in the slot and wait for the next one */
+        void *stale = m_latest.exchange(nullptr);
+        if (stale != nullptr) {
+            countDiscarded();
+            pushBuffer(stale);
+        }
+    }
+
+    if (timeout > NO_WAIT && m_latest.load() == nullptr) {
+        m_latest_waiters++;
+        {
+            unique_lock<mutex> lock(m_latest_mutex);
+            auto ready = [this] {
+                return m_latest.load() != nullptr || !m_worker_running;
+            };
+            if (timeout == WAIT_FOREVER) {
+                m_latest_cv.wait(lock, ready);
+            } else {
+                m_latest_cv.wait_for(lock, timeout, ready);
+            }
+        }
+        m_latest_waiters--;
+    }
+
+    void *buffer = m_latest.exchange(nullptr);
+    if (buffer == nullptr) {
+        if (timeout > NO_WAIT && m_worker_running) {
+            return StreamError {
+                .message = "Timed out waiting for a frame",
+                .code = StreamErrorCode::TIMEOUT };
+        }
+        return StreamError { .message = "No new frame available" };
+    }
+
+    fillFrameBuffer(buffer, frame);
+    countDelivered(buffer);
+    return nullopt;
+}
+
+StreamStats BufferedStream::getStreamStats() {
+    StreamStats stats;
+    {
+        lock_guard<mutex> lock(m_stats_mutex);
+        stats = m_stats;
+
+        if (stats.trigger_to_frame.count > 1) {
+            stats.trigger_to_frame.stddev_ns = sqrt(m_trigger_frame_m2 / (stats.trigger_to_frame.count - 1));
+        }
+        if (stats.trigger_to_delivery.count > 1) {
+            stats.trigger_to_delivery.stddev_ns = sqrt(m_trigger_delivery_m2 / (stats.trigger_to_delivery.count - 1));
+        }
+
+        size_t window = min<size_t>(m_frame_count, STREAM_FPS_WINDOW);
+        if (window > 1) {
+            uint64_t newest = m_frame_times[(m_frame_count - 1) % STREAM_FPS_WINDOW];
+            uint64_t oldest = m_frame_times[(m_frame_count - window) % STREAM_FPS_WINDOW];
+            if (newest > oldest) {
+                stats.fps = (window - 1) * 1e9 / static_cast<double>(newest - oldest);
+            }
+        }
+    }
+
+    stats.queued_frames = queuedFrameCount();
+    stats.free_buffers = freeBufferCount();
+    transportCounters(stats);
+
+    return stats;
+}
+
+void *BufferedStream::takeCompleted(chrono::microseconds timeout) {
+    void *buffer = popBuffer(timeout);
+    if (buffer != nullptr) {
+        recordFrame(buffer);
+    }
+    return buffer;
+}
+
+void BufferedStream::recordFrame(void *buffer) {
+    FrameStatus status = bufferStatus(buffer);
+    uint64_t completed_ns = bufferCompletedNs(buffer);
+
+    lock_guard<mutex> lock(m_stats_mutex);
+    m_stats.status_counts[static_cast<int>(status) - static_cast<int>(FrameStatus::UNKNOWN)]++;
+
+    if (status != FrameStatus::SUCCESS || completed_ns == 0) {
+        return;
+    }
+
+    if (m_frame_count > 0) {
+        uint64_t previous_ns = m_frame_times[(m_frame_count - 1) % STREAM_FPS_WINDOW];
+        if (completed_ns <= previous_ns) {
+            return;
+        }
+
+        double interval_ns = static_cast<double>(completed_ns - previous_ns);
+        if (m_mean_interval_ns == 0.0) {
+            m_mean_interval_ns = interval_ns;
+        }
+        uint64_t deviation_us = static_cast<uint64_t>(fabs(interval_ns - m_mean_interval_ns) / 1000.0);
+        size_t bucket = min<size_t>(bit_width(deviation_us), STREAM_JITTER_BUCKETS - 1);
+        m_stats.jitter_histogram[bucket]++;
+
+        /* Slow running mean, so one late frame does not shift the baseline */
+        m_mean_interval_ns += (interval_ns - m_mean_interval_ns) / 16.0;
+    }
+
+    m_frame_times[m_frame_count % STREAM_FPS_WINDOW] = completed_ns;
+    m_frame_count++;
+}
+
+bool BufferedStream::isDeliverable(void *buffer) {
+    switch (bufferStatus(buffer)) {
+        case FrameStatus::SUCCESS:
+            return true;
+        case FrameStatus::TIMEOUT:
+        case FrameStatus::MISSING_PACKETS:
+        case FrameStatus::WRONG_PACKET_ID:
+        case FrameStatus::SIZE_MISMATCH:
+            /* Partially filled, the image data is usable with care */
+            return m_deliver_incomplete;
+        default:
+            return false;
+    }
+}
+
+void BufferedStream::recordTrigger(uint64_t host_ns) {
+    lock_guard<mutex> lock(m_stats_mutex);
+    m_stats.triggers++;
+    if (m_trigger_times.size() == MAX_PENDING_TRIGGERS) {
+        /* Never answered, most likely the frame was lost */
+        m_trigger_times.pop_front();
+    }
+    m_trigger_times.push_back(host_ns);
+}
+
+void BufferedStream::countDelivered(void *buffer) {
+    uint64_t completed_ns = bufferCompletedNs(buffer);
+    uint64_t delivered_ns = hostTimeNs();
+
+    lock_guard<mutex> lock(m_stats_mutex);
+    m_stats.delivered++;
+
+    if (m_trigger_times.empty() || m_trigger_times.front() > completed_ns) {
+        return;
+    }
+    uint64_t trigger_ns = m_trigger_times.front();
+    m_trigger_times.pop_front();
+
+    addLatencySample(m_stats.trigger_to_frame, m_trigger_frame_m2, completed_ns - trigger_ns);
+    addLatencySample(m_stats.trigger_to_delivery, m_trigger_delivery_m2, delivered_ns - trigger_ns);
+}
+
+void BufferedStream::countDiscarded() {
+    lock_guard<mutex> lock(m_stats_mutex);
+    m_stats.discarded++;
+}
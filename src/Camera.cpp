@@ -3,54 +3,217 @@
 using namespace std;
 using namespace cynlr::camera;
 
+/* Borrow a frame through `borrow` and hand ownership of it to `handle` */
+template <typename Borrow>
+static optional<StreamError> borrowInto(shared_ptr<IStream> stream, FrameHandle &handle, Borrow borrow) {
+    FrameBuffer frame;
+    if (auto err = borrow(*stream, frame)) {
+        return err;
+    }
+    handle = FrameHandle(move(stream), frame);
+    return nullopt;
+}
+
+/* Remember `value` as the camera's setting if `result` is a success */
+template <typename T, typename V>
+static optional<CamError> track(optional<T> &applied, const V &value, optional<CamError> result) {
+    if (result) {
+        applied.reset();
+    } else {
+        applied = value;
+    }
+    return result;
+}
+
 optional<CamError> Camera::startAcquisition() {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
     return m_backend->startAcquisition();
 }
 
 optional<CamError> Camera::stopAcquisition() {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
     return m_backend->stopAcquisition();
 }
 
 optional<CamError> Camera::setAcquisitionMode(AcquisitionMode mode) {
-    return m_backend->setAcquisitionMode(mode);
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return track(m_applied.acquisition_mode, mode, m_backend->setAcquisitionMode(mode));
 }
 
 optional<CamError> Camera::setPixelFormat(PixelFormat format) {
-    return m_backend->setPixelFormat(format);
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return track(m_applied.pixel_format, format, m_backend->setPixelFormat(format));
 }
 
 optional<CamError> Camera::setBinning(int dx, int dy) {
-    return m_backend->setBinning(dx, dy);
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    m_applied.region.reset();
+    return track(m_applied.binning, make_pair(dx, dy), m_backend->setBinning(dx, dy));
+}
+
+optional<CamError> Camera::setRegion(int x, int y, int width, int height) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    Region region { .x = x, .y = y, .width = width, .height = height };
+    return track(m_applied.region, region, m_backend->setRegion(x, y, width, height));
+}
+
+optional<CamError> Camera::setRegions(const vector<Region> &regions) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    m_applied.region.reset();
+    return m_backend->setRegions(regions);
 }
 
 optional<CamError> Camera::setGain(double gain) {
-    return m_backend->setGain(gain);
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return track(m_applied.gain, gain, m_backend->setGain(gain));
 }
 
 optional<CamError> Camera::setAutoExposure(bool setAuto) {
-    return m_backend->setAutoExposure(setAuto);
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    m_applied.exposure_time_us.reset();
+    return track(m_applied.auto_exposure, setAuto, m_backend->setAutoExposure(setAuto));
 }
 
 optional<CamError> Camera::setExposureTime(double exposure_time_us) {
-    return m_backend->setExposureTime(exposure_time_us);
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    m_applied.frame_rate.reset();
+    return track(m_applied.exposure_time_us, exposure_time_us, m_backend->setExposureTime(exposure_time_us));
 }
 
 optional<CamError> Camera::setFrameRate(double framerate) {
-    return m_backend->setFrameRate(framerate);
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return track(m_applied.frame_rate, framerate, m_backend->setFrameRate(framerate));
+}
+
+optional<CamError> Camera::enablePtp(bool enable) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return track(m_applied.ptp, enable, m_backend->enablePtp(enable));
+}
+
+optional<CamError> Camera::setTriggerMode(bool enable) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return track(m_applied.trigger_mode, enable, m_backend->setTriggerMode(enable));
+}
+
+optional<CamError> Camera::setTriggerSource(TriggerSource source) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return track(m_applied.trigger_source, source, m_backend->setTriggerSource(source));
+}
+
+optional<CamError> Camera::setTriggerActivation(TriggerActivation activation) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return track(m_applied.trigger_activation, activation, m_backend->setTriggerActivation(activation));
+}
+
+optional<CamError> Camera::setTriggerDelay(double delay_us) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return track(m_applied.trigger_delay_us, delay_us, m_backend->setTriggerDelay(delay_us));
+}
+
+optional<CamError> Camera::fireSoftwareTrigger() {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return m_backend->fireSoftwareTrigger();
 }
 
 optional<CamError> Camera::enableLensPower(bool enable) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
     return m_backend->enableLensPower(enable);
 }
 
 optional<CamError> Camera::setupLensSerial(const char* baudRate) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
     return m_backend->setupLensSerial(baudRate);
 }
 
 optional<CamError> Camera::setLensFocus(double voltage) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
     return m_backend->setLensFocus(voltage);
 }
 
+optional<CamError> Camera::setLensResultCheck(bool enable) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return m_backend->setLensResultCheck(enable);
+}
+
+optional<CamError> Camera::checkLensResult() {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return m_backend->checkLensResult();
+}
+
+optional<CamError> Camera::enableChunks(const vector<ChunkSelector> &chunks) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    return m_backend->enableChunks(chunks);
+}
+
+ControlQueue &Camera::control() {
+    call_once(m_control_once, [this] { m_control = make_unique<ControlQueue>(); });
+    return *m_control;
+}
+
+future<ControlResult> Camera::setLensFocusAsync(double voltage) {
+    return control().submit([this, voltage] { return setLensFocus(voltage); }, "LensFocus");
+}
+
+future<ControlResult> Camera::submitControl(function<optional<CamError>(Camera&)> command) {
+    return control().submit([this, command = move(command)] {
+        /* The whole command runs without other control calls in between */
+        lock_guard<recursive_mutex> lock(m_backend_mutex);
+        return command(*this);
+    });
+}
+
+optional<CamError> Camera::applyConfig(const CameraConfig &config, ConfigApplyReport *report) {
+    lock_guard<recursive_mutex> lock(m_backend_mutex);
+    auto start = chrono::steady_clock::now();
+    ConfigApplyReport result;
+
+    /* Write `wanted` through `setter` unless it is unset or already applied */
+    auto apply = [&result](const auto &wanted, const auto &applied, auto setter) -> optional<CamError> {
+        if (!wanted) {
+            return nullopt;
+        }
+        if (applied == wanted) {
+            result.skipped++;
+            return nullopt;
+        }
+        result.written++;
+        return setter(*wanted);
+    };
+
+    optional<CamError> err = apply(config.acquisition_mode, m_applied.acquisition_mode,
+        [this](AcquisitionMode mode) { return setAcquisitionMode(mode); });
+    if (!err) err = apply(config.pixel_format, m_applied.pixel_format,
+        [this](PixelFormat format) { return setPixelFormat(format); });
+    if (!err) err = apply(config.binning, m_applied.binning,
+        [this](pair<int, int> binning) { return setBinning(binning.first, binning.second); });
+    if (!err) err = apply(config.region, m_applied.region,
+        [this](const Region &region) { return setRegion(region.x, region.y, region.width, region.height); });
+    if (!err) err = apply(config.trigger_mode, m_applied.trigger_mode,
+        [this](bool enable) { return setTriggerMode(enable); });
+    if (!err) err = apply(config.trigger_source, m_applied.trigger_source,
+        [this](TriggerSource source) { return setTriggerSource(source); });
+    if (!err) err = apply(config.trigger_activation, m_applied.trigger_activation,
+        [this](TriggerActivation activation) { return setTriggerActivation(activation); });
+    if (!err) err = apply(config.trigger_delay_us, m_applied.trigger_delay_us,
+        [this](double delay_us) { return setTriggerDelay(delay_us); });
+    if (!err) err = apply(config.auto_exposure, m_applied.auto_exposure,
+        [this](bool enable) { return setAutoExposure(enable); });
+    if (!err) err = apply(config.exposure_time_us, m_applied.exposure_time_us,
+        [this](double exposure_time_us) { return setExposureTime(exposure_time_us); });
+    if (!err) err = apply(config.gain, m_applied.gain,
+        [this](double gain) { return setGain(gain); });
+    if (!err) err = apply(config.frame_rate, m_applied.frame_rate,
+        [this](double framerate) { return setFrameRate(framerate); });
+    if (!err) err = apply(config.ptp, m_applied.ptp,
+        [this](bool enable) { return enablePtp(enable); });
+
+    result.elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+    if (report != nullptr) {
+        *report = result;
+    }
+    return err;
+}
+
 optional<StreamError> Camera::borrowOldestFrame(FrameBuffer &frame) {
     return m_backend->getStream()->borrowOldestFrame(frame);
 }
@@ -63,6 +226,68 @@ optional<StreamError> Camera::borrowNextNewFrame(FrameBuffer &frame) {
     return m_backend->getStream()->borrowNextNewFrame(frame);
 }
 
+optional<StreamError> Camera::borrowOldestFrame(FrameBuffer &frame, chrono::microseconds timeout) {
+    return m_backend->getStream()->borrowOldestFrame(frame, timeout);
+}
+
+optional<StreamError> Camera::borrowNewestFrame(FrameBuffer &frame, chrono::microseconds timeout) {
+    return m_backend->getStream()->borrowNewestFrame(frame, timeout);
+}
+
+optional<StreamError> Camera::borrowNextNewFrame(FrameBuffer &frame, chrono::microseconds timeout) {
+    return m_backend->getStream()->borrowNextNewFrame(frame, timeout);
+}
+
 void Camera::releaseFrame(FrameBuffer &frame) {
     m_backend->getStream()->releaseFrame(frame);
+}
+
+optional<StreamError> Camera::borrowOldestFrame(FrameHandle &frame) {
+    return borrowInto(m_backend->getStream(), frame,
+        [](IStream &stream, FrameBuffer &buffer) { return stream.borrowOldestFrame(buffer); });
+}
+
+optional<StreamError> Camera::borrowNewestFrame(FrameHandle &frame) {
+    return borrowInto(m_backend->getStream(), frame,
+        [](IStream &stream, FrameBuffer &buffer) { return stream.borrowNewestFrame(buffer); });
+}
+
+optional<StreamError> Camera::borrowNextNewFrame(FrameHandle &frame) {
+    return borrowInto(m_backend->getStream(), frame,
+        [](IStream &stream, FrameBuffer &buffer) { return stream.borrowNextNewFrame(buffer); });
+}
+
+optional<StreamError> Camera::borrowOldestFrame(FrameHandle &frame, chrono::microseconds timeout) {
+    return borrowInto(m_backend->getStream(), frame,
+        [timeout](IStream &stream, FrameBuffer &buffer) { return stream.borrowOldestFrame(buffer, timeout); });
+}
+
+optional<StreamError> Camera::borrowNewestFrame(FrameHandle &frame, chrono::microseconds timeout) {
+    return borrowInto(m_backend->getStream(), frame,
+        [timeout](IStream &stream, FrameBuffer &buffer) { return stream.borrowNewestFrame(buffer, timeout); });
+}
+
+optional<StreamError> Camera::borrowNextNewFrame(FrameHandle &frame, chrono::microseconds timeout) {
+    return borrowInto(m_backend->getStream(), frame,
+        [timeout](IStream &stream, FrameBuffer &buffer) { return stream.borrowNextNewFrame(buffer, timeout); });
+}
+
+optional<StreamError> Camera::registerFrameCallback(FrameCallback callback) {
+    return m_backend->getStream()->registerFrameCallback(move(callback));
+}
+
+void Camera::unregisterFrameCallback() {
+    m_backend->getStream()->unregisterFrameCallback();
+}
+
+optional<StreamError> Camera::setLatestFrameMode(bool enable) {
+    return m_backend->getStream()->setLatestFrameMode(enable);
+}
+
+void Camera::setDeliverIncompleteFrames(bool enable) {
+    m_backend->getStream()->setDeliverIncompleteFrames(enable);
+}
+
+StreamStats Camera::getStreamStats() {
+    return m_backend->getStream()->getStreamStats();
 }
\ No newline at end of file
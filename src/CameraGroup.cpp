@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <limits>
+
+#include "CameraGroup.hpp"
+#include "BufferedStream.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+optional<CamError> CameraGroup::addCamera(unique_ptr<ICameraBackend> backend) {
+    if (m_running) {
+        return CamError { .message = "Cameras cannot be added while the group is acquiring" };
+    }
+    if (!backend) {
+        return CamError { .message = "Camera backend is null" };
+    }
+
+    auto member = make_unique<Member>();
+    member->camera = make_unique<Camera>(move(backend));
+    member->ring = make_unique<SpscRing<FrameHandle>>(m_config.queue_depth);
+    m_members.push_back(move(member));
+    return nullopt;
+}
+
+optional<CamError> CameraGroup::applyAll(const function<optional<CamError>(Camera&)> &setter) {
+    for (auto &member : m_members) {
+        if (auto err = setter(*member->camera)) {
+            return err;
+        }
+    }
+    return nullopt;
+}
+
+optional<CamError> CameraGroup::setAcquisitionMode(AcquisitionMode mode) {
+    return applyAll([mode](Camera &cam) { return cam.setAcquisitionMode(mode); });
+}
+
+optional<CamError> CameraGroup::setPixelFormat(PixelFormat format) {
+    return applyAll([format](Camera &cam) { return cam.setPixelFormat(format); });
+}
+
+optional<CamError> CameraGroup::setBinning(int dx, int dy) {
+    return applyAll([dx, dy](Camera &cam) { return cam.setBinning(dx, dy); });
+}
+
+optional<CamError> CameraGroup::setGain(double gain) {
+    return applyAll([gain](Camera &cam) { return cam.setGain(gain); });
+}
+
+optional<CamError> CameraGroup::setExposureTime(double exposure_time_us) {
+    return applyAll([exposure_time_us](Camera &cam) { return cam.setExposureTime(exposure_time_us); });
+}
+
+optional<CamError> CameraGroup::setFrameRate(double framerate) {
+    return applyAll([framerate](Camera &cam) { return cam.setFrameRate(framerate); });
+}
+
+optional<CamError> CameraGroup::enablePtp(bool enable) {
+    return applyAll([enable](Camera &cam) { return cam.enablePtp(enable); });
+}
+
+optional<CamError> CameraGroup::setTriggerMode(bool enable) {
+    return applyAll([enable](Camera &cam) { return cam.setTriggerMode(enable); });
+}
+
+optional<CamError> CameraGroup::setTriggerSource(TriggerSource source) {
+    return applyAll([source](Camera &cam) { return cam.setTriggerSource(source); });
+}
+
+optional<CamError> CameraGroup::setTriggerActivation(TriggerActivation activation) {
+    return applyAll([activation](Camera &cam) { return cam.setTriggerActivation(activation); });
+}
+
+optional<CamError> CameraGroup::setTriggerDelay(double delay_us) {
+    return applyAll([delay_us](Camera &cam) { return cam.setTriggerDelay(delay_us); });
+}
+
+optional<CamError> CameraGroup::fireSoftwareTrigger() {
+    return applyAll([](Camera &cam) { return cam.fireSoftwareTrigger(); });
+}
+
+optional<CamError> CameraGroup::applyConfig(const CameraConfig &config, ConfigApplyReport *report) {
+    auto start = chrono::steady_clock::now();
+    size_t count = m_members.size();
+    vector<optional<CamError>> errors(count);
+    vector<ConfigApplyReport> reports(count);
+
+    /* Control round trips to different cameras do not wait on each other */
+    vector<thread> workers;
+    for (size_t i = 0; i < count; i++) {
+        workers.emplace_back([&, i] { errors[i] = m_members[i]->camera->applyConfig(config, &reports[i]); });
+    }
+    for (thread &worker : workers) {
+        worker.join();
+    }
+
+    optional<CamError> result;
+    ConfigApplyReport total;
+    for (size_t i = 0; i < count; i++) {
+        total.written += reports[i].written;
+        total.skipped += reports[i].skipped;
+        if (errors[i] && !result) {
+            result = errors[i];
+        }
+    }
+    total.elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+    if (report != nullptr) {
+        *report = total;
+    }
+    return result;
+}
+
+optional<CamError> CameraGroup::startAcquisition(FrameSetCallback callback) {
+    if (m_running) {
+        return CamError { .message = "Camera group is already acquiring" };
+    }
+    if (m_members.empty()) {
+        return CamError { .message = "Camera group has no cameras" };
+    }
+    if (!callback) {
+        return CamError { .message = "Frame set callback is empty" };
+    }
+
+    for (size_t i = 0; i < m_members.size(); i++) {
+        if (auto err = m_members[i]->camera->startAcquisition()) {
+            /* Leave the group as it was */
+            for (size_t j = 0; j < i; j++) {
+                m_members[j]->camera->stopAcquisition();
+            }
+            return err;
+        }
+    }
+
+    m_callback = move(callback);
+    m_sets = 0;
+    m_running = true;
+    for (auto &member : m_members) {
+        member->unmatched = 0;
+        member->overflows = 0;
+        member->acquisition = thread(&CameraGroup::acquisitionLoop, this, ref(*member));
+    }
+    m_matcher = thread(&CameraGroup::matcherLoop, this);
+
+    return nullopt;
+}
+
+optional<CamError> CameraGroup::stopAcquisition() {
+    if (!m_running) {
+        return nullopt;
+    }
+
+    m_running = false;
+    m_arrivals.fetch_add(1);
+    m_arrivals.notify_all();
+
+    for (auto &member : m_members) {
+        member->acquisition.join();
+    }
+    m_matcher.join();
+
+    optional<CamError> result;
+    for (auto &member : m_members) {
+        /* Release frames still waiting for a partner */
+        FrameHandle frame;
+        while (member->ring->tryPop(frame)) {
+            frame.reset();
+        }
+        if (auto err = member->camera->stopAcquisition(); err && !result) {
+            result = err;
+        }
+    }
+    m_callback = nullptr;
+
+    return result;
+}
+
+CameraGroupStats CameraGroup::getStats() const {
+    CameraGroupStats stats;
+    stats.sets = m_sets;
+    for (const auto &member : m_members) {
+        stats.unmatched.push_back(member->unmatched);
+        stats.overflows.push_back(member->overflows);
+    }
+    return stats;
+}
+
+void CameraGroup::acquisitionLoop(Member &member) {
+    FrameHandle frame;
+
+    while (m_running) {
+        /* The timeout only bounds how long a stop request can go unnoticed */
+        if (member.camera->borrowOldestFrame(frame, chrono::microseconds(STREAM_WORKER_WAKEUP_US))) {
+            continue;
+        }
+
+        if (!member.ring->tryPush(frame)) {
+            /* The matcher is behind; drop the newcomer rather than block the stream */
+            member.overflows++;
+            frame.reset();
+            continue;
+        }
+
+        m_arrivals.fetch_add(1, memory_order_release);
+        m_arrivals.notify_one();
+    }
+}
+
+void CameraGroup::matcherLoop() {
+    size_t count = m_members.size();
+    uint64_t tolerance = static_cast<uint64_t>(m_config.tolerance.count());
+    vector<FrameHandle*> heads(count);
+
+    while (m_running) {
+        uint32_t seen = m_arrivals.load(memory_order_acquire);
+
+        bool complete = true;
+        uint64_t earliest = numeric_limits<uint64_t>::max();
+        uint64_t latest = 0;
+        for (size_t i = 0; i < count; i++) {
+            heads[i] = m_members[i]->ring->front();
+            if (heads[i] == nullptr) {
+                complete = false;
+                break;
+            }
+            uint64_t timestamp = timestampOf(*heads[i]);
+            earliest = min(earliest, timestamp);
+            latest = max(latest, timestamp);
+        }
+
+        if (!complete) {
+            /* Sleep until some camera pushes another frame */
+            m_arrivals.wait(seen, memory_order_acquire);
+            continue;
+        }
+
+        if (latest - earliest <= tolerance) {
+            FrameSet set;
+            set.frames.reserve(count);
+            set.timestamp_ns = earliest;
+            set.spread_ns = latest - earliest;
+            for (size_t i = 0; i < count; i++) {
+                set.frames.push_back(move(*heads[i]));
+                m_members[i]->ring->pop();
+            }
+
+            m_sets++;
+            m_callback(set);
+            continue;
+        }
+
+        /* Heads older than the newest head minus the tolerance can never be
+         * part of a set, since every later frame of that camera is newer */
+        for (size_t i = 0; i < count; i++) {
+            if (timestampOf(*heads[i]) + tolerance < latest) {
+                m_members[i]->ring->pop();
+                m_members[i]->unmatched++;
+            }
+        }
+    }
+}
+
+uint64_t CameraGroup::timestampOf(const FrameHandle &frame) const {
+    return m_config.timestamp_source == TimestampSource::DEVICE
+        ? frame->timestamp_ns : frame->system_timestamp_ns;
+}
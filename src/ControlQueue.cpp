@@ -0,0 +1,86 @@
+#include <cstring>
+#include <exception>
+
+#include "ControlQueue.hpp"
+#include "Frame.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+ControlQueue::ControlQueue() {
+    m_thread = thread(&ControlQueue::controlLoop, this);
+}
+
+ControlQueue::~ControlQueue() {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+future<ControlResult> ControlQueue::submit(ControlCommand command, const char *coalesce_key) {
+    Entry entry;
+    entry.command = move(command);
+    entry.coalesce_key = coalesce_key;
+    entry.queued_ns = hostTimeNs();
+    future<ControlResult> result = entry.result.get_future();
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        /* Only the back of the queue is replaced, so commands never overtake each other */
+        if (coalesce_key != nullptr && !m_queue.empty()) {
+            Entry &last = m_queue.back();
+            if (last.coalesce_key != nullptr && strcmp(last.coalesce_key, coalesce_key) == 0) {
+                ControlResult superseded;
+                superseded.superseded = true;
+                superseded.queued_ns = last.queued_ns;
+                last.result.set_value(superseded);
+                m_queue.pop_back();
+            }
+        }
+        m_queue.push_back(move(entry));
+    }
+    m_cv.notify_one();
+
+    return result;
+}
+
+size_t ControlQueue::pending() {
+    lock_guard<mutex> lock(m_mutex);
+    return m_queue.size();
+}
+
+void ControlQueue::controlLoop() {
+    unique_lock<mutex> lock(m_mutex);
+    while (true) {
+        m_cv.wait(lock, [this] { return !m_queue.empty() || !m_running; });
+        if (m_queue.empty()) {
+            break;
+        }
+
+        Entry entry = move(m_queue.front());
+        m_queue.pop_front();
+        lock.unlock();
+
+        ControlResult result;
+        result.queued_ns = entry.queued_ns;
+        result.started_ns = hostTimeNs();
+        try {
+            result.error = entry.command();
+        } catch (...) {
+            /* Hand the exception to the caller instead of ending the thread */
+            entry.result.set_exception(current_exception());
+            lock.lock();
+            continue;
+        }
+        result.completed_ns = hostTimeNs();
+        entry.result.set_value(result);
+
+        lock.lock();
+    }
+}
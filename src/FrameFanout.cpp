@@ -0,0 +1,179 @@
+#include "FrameFanout.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+SharedFrame::SharedFrame(const SharedFrame &other) :
+    m_block(other.m_block), m_consumer(other.m_consumer)
+{
+    if (m_block != nullptr) {
+        m_block->owner->addReference(m_block, m_consumer);
+    }
+}
+
+SharedFrame& SharedFrame::operator=(const SharedFrame &other) {
+    if (this != &other) {
+        /* Take the new reference first, in case both refer to the same frame */
+        if (other.m_block != nullptr) {
+            other.m_block->owner->addReference(other.m_block, other.m_consumer);
+        }
+        reset();
+        m_block = other.m_block;
+        m_consumer = other.m_consumer;
+    }
+    return *this;
+}
+
+SharedFrame::SharedFrame(SharedFrame &&other) noexcept :
+    m_block(other.m_block), m_consumer(other.m_consumer)
+{
+    other.m_block = nullptr;
+}
+
+SharedFrame& SharedFrame::operator=(SharedFrame &&other) noexcept {
+    if (this != &other) {
+        reset();
+        m_block = other.m_block;
+        m_consumer = other.m_consumer;
+        other.m_block = nullptr;
+    }
+    return *this;
+}
+
+cv::Mat SharedFrame::mat() const {
+    return valid() ? m_block->handle.mat() : cv::Mat();
+}
+
+span<const uint8_t> SharedFrame::bytes() const {
+    return valid() ? m_block->handle.bytes() : span<const uint8_t>();
+}
+
+uint32_t SharedFrame::useCount() const {
+    return valid() ? m_block->refs.load(memory_order_relaxed) : 0;
+}
+
+void SharedFrame::reset() {
+    if (m_block == nullptr) {
+        return;
+    }
+    Block *block = m_block;
+    m_block = nullptr;
+    block->owner->dropReference(block, m_consumer);
+}
+
+FrameFanout::FrameFanout(vector<FanoutConsumer> consumers, uint32_t capacity) {
+    for (FanoutConsumer &consumer : consumers) {
+        auto state = make_unique<ConsumerState>();
+        state->config = move(consumer);
+        m_consumers.push_back(move(state));
+    }
+
+    m_free.reserve(capacity);
+    for (uint32_t i = 0; i < capacity; i++) {
+        auto block = make_unique<SharedFrame::Block>();
+        block->owner = this;
+        m_free.push_back(block.get());
+        m_blocks.push_back(move(block));
+    }
+}
+
+FrameFanout::~FrameFanout() {
+    /* Frames still referenced here would outlive their blocks; release them */
+    for (auto &block : m_blocks) {
+        block->handle.reset();
+    }
+}
+
+SharedFrame FrameFanout::share(FrameHandle &&frame) {
+    FrameHandle handle = move(frame);
+    if (!handle.valid()) {
+        return SharedFrame();
+    }
+
+    SharedFrame::Block *block;
+    {
+        lock_guard<mutex> lock(m_free_mutex);
+        if (m_free.empty()) {
+            /* `handle` goes back to the stream on return */
+            m_exhausted++;
+            return SharedFrame();
+        }
+        block = m_free.back();
+        m_free.pop_back();
+    }
+
+    block->handle = move(handle);
+    block->refs.store(1, memory_order_relaxed);
+    m_shared++;
+    return SharedFrame(block, -1);
+}
+
+SharedFrame FrameFanout::retain(const SharedFrame &frame, size_t consumer) {
+    if (!frame.valid() || consumer >= m_consumers.size()) {
+        return SharedFrame();
+    }
+
+    ConsumerState &state = *m_consumers[consumer];
+    uint32_t limit = state.config.max_held;
+    uint32_t held = state.held.load(memory_order_relaxed);
+    do {
+        if (limit != 0 && held >= limit) {
+            state.refused++;
+            return SharedFrame();
+        }
+    } while (!state.held.compare_exchange_weak(held, held + 1, memory_order_relaxed));
+
+    uint32_t peak = state.peak_held.load(memory_order_relaxed);
+    while (held + 1 > peak && !state.peak_held.compare_exchange_weak(peak, held + 1, memory_order_relaxed)) {
+    }
+    state.retained++;
+
+    frame.m_block->refs.fetch_add(1, memory_order_relaxed);
+    return SharedFrame(frame.m_block, static_cast<int>(consumer));
+}
+
+void FrameFanout::addReference(SharedFrame::Block *block, int consumer) {
+    /* Copies are not limited: the consumer already holds the frame */
+    if (consumer >= 0) {
+        ConsumerState &state = *m_consumers[consumer];
+        uint32_t held = state.held.fetch_add(1, memory_order_relaxed) + 1;
+        uint32_t peak = state.peak_held.load(memory_order_relaxed);
+        while (held > peak && !state.peak_held.compare_exchange_weak(peak, held, memory_order_relaxed)) {
+        }
+    }
+    block->refs.fetch_add(1, memory_order_relaxed);
+}
+
+void FrameFanout::dropReference(SharedFrame::Block *block, int consumer) {
+    if (consumer >= 0) {
+        m_consumers[consumer]->held.fetch_sub(1, memory_order_relaxed);
+    }
+    if (block->refs.fetch_sub(1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    /* Last reference: the buffer goes back to the stream */
+    block->handle.reset();
+    lock_guard<mutex> lock(m_free_mutex);
+    m_free.push_back(block);
+}
+
+FanoutStats FrameFanout::getStats() const {
+    FanoutStats stats;
+    stats.shared = m_shared;
+    stats.exhausted = m_exhausted;
+    {
+        lock_guard<mutex> lock(m_free_mutex);
+        stats.in_flight = static_cast<uint32_t>(m_blocks.size() - m_free.size());
+    }
+    for (const auto &state : m_consumers) {
+        FanoutConsumerStats consumer;
+        consumer.name = state->config.name;
+        consumer.held = state->held;
+        consumer.peak_held = state->peak_held;
+        consumer.retained = state->retained;
+        consumer.refused = state->refused;
+        stats.consumers.push_back(consumer);
+    }
+    return stats;
+}
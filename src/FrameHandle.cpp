@@ -0,0 +1,73 @@
+#include "FrameHandle.hpp"
+#include "PixelConvert.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+FrameHandle::FrameHandle(FrameHandle &&other) noexcept :
+    m_stream(move(other.m_stream)), m_frame(other.m_frame)
+{
+    other.m_frame = FrameBuffer();
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle &&other) noexcept {
+    if (this != &other) {
+        reset();
+        m_stream = move(other.m_stream);
+        m_frame = other.m_frame;
+        other.m_frame = FrameBuffer();
+    }
+    return *this;
+}
+
+cv::Mat FrameHandle::mat() const {
+    if (!valid() || m_frame.data == nullptr) {
+        return cv::Mat();
+    }
+
+    int type;
+    switch (pixelStorageBits(m_frame.pixel_format)) {
+        case 8:  type = CV_8UC1; break;
+        case 16: type = CV_16UC1; break;
+        default: return cv::Mat();
+    }
+
+    return cv::Mat(m_frame.height, m_frame.width, type, m_frame.data, m_frame.stride);
+}
+
+span<const uint8_t> FrameHandle::bytes() const {
+    if (!valid() || m_frame.data == nullptr) {
+        return {};
+    }
+    return { static_cast<const uint8_t*>(m_frame.data), m_frame.payload_size };
+}
+
+span<const uint8_t> FrameHandle::row(int y) const {
+    if (!valid() || m_frame.data == nullptr || m_frame.stride == 0 || y < 0 || y >= m_frame.height) {
+        return {};
+    }
+    return { static_cast<const uint8_t*>(m_frame.data) + static_cast<size_t>(y) * m_frame.stride, m_frame.stride };
+}
+
+span<const uint16_t> FrameHandle::pixels16() const {
+    if (pixelStorageBits(m_frame.pixel_format) != 16) {
+        return {};
+    }
+    span<const uint8_t> raw = bytes();
+    return { reinterpret_cast<const uint16_t*>(raw.data()), raw.size() / sizeof(uint16_t) };
+}
+
+void FrameHandle::reset() {
+    if (m_stream) {
+        m_stream->releaseFrame(m_frame);
+        m_stream = nullptr;
+    }
+    m_frame = FrameBuffer();
+}
+
+FrameBuffer FrameHandle::detach() {
+    FrameBuffer frame = m_frame;
+    m_stream = nullptr;
+    m_frame = FrameBuffer();
+    return frame;
+}
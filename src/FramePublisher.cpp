@@ -0,0 +1,135 @@
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "BufferPool.hpp"
+#include "FramePublisher.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+/* Wake subscribers sleeping on `word`, in any process */
+static void wakeSubscribers(atomic<uint32_t> &word) {
+#if defined(__linux__)
+    /* A shared (not private) futex, so waiters in other processes see it */
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)word;     // subscribers poll
+#endif
+}
+
+unique_ptr<FramePublisher> FramePublisher::create(const FramePublisherConfig &config) {
+    if (config.name.empty() || config.hold_frames == 0) {
+        printf("Error : Invalid publisher configuration\n");
+        return nullptr;
+    }
+
+    /* Descriptors of held frames must not be rewritten while they are readable */
+    uint32_t capacity = 8;
+    while (capacity < 2 * config.hold_frames) {
+        capacity <<= 1;
+    }
+
+    size_t size = sizeof(PublisherHeader) + capacity * sizeof(PublishedFrame);
+    auto segment = MappedFile::createShared(config.name, size);
+    if (!segment) {
+        printf("Error : Could not create shared segment %s\n", config.name.c_str());
+        return nullptr;
+    }
+
+    /* The segment is zero-filled, which is a valid state for every atomic */
+    PublisherHeader *header = reinterpret_cast<PublisherHeader*>(segment->data());
+    header->version = PUBLISHER_VERSION;
+    header->descriptor_size = sizeof(PublishedFrame);
+    header->capacity = capacity;
+    header->hold_frames = config.hold_frames;
+    /* Subscribers check the magic last, so it goes in last */
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, PUBLISHER_MAGIC, sizeof(header->magic));
+
+    return unique_ptr<FramePublisher>(new FramePublisher(config, move(segment)));
+}
+
+FramePublisher::FramePublisher(const FramePublisherConfig &config, unique_ptr<MappedFile> segment) :
+    m_config(config),
+    m_segment(move(segment))
+{
+    m_header = reinterpret_cast<PublisherHeader*>(m_segment->data());
+    m_ring = reinterpret_cast<PublishedFrame*>(m_segment->data() + sizeof(PublisherHeader));
+}
+
+FramePublisher::~FramePublisher() {
+    /* Nothing is readable once the frames go back to the stream */
+    m_header->released.store(m_header->published.load(memory_order_relaxed), memory_order_release);
+    m_header->closed.store(1, memory_order_release);
+    m_header->wake.fetch_add(1, memory_order_release);
+    wakeSubscribers(m_header->wake);
+    m_held.clear();
+}
+
+bool FramePublisher::publish(FrameHandle &&frame) {
+    FrameHandle held = move(frame);
+    const FrameBuffer &buffer = held.frame();
+
+    const BufferPool *pool = held.valid() ? BufferPool::findShared(buffer.data) : nullptr;
+    if (pool == nullptr || pool->sharedName().size() >= SHARED_SEGMENT_NAME_SIZE) {
+        /* `held` goes back to the stream on return */
+        m_rejected++;
+        return false;
+    }
+
+    uint64_t number = m_header->published.load(memory_order_relaxed);
+    PublishedFrame &slot = m_ring[number & (m_header->capacity - 1)];
+
+    /* Readers that copy the slot while it is rewritten see the tag change */
+    slot.tag.store(0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(slot.segment, pool->sharedName().c_str(), pool->sharedName().size() + 1);
+    slot.offset = pool->offsetOf(buffer.data);
+    slot.payload_size = buffer.payload_size;
+    slot.frame_id = buffer.frame_id;
+    slot.timestamp_ns = buffer.timestamp_ns;
+    slot.system_timestamp_ns = buffer.system_timestamp_ns;
+    slot.width = buffer.width;
+    slot.height = buffer.height;
+    slot.offset_x = buffer.offset_x;
+    slot.offset_y = buffer.offset_y;
+    slot.stride = static_cast<uint32_t>(buffer.stride);
+    slot.pixel_format = static_cast<int32_t>(buffer.pixel_format);
+    slot.status = static_cast<int32_t>(buffer.status);
+    slot.reserved = 0;
+
+    slot.tag.store(number + 1, memory_order_release);
+    m_header->published.store(number + 1, memory_order_release);
+    m_held.emplace_back(number, move(held));
+
+    /* Retire the oldest frame: announce it first, then give it back */
+    while (m_held.size() > m_config.hold_frames) {
+        m_header->released.store(m_held.front().first + 1, memory_order_release);
+        m_held.pop_front();
+    }
+
+    /* Sequentially consistent against the subscriber's sleepers increment,
+     * so either it sees the new wake value or we see it sleeping */
+    m_header->wake.fetch_add(1);
+    if (m_header->sleepers.load() > 0) {
+        wakeSubscribers(m_header->wake);
+    }
+
+    m_published++;
+    return true;
+}
+
+FramePublisherStats FramePublisher::getStats() const {
+    FramePublisherStats stats;
+    stats.published = m_published;
+    stats.rejected = m_rejected;
+    return stats;
+}
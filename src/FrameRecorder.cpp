@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <cstring>
+
+#include "FrameRecorder.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + RECORDING_ALIGNMENT - 1) / RECORDING_ALIGNMENT * RECORDING_ALIGNMENT;
+}
+
+unique_ptr<FrameRecorder> FrameRecorder::create(const FrameRecorderConfig &config) {
+    if (config.path.empty() || config.max_frames == 0 || config.max_bytes == 0 || config.queue_depth == 0) {
+        printf("Error : Invalid recorder configuration\n");
+        return nullptr;
+    }
+
+    uint64_t index_offset = alignUp(sizeof(RecordingHeader));
+    uint64_t data_offset = index_offset + alignUp(config.max_frames * sizeof(RecordingIndexEntry));
+    uint64_t file_size = data_offset + alignUp(config.max_bytes);
+
+    auto file = MappedFile::create(config.path, static_cast<size_t>(file_size));
+    if (!file) {
+        printf("Error : Could not create recording %s\n", config.path.c_str());
+        return nullptr;
+    }
+
+    RecordingHeader *header = reinterpret_cast<RecordingHeader*>(file->data());
+    memcpy(header->magic, RECORDING_MAGIC, sizeof(header->magic));
+    header->version = RECORDING_VERSION;
+    header->entry_size = sizeof(RecordingIndexEntry);
+    header->capacity = config.max_frames;
+    header->frame_count = 0;
+    header->index_offset = index_offset;
+    header->data_offset = data_offset;
+    header->data_used = 0;
+    header->created_ns = hostTimeNs();
+
+    return unique_ptr<FrameRecorder>(new FrameRecorder(config, move(file)));
+}
+
+FrameRecorder::FrameRecorder(const FrameRecorderConfig &config, unique_ptr<MappedFile> file) :
+    m_config(config),
+    m_file(move(file)),
+    m_ring(config.queue_depth)
+{
+    m_header = reinterpret_cast<RecordingHeader*>(m_file->data());
+    m_index = reinterpret_cast<RecordingIndexEntry*>(m_file->data() + m_header->index_offset);
+
+    m_running = true;
+    m_writer = thread(&FrameRecorder::writerLoop, this);
+}
+
+bool FrameRecorder::submit(FrameHandle &&frame) {
+    m_submitted++;
+
+    FrameHandle queued = move(frame);
+    if (!m_running || !queued.valid() || !m_ring.tryPush(queued)) {
+        /* `queued` goes back to the stream on return */
+        m_dropped++;
+        return false;
+    }
+
+    m_submits.fetch_add(1, memory_order_release);
+    m_submits.notify_one();
+    return true;
+}
+
+optional<RecordError> FrameRecorder::close() {
+    if (!m_file) {
+        return nullopt;
+    }
+
+    m_running = false;
+    m_submits.fetch_add(1);
+    m_submits.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    uint64_t length = m_header->data_offset + m_header->data_used;
+    optional<RecordError> result = m_file->flush();
+    if (auto err = m_file->close(static_cast<size_t>(length)); err && !result) {
+        result = err;
+    }
+
+    m_file.reset();
+    m_header = nullptr;
+    m_index = nullptr;
+    return result;
+}
+
+FrameRecorderStats FrameRecorder::getStats() const {
+    FrameRecorderStats stats;
+    stats.submitted = m_submitted;
+    stats.written = m_written;
+    stats.dropped = m_dropped;
+    stats.skipped = m_skipped;
+    stats.bytes = m_bytes;
+    return stats;
+}
+
+void FrameRecorder::writerLoop() {
+    while (true) {
+        uint32_t seen = m_submits.load(memory_order_acquire);
+
+        FrameHandle *frame = m_ring.front();
+        if (frame == nullptr) {
+            /* Drain everything queued before close() returns */
+            if (!m_running) {
+                break;
+            }
+            m_submits.wait(seen, memory_order_acquire);
+            continue;
+        }
+
+        writeFrame(frame->frame());
+        m_ring.pop();
+    }
+}
+
+void FrameRecorder::writeFrame(const FrameBuffer &frame) {
+    uint64_t count = m_header->frame_count;
+    uint64_t offset = m_header->data_offset + m_header->data_used;
+    uint64_t end = offset + frame.payload_size;
+    if (count == m_header->capacity || end > m_file->size()) {
+        m_skipped++;
+        return;
+    }
+
+    memcpy(m_file->data() + offset, frame.data, frame.payload_size);
+
+    RecordingIndexEntry &entry = m_index[count];
+    entry.offset = offset;
+    entry.payload_size = frame.payload_size;
+    entry.frame_id = frame.frame_id;
+    entry.timestamp_ns = frame.timestamp_ns;
+    entry.system_timestamp_ns = frame.system_timestamp_ns;
+    entry.width = frame.width;
+    entry.height = frame.height;
+    entry.offset_x = frame.offset_x;
+    entry.offset_y = frame.offset_y;
+    entry.stride = static_cast<uint32_t>(frame.stride);
+    entry.pixel_format = static_cast<int32_t>(frame.pixel_format);
+    entry.status = static_cast<int32_t>(frame.status);
+    entry.reserved = 0;
+
+    /* Commit the frame only once its payload and entry are in place */
+    m_header->data_used = alignUp(end) - m_header->data_offset;
+    m_header->frame_count = count + 1;
+
+    m_written++;
+    m_bytes += frame.payload_size;
+}
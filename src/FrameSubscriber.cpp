@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#if defined(__linux__)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+#include "FrameSubscriber.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+shared_ptr<FrameSubscriber> FrameSubscriber::create(const string &name, uint32_t buffer_count) {
+    if (buffer_count == 0) {
+        printf("Error : Subscriber needs at least one buffer\n");
+        return nullptr;
+    }
+
+    /* Writable for the sleeper count */
+    auto segment = MappedFile::openShared(name, true);
+    if (!segment) {
+        printf("Error : No publisher named %s\n", name.c_str());
+        return nullptr;
+    }
+
+    const PublisherHeader *header = reinterpret_cast<const PublisherHeader*>(segment->data());
+    if (segment->size() < sizeof(PublisherHeader)
+        || memcmp(header->magic, PUBLISHER_MAGIC, sizeof(header->magic)) != 0) {
+        printf("Error : %s is not a frame publisher\n", name.c_str());
+        return nullptr;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (header->version != PUBLISHER_VERSION || header->descriptor_size != sizeof(PublishedFrame)
+        || header->capacity == 0 || (header->capacity & (header->capacity - 1)) != 0
+        || segment->size() < sizeof(PublisherHeader) + header->capacity * sizeof(PublishedFrame)) {
+        printf("Error : Unsupported publisher version\n");
+        return nullptr;
+    }
+
+    return shared_ptr<FrameSubscriber>(new FrameSubscriber(move(segment), buffer_count));
+}
+
+FrameSubscriber::FrameSubscriber(unique_ptr<MappedFile> segment, uint32_t buffer_count) :
+    m_segment(move(segment))
+{
+    m_header = reinterpret_cast<PublisherHeader*>(m_segment->data());
+    m_ring = reinterpret_cast<const PublishedFrame*>(m_segment->data() + sizeof(PublisherHeader));
+    m_next = m_header->published.load(memory_order_acquire);
+
+    for (uint32_t i = 0; i < buffer_count; i++) {
+        m_buffers.push_back(make_unique<SubscriberBuffer>());
+        m_free.push_back(m_buffers.back().get());
+    }
+}
+
+FrameSubscriber::~FrameSubscriber() {
+    stopWorker();
+    // The descriptors are owned by m_buffers, wherever they are queued
+    takeLatest();
+}
+
+bool FrameSubscriber::isCurrent(const FrameBuffer &frame) const {
+    const SubscriberBuffer *buffer = static_cast<const SubscriberBuffer*>(frame.parent_buffer);
+    return buffer != nullptr && buffer->number >= m_header->released.load(memory_order_acquire);
+}
+
+bool FrameSubscriber::publisherClosed() const {
+    return m_header->closed.load(memory_order_acquire) != 0;
+}
+
+void *FrameSubscriber::popBuffer(chrono::microseconds timeout) {
+    auto start = chrono::steady_clock::now();
+
+    while (true) {
+        /* Read before looking, so a frame published in between cuts the wait short */
+        uint32_t seen = m_header->wake.load();
+
+        if (void *buffer = takeNext()) {
+            return buffer;
+        }
+        if (timeout <= NO_WAIT || publisherClosed()) {
+            return nullptr;
+        }
+
+        chrono::microseconds remaining = chrono::microseconds(STREAM_WORKER_WAKEUP_US);
+        if (timeout != WAIT_FOREVER) {
+            remaining = timeout - chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+            if (remaining <= NO_WAIT) {
+                return nullptr;
+            }
+        }
+        waitForFrame(seen, remaining);
+    }
+}
+
+void *FrameSubscriber::takeNext() {
+    lock_guard<mutex> lock(m_mutex);
+    if (m_free.empty()) {
+        return nullptr;
+    }
+
+    uint64_t published = m_header->published.load(memory_order_acquire);
+    uint64_t released = m_header->released.load(memory_order_acquire);
+    if (m_next < released) {
+        /* Fell behind the publisher's hold window */
+        m_missed += released - m_next;
+        m_next = released;
+    }
+
+    while (m_next < published) {
+        uint64_t number = m_next++;
+        SubscriberBuffer *buffer = m_free.front();
+        if (!readDescriptor(number, *buffer)) {
+            m_missed++;
+            continue;
+        }
+
+        m_free.pop_front();
+        m_completed++;
+        if (buffer->frame.status != FrameStatus::SUCCESS) {
+            m_failures++;
+        }
+        return buffer;
+    }
+    return nullptr;
+}
+
+bool FrameSubscriber::readDescriptor(uint64_t number, SubscriberBuffer &buffer) {
+    const PublishedFrame &slot = m_ring[number & (m_header->capacity - 1)];
+    if (slot.tag.load(memory_order_acquire) != number + 1) {
+        return false;
+    }
+
+    /* Seqlock read: copy, then make sure the tag did not move meanwhile */
+    char segment[SHARED_SEGMENT_NAME_SIZE];
+    memcpy(segment, slot.segment, sizeof(segment));
+    uint64_t offset = slot.offset;
+    FrameBuffer &frame = buffer.frame;
+    frame.width = slot.width;
+    frame.height = slot.height;
+    frame.channels = 1;
+    frame.offset_x = slot.offset_x;
+    frame.offset_y = slot.offset_y;
+    frame.stride = slot.stride;
+    frame.payload_size = slot.payload_size;
+    frame.pixel_format = static_cast<PixelFormat>(slot.pixel_format);
+    frame.frame_id = slot.frame_id;
+    frame.timestamp_ns = slot.timestamp_ns;
+    frame.system_timestamp_ns = slot.system_timestamp_ns;
+    frame.status = static_cast<FrameStatus>(slot.status);
+
+    atomic_thread_fence(memory_order_acquire);
+    if (slot.tag.load(memory_order_relaxed) != number + 1
+        || m_header->released.load(memory_order_acquire) > number) {
+        return false;
+    }
+    segment[sizeof(segment) - 1] = '\0';
+
+    const MappedFile *pool = mapSegment(segment);
+    if (pool == nullptr || offset > pool->size() || frame.payload_size > pool->size() - offset) {
+        return false;
+    }
+    /* Read-only mapping */
+    frame.data = pool->data() + offset;
+    buffer.number = number;
+    return true;
+}
+
+const MappedFile *FrameSubscriber::mapSegment(const char *name) {
+    auto found = m_pools.find(name);
+    if (found != m_pools.end()) {
+        return found->second.get();
+    }
+
+    /* Pools are only replaced when the camera's payload changes, so they are kept */
+    auto pool = MappedFile::openShared(name, false);
+    const MappedFile *mapped = pool.get();
+    if (pool) {
+        m_pools.emplace(name, move(pool));
+    }
+    return mapped;
+}
+
+void FrameSubscriber::waitForFrame(uint32_t seen, chrono::microseconds timeout) {
+#if defined(__linux__)
+    struct timespec wait;
+    wait.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+    wait.tv_nsec = static_cast<long>(timeout.count() % 1000000) * 1000;
+
+    /* Shared futex on the publisher's counter; returns at once if it moved */
+    m_header->sleepers.fetch_add(1);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_header->wake), FUTEX_WAIT, seen, &wait, NULL, 0);
+    m_header->sleepers.fetch_sub(1);
+#else
+    (void)seen;
+    this_thread::sleep_for(min(timeout, chrono::microseconds(SUBSCRIBER_POLL_US)));
+#endif
+}
+
+void FrameSubscriber::pushBuffer(void *data) {
+    lock_guard<mutex> lock(m_mutex);
+    m_free.push_back(static_cast<SubscriberBuffer*>(data));
+}
+
+int FrameSubscriber::queuedFrameCount() {
+    lock_guard<mutex> lock(m_mutex);
+    uint64_t published = m_header->published.load(memory_order_acquire);
+    uint64_t next = max(m_next, m_header->released.load(memory_order_acquire));
+    return published > next ? static_cast<int>(published - next) : 0;
+}
+
+int FrameSubscriber::freeBufferCount() {
+    lock_guard<mutex> lock(m_mutex);
+    return static_cast<int>(m_free.size());
+}
+
+void FrameSubscriber::transportCounters(StreamStats &stats) {
+    stats.completed = m_completed;
+    stats.failures = m_failures;
+    stats.underruns = m_missed;
+}
+
+FrameStatus FrameSubscriber::bufferStatus(void *buffer) {
+    return static_cast<SubscriberBuffer*>(buffer)->frame.status;
+}
+
+uint64_t FrameSubscriber::bufferCompletedNs(void *buffer) {
+    /* Received by the publisher's transport; latency includes the hand-over */
+    return static_cast<SubscriberBuffer*>(buffer)->frame.system_timestamp_ns;
+}
+
+void FrameSubscriber::fillFrameBuffer(void *buffer, FrameBuffer &frame) {
+    frame = static_cast<SubscriberBuffer*>(buffer)->frame;
+    frame.parent_buffer = buffer;
+}
@@ -0,0 +1,36 @@
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+#include "Log.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+static atomic<LogLevel> log_level{LogLevel::LOG_LEVEL_WARNING};
+
+void setLogLevel(LogLevel level) {
+    log_level.store(level, memory_order_relaxed);
+}
+
+LogLevel getLogLevel() {
+    return log_level.load(memory_order_relaxed);
+}
+
+bool logEnabled(LogLevel level) {
+    return level != LogLevel::LOG_LEVEL_NONE && level <= getLogLevel();
+}
+
+void logMessage(LogLevel level, const char *format, ...) {
+    (void)level;
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+}  // namespace camera
+}  // namespace cynlr
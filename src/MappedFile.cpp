@@ -0,0 +1,310 @@
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "MappedFile.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+unique_ptr<MappedFile> MappedFile::create(const string &path, size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    unique_ptr<MappedFile> file(new MappedFile());
+    file->m_path = path;
+    file->m_writable = true;
+
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+        NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    file->m_file = handle;
+
+    /* Creating a mapping larger than the file extends it */
+    ULARGE_INTEGER length;
+    length.QuadPart = size;
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READWRITE, length.HighPart, length.LowPart, NULL);
+    if (mapping == NULL) {
+        return nullptr;
+    }
+    file->m_mapping = mapping;
+
+    file->m_memory = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (file->m_memory == NULL) {
+        return nullptr;
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return nullptr;
+    }
+    file->m_fd = fd;
+
+#if defined(__linux__)
+    /* Reserve real blocks; a sparse file would allocate them during recording */
+    if (posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0) {
+        return nullptr;
+    }
+#else
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        return nullptr;
+    }
+#endif
+
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    file->m_memory = memory;
+#endif
+
+    file->m_size = size;
+    return file;
+}
+
+unique_ptr<MappedFile> MappedFile::open(const string &path) {
+    unique_ptr<MappedFile> file(new MappedFile());
+    file->m_path = path;
+
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    file->m_file = handle;
+
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(handle, &length) || length.QuadPart == 0) {
+        return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        return nullptr;
+    }
+    file->m_mapping = mapping;
+
+    file->m_memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (file->m_memory == NULL) {
+        return nullptr;
+    }
+    file->m_size = static_cast<size_t>(length.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    file->m_fd = fd;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        return nullptr;
+    }
+
+    void *memory = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    file->m_memory = memory;
+    file->m_size = static_cast<size_t>(info.st_size);
+#endif
+
+    return file;
+}
+
+#if defined(_WIN32)
+static string sharedMappingName(const string &name) {
+    return "Local\\cynlr-" + name;
+}
+#else
+static string sharedMappingName(const string &name) {
+    return "/cynlr-" + name;
+}
+#endif
+
+unique_ptr<MappedFile> MappedFile::createShared(const string &name, size_t size) {
+    if (size == 0 || name.empty()) {
+        return nullptr;
+    }
+    unique_ptr<MappedFile> file(new MappedFile());
+    file->m_path = sharedMappingName(name);
+    file->m_writable = true;
+
+#if defined(_WIN32)
+    /* Backed by the page file; the name lives as long as some handle does */
+    ULARGE_INTEGER length;
+    length.QuadPart = size;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        length.HighPart, length.LowPart, file->m_path.c_str());
+    if (mapping == NULL) {
+        return nullptr;
+    }
+    file->m_mapping = mapping;
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        return nullptr;
+    }
+
+    file->m_memory = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (file->m_memory == NULL) {
+        return nullptr;
+    }
+#else
+    int fd = shm_open(file->m_path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return nullptr;
+    }
+    file->m_fd = fd;
+    file->m_shared_owner = true;
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        return nullptr;
+    }
+
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    file->m_memory = memory;
+#endif
+
+    file->m_size = size;
+    return file;
+}
+
+unique_ptr<MappedFile> MappedFile::openShared(const string &name, bool writable) {
+    unique_ptr<MappedFile> file(new MappedFile());
+    file->m_path = sharedMappingName(name);
+    file->m_writable = writable;
+
+#if defined(_WIN32)
+    HANDLE mapping = OpenFileMappingA(writable ? FILE_MAP_WRITE : FILE_MAP_READ, FALSE, file->m_path.c_str());
+    if (mapping == NULL) {
+        return nullptr;
+    }
+    file->m_mapping = mapping;
+
+    file->m_memory = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (file->m_memory == NULL) {
+        return nullptr;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    if (VirtualQuery(file->m_memory, &info, sizeof(info)) == 0) {
+        return nullptr;
+    }
+    file->m_size = info.RegionSize;
+#else
+    int fd = shm_open(file->m_path.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    file->m_fd = fd;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        return nullptr;
+    }
+
+    int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *memory = mmap(NULL, static_cast<size_t>(info.st_size), protection, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    file->m_memory = memory;
+    file->m_size = static_cast<size_t>(info.st_size);
+#endif
+
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+#if !defined(_WIN32)
+    if (m_shared_owner) {
+        shm_unlink(m_path.c_str());
+    }
+#endif
+}
+
+optional<RecordError> MappedFile::flush() {
+    if (m_memory == nullptr || !m_writable) {
+        return nullopt;
+    }
+#if defined(_WIN32)
+    if (!FlushViewOfFile(m_memory, 0) || !FlushFileBuffers(m_file)) {
+        return RecordError { .message = "Failed to flush the mapped file" };
+    }
+#else
+    if (msync(m_memory, m_size, MS_SYNC) != 0) {
+        return RecordError { .message = "Failed to flush the mapped file" };
+    }
+#endif
+    return nullopt;
+}
+
+optional<RecordError> MappedFile::close(size_t length) {
+    if (!m_writable) {
+        unmap();
+        return nullopt;
+    }
+
+#if defined(_WIN32)
+    HANDLE handle = m_file;
+    m_file = nullptr;
+    unmap();
+
+    /* The file cannot shrink while a view or mapping is open */
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(length);
+    bool truncated = SetFilePointerEx(handle, end, NULL, FILE_BEGIN) && SetEndOfFile(handle);
+    CloseHandle(handle);
+#else
+    int fd = m_fd;
+    m_fd = -1;
+    unmap();
+
+    bool truncated = ftruncate(fd, static_cast<off_t>(length)) == 0;
+    ::close(fd);
+#endif
+
+    if (!truncated) {
+        return RecordError { .message = "Failed to truncate the mapped file" };
+    }
+    return nullopt;
+}
+
+void MappedFile::unmap() {
+#if defined(_WIN32)
+    if (m_memory != nullptr) {
+        UnmapViewOfFile(m_memory);
+    }
+    if (m_mapping != nullptr) {
+        CloseHandle(m_mapping);
+    }
+    if (m_file != nullptr) {
+        CloseHandle(m_file);
+    }
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if (m_memory != nullptr) {
+        munmap(m_memory, m_size);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd = -1;
+#endif
+    m_memory = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,649 @@
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define PIXEL_KERNELS_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define PIXEL_KERNELS_NEON 1
+    #include <arm_neon.h>
+#endif
+
+/* GCC and Clang only emit SIMD instructions in functions that opt in; MSVC
+ * accepts the intrinsics anywhere. */
+#if defined(PIXEL_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define TARGET_SSE41 __attribute__((target("sse4.1")))
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define TARGET_SSE41
+    #define TARGET_AVX2
+#endif
+
+#include "PixelConvert.hpp"
+#include "PixelKernels.hpp"
+
+using namespace std;
+
+namespace cynlr {
+namespace camera {
+
+// ---------------------------------------------------------------------------
+// Scalar kernels (reference implementation and tail handling)
+// ---------------------------------------------------------------------------
+
+static void unpackMono10pScalar(const uint8_t *src, uint16_t *dst, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, src += 5) {
+        dst[i]     = static_cast<uint16_t>(src[0] | ((src[1] & 0x03) << 8));
+        dst[i + 1] = static_cast<uint16_t>((src[1] >> 2) | ((src[2] & 0x0F) << 6));
+        dst[i + 2] = static_cast<uint16_t>((src[2] >> 4) | ((src[3] & 0x3F) << 4));
+        dst[i + 3] = static_cast<uint16_t>((src[3] >> 6) | (src[4] << 2));
+    }
+    /* Pixels of a trailing incomplete group */
+    for (size_t bit = 0; i < count; i++, bit += 10) {
+        unsigned value = src[bit / 8] | (src[bit / 8 + 1] << 8);
+        dst[i] = static_cast<uint16_t>((value >> (bit % 8)) & 0x3FF);
+    }
+}
+
+static void unpackMono12pScalar(const uint8_t *src, uint16_t *dst, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, src += 3) {
+        dst[i]     = static_cast<uint16_t>(src[0] | ((src[1] & 0x0F) << 8));
+        dst[i + 1] = static_cast<uint16_t>((src[1] >> 4) | (src[2] << 4));
+    }
+    if (i < count) {
+        dst[i] = static_cast<uint16_t>(src[0] | ((src[1] & 0x0F) << 8));
+    }
+}
+
+static void unpackMono10PackedScalar(const uint8_t *src, uint16_t *dst, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, src += 3) {
+        dst[i]     = static_cast<uint16_t>((src[0] << 2) | (src[1] & 0x03));
+        dst[i + 1] = static_cast<uint16_t>((src[2] << 2) | ((src[1] >> 4) & 0x03));
+    }
+    if (i < count) {
+        dst[i] = static_cast<uint16_t>((src[0] << 2) | (src[1] & 0x03));
+    }
+}
+
+static void unpackMono12PackedScalar(const uint8_t *src, uint16_t *dst, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, src += 3) {
+        dst[i]     = static_cast<uint16_t>((src[0] << 4) | (src[1] & 0x0F));
+        dst[i + 1] = static_cast<uint16_t>((src[2] << 4) | (src[1] >> 4));
+    }
+    if (i < count) {
+        dst[i] = static_cast<uint16_t>((src[0] << 4) | (src[1] & 0x0F));
+    }
+}
+
+static void shift16To8Scalar(const uint16_t *src, uint8_t *dst, size_t count, int shift) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = static_cast<uint8_t>(min(src[i] >> shift, 255));
+    }
+}
+
+static void window16To8Scalar(const uint16_t *src, uint8_t *dst, size_t count, uint16_t low, uint32_t scale) {
+    for (size_t i = 0; i < count; i++) {
+        uint64_t offset = src[i] > low ? src[i] - low : 0;
+        dst[i] = static_cast<uint8_t>(min<uint64_t>((offset * scale) >> 16, 255));
+    }
+}
+
+/* Bytes occupied by `count` pixels of `bits` each */
+static size_t packedBytes(size_t count, size_t bits) {
+    return (count * bits + 7) / 8;
+}
+
+// ---------------------------------------------------------------------------
+// x86 kernels. Each step shuffles the bytes of every pixel into its own
+// 16-bit lane, then masks/shifts the lanes into place. Loads are 16 bytes
+// wide, so the bulk loops stop while a full load still fits in the source.
+// ---------------------------------------------------------------------------
+
+#if defined(PIXEL_KERNELS_X86)
+
+TARGET_SSE41 static void unpackMono10pSse41(const uint8_t *src, uint16_t *dst, size_t count) {
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9);
+    const __m128i align = _mm_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1);
+    const size_t total = packedBytes(count, 10);
+    size_t i = 0;
+    for (; i + 8 <= count && i / 4 * 5 + 16 <= total; i += 8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i / 4 * 5));
+        __m128i v = _mm_shuffle_epi8(raw, shuffle);
+        /* Shift each lane left so its 10 bits end at bit 15, then back down */
+        v = _mm_srli_epi16(_mm_mullo_epi16(v, align), 6);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+    unpackMono10pScalar(src + i / 4 * 5, dst + i, count - i);
+}
+
+TARGET_SSE41 static void unpackMono12pSse41(const uint8_t *src, uint16_t *dst, size_t count) {
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m128i mask = _mm_set1_epi16(0x0FFF);
+    const size_t total = packedBytes(count, 12);
+    size_t i = 0;
+    for (; i + 8 <= count && i / 2 * 3 + 16 <= total; i += 8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i / 2 * 3));
+        __m128i v = _mm_shuffle_epi8(raw, shuffle);
+        __m128i even = _mm_and_si128(v, mask);
+        __m128i odd = _mm_srli_epi16(v, 4);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_blend_epi16(even, odd, 0xAA));
+    }
+    unpackMono12pScalar(src + i / 2 * 3, dst + i, count - i);
+}
+
+TARGET_SSE41 static void unpackMono10PackedSse41(const uint8_t *src, uint16_t *dst, size_t count) {
+    const __m128i shuffle = _mm_setr_epi8(1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11);
+    const __m128i high_mask = _mm_set1_epi16(0x03FC);
+    const __m128i low_mask = _mm_set1_epi16(0x0003);
+    const size_t total = packedBytes(count, 12);
+    size_t i = 0;
+    for (; i + 8 <= count && i / 2 * 3 + 16 <= total; i += 8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i / 2 * 3));
+        __m128i v = _mm_shuffle_epi8(raw, shuffle);
+        __m128i high = _mm_and_si128(_mm_srli_epi16(v, 6), high_mask);
+        __m128i even = _mm_or_si128(high, _mm_and_si128(v, low_mask));
+        __m128i odd = _mm_or_si128(high, _mm_and_si128(_mm_srli_epi16(v, 4), low_mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_blend_epi16(even, odd, 0xAA));
+    }
+    unpackMono10PackedScalar(src + i / 2 * 3, dst + i, count - i);
+}
+
+TARGET_SSE41 static void unpackMono12PackedSse41(const uint8_t *src, uint16_t *dst, size_t count) {
+    const __m128i shuffle = _mm_setr_epi8(1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11);
+    const __m128i high_mask = _mm_set1_epi16(0x0FF0);
+    const __m128i low_mask = _mm_set1_epi16(0x000F);
+    const size_t total = packedBytes(count, 12);
+    size_t i = 0;
+    for (; i + 8 <= count && i / 2 * 3 + 16 <= total; i += 8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i / 2 * 3));
+        __m128i v = _mm_shuffle_epi8(raw, shuffle);
+        __m128i odd = _mm_srli_epi16(v, 4);
+        __m128i even = _mm_or_si128(_mm_and_si128(odd, high_mask), _mm_and_si128(v, low_mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_blend_epi16(even, odd, 0xAA));
+    }
+    unpackMono12PackedScalar(src + i / 2 * 3, dst + i, count - i);
+}
+
+TARGET_SSE41 static void shift16To8Sse41(const uint16_t *src, uint8_t *dst, size_t count, int shift) {
+    const __m128i bits = _mm_cvtsi32_si128(shift);
+    const __m128i limit = _mm_set1_epi16(255);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+        a = _mm_min_epu16(_mm_srl_epi16(a, bits), limit);
+        b = _mm_min_epu16(_mm_srl_epi16(b, bits), limit);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+    }
+    shift16To8Scalar(src + i, dst + i, count - i, shift);
+}
+
+TARGET_SSE41 static void window16To8Sse41(const uint16_t *src, uint8_t *dst, size_t count, uint16_t low, uint32_t scale) {
+    const __m128i offset = _mm_set1_epi16(static_cast<short>(low));
+    const __m128i factor = _mm_set1_epi16(static_cast<short>(scale));
+    const __m128i limit = _mm_set1_epi16(255);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+        a = _mm_min_epu16(_mm_mulhi_epu16(_mm_subs_epu16(a, offset), factor), limit);
+        b = _mm_min_epu16(_mm_mulhi_epu16(_mm_subs_epu16(b, offset), factor), limit);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+    }
+    window16To8Scalar(src + i, dst + i, count - i, low, scale);
+}
+
+/* Two 16-byte loads, `step` bytes apart, one per 128-bit lane */
+TARGET_AVX2 static inline __m256i loadLanes(const uint8_t *src, size_t step) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + step));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+TARGET_AVX2 static void unpackMono10pAvx2(const uint8_t *src, uint16_t *dst, size_t count) {
+    const __m256i shuffle = _mm256_setr_epi8(
+        0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9,
+        0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9);
+    const __m256i align = _mm256_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1, 64, 16, 4, 1, 64, 16, 4, 1);
+    const size_t total = packedBytes(count, 10);
+    size_t i = 0;
+    for (; i + 16 <= count && i / 4 * 5 + 10 + 16 <= total; i += 16) {
+        __m256i v = _mm256_shuffle_epi8(loadLanes(src + i / 4 * 5, 10), shuffle);
+        v = _mm256_srli_epi16(_mm256_mullo_epi16(v, align), 6);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    }
+    unpackMono10pScalar(src + i / 4 * 5, dst + i, count - i);
+}
+
+TARGET_AVX2 static void unpackMono12pAvx2(const uint8_t *src, uint16_t *dst, size_t count) {
+    const __m256i shuffle = _mm256_setr_epi8(
+        0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,
+        0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m256i mask = _mm256_set1_epi16(0x0FFF);
+    const size_t total = packedBytes(count, 12);
+    size_t i = 0;
+    for (; i + 16 <= count && i / 2 * 3 + 12 + 16 <= total; i += 16) {
+        __m256i v = _mm256_shuffle_epi8(loadLanes(src + i / 2 * 3, 12), shuffle);
+        __m256i even = _mm256_and_si256(v, mask);
+        __m256i odd = _mm256_srli_epi16(v, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_blend_epi16(even, odd, 0xAA));
+    }
+    unpackMono12pScalar(src + i / 2 * 3, dst + i, count - i);
+}
+
+TARGET_AVX2 static void unpackMono10PackedAvx2(const uint8_t *src, uint16_t *dst, size_t count) {
+    const __m256i shuffle = _mm256_setr_epi8(
+        1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11,
+        1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11);
+    const __m256i high_mask = _mm256_set1_epi16(0x03FC);
+    const __m256i low_mask = _mm256_set1_epi16(0x0003);
+    const size_t total = packedBytes(count, 12);
+    size_t i = 0;
+    for (; i + 16 <= count && i / 2 * 3 + 12 + 16 <= total; i += 16) {
+        __m256i v = _mm256_shuffle_epi8(loadLanes(src + i / 2 * 3, 12), shuffle);
+        __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 6), high_mask);
+        __m256i even = _mm256_or_si256(high, _mm256_and_si256(v, low_mask));
+        __m256i odd = _mm256_or_si256(high, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_blend_epi16(even, odd, 0xAA));
+    }
+    unpackMono10PackedScalar(src + i / 2 * 3, dst + i, count - i);
+}
+
+TARGET_AVX2 static void unpackMono12PackedAvx2(const uint8_t *src, uint16_t *dst, size_t count) {
+    const __m256i shuffle = _mm256_setr_epi8(
+        1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11,
+        1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11);
+    const __m256i high_mask = _mm256_set1_epi16(0x0FF0);
+    const __m256i low_mask = _mm256_set1_epi16(0x000F);
+    const size_t total = packedBytes(count, 12);
+    size_t i = 0;
+    for (; i + 16 <= count && i / 2 * 3 + 12 + 16 <= total; i += 16) {
+        __m256i v = _mm256_shuffle_epi8(loadLanes(src + i / 2 * 3, 12), shuffle);
+        __m256i odd = _mm256_srli_epi16(v, 4);
+        __m256i even = _mm256_or_si256(_mm256_and_si256(odd, high_mask), _mm256_and_si256(v, low_mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_blend_epi16(even, odd, 0xAA));
+    }
+    unpackMono12PackedScalar(src + i / 2 * 3, dst + i, count - i);
+}
+
+TARGET_AVX2 static void shift16To8Avx2(const uint16_t *src, uint8_t *dst, size_t count, int shift) {
+    const __m128i bits = _mm_cvtsi32_si128(shift);
+    const __m256i limit = _mm256_set1_epi16(255);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16));
+        a = _mm256_min_epu16(_mm256_srl_epi16(a, bits), limit);
+        b = _mm256_min_epu16(_mm256_srl_epi16(b, bits), limit);
+        /* packus works per 128-bit lane; restore pixel order afterwards */
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+    }
+    shift16To8Scalar(src + i, dst + i, count - i, shift);
+}
+
+TARGET_AVX2 static void window16To8Avx2(const uint16_t *src, uint8_t *dst, size_t count, uint16_t low, uint32_t scale) {
+    const __m256i offset = _mm256_set1_epi16(static_cast<short>(low));
+    const __m256i factor = _mm256_set1_epi16(static_cast<short>(scale));
+    const __m256i limit = _mm256_set1_epi16(255);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16));
+        a = _mm256_min_epu16(_mm256_mulhi_epu16(_mm256_subs_epu16(a, offset), factor), limit);
+        b = _mm256_min_epu16(_mm256_mulhi_epu16(_mm256_subs_epu16(b, offset), factor), limit);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+    }
+    window16To8Scalar(src + i, dst + i, count - i, low, scale);
+}
+
+static bool cpuHasSse41() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+static bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    /* The OS must also save the YMM registers on context switch */
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif  // PIXEL_KERNELS_X86
+
+// ---------------------------------------------------------------------------
+// NEON kernels (always available on AArch64)
+// ---------------------------------------------------------------------------
+
+#if defined(PIXEL_KERNELS_NEON)
+
+static const uint8_t NEON_SHUFFLE_10P[16] = { 0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9 };
+static const uint8_t NEON_SHUFFLE_12P[16] = { 0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11 };
+static const uint8_t NEON_SHUFFLE_PACKED[16] = { 1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11 };
+static const int16_t NEON_SHIFT_10P[8] = { 0, -2, -4, -6, 0, -2, -4, -6 };
+static const uint16_t NEON_ODD_LANES[8] = { 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF };
+
+static void unpackMono10pNeon(const uint8_t *src, uint16_t *dst, size_t count) {
+    const uint8x16_t shuffle = vld1q_u8(NEON_SHUFFLE_10P);
+    const int16x8_t shift = vld1q_s16(NEON_SHIFT_10P);
+    const uint16x8_t mask = vdupq_n_u16(0x03FF);
+    const size_t total = packedBytes(count, 10);
+    size_t i = 0;
+    for (; i + 8 <= count && i / 4 * 5 + 16 <= total; i += 8) {
+        uint16x8_t v = vreinterpretq_u16_u8(vqtbl1q_u8(vld1q_u8(src + i / 4 * 5), shuffle));
+        vst1q_u16(dst + i, vandq_u16(vshlq_u16(v, shift), mask));
+    }
+    unpackMono10pScalar(src + i / 4 * 5, dst + i, count - i);
+}
+
+static void unpackMono12pNeon(const uint8_t *src, uint16_t *dst, size_t count) {
+    const uint8x16_t shuffle = vld1q_u8(NEON_SHUFFLE_12P);
+    const uint16x8_t odd_lanes = vld1q_u16(NEON_ODD_LANES);
+    const uint16x8_t mask = vdupq_n_u16(0x0FFF);
+    const size_t total = packedBytes(count, 12);
+    size_t i = 0;
+    for (; i + 8 <= count && i / 2 * 3 + 16 <= total; i += 8) {
+        uint16x8_t v = vreinterpretq_u16_u8(vqtbl1q_u8(vld1q_u8(src + i / 2 * 3), shuffle));
+        uint16x8_t even = vandq_u16(v, mask);
+        uint16x8_t odd = vshrq_n_u16(v, 4);
+        vst1q_u16(dst + i, vbslq_u16(odd_lanes, odd, even));
+    }
+    unpackMono12pScalar(src + i / 2 * 3, dst + i, count - i);
+}
+
+static void unpackMono10PackedNeon(const uint8_t *src, uint16_t *dst, size_t count) {
+    const uint8x16_t shuffle = vld1q_u8(NEON_SHUFFLE_PACKED);
+    const uint16x8_t odd_lanes = vld1q_u16(NEON_ODD_LANES);
+    const uint16x8_t high_mask = vdupq_n_u16(0x03FC);
+    const uint16x8_t low_mask = vdupq_n_u16(0x0003);
+    const size_t total = packedBytes(count, 12);
+    size_t i = 0;
+    for (; i + 8 <= count && i / 2 * 3 + 16 <= total; i += 8) {
+        uint16x8_t v = vreinterpretq_u16_u8(vqtbl1q_u8(vld1q_u8(src + i / 2 * 3), shuffle));
+        uint16x8_t high = vandq_u16(vshrq_n_u16(v, 6), high_mask);
+        uint16x8_t even = vorrq_u16(high, vandq_u16(v, low_mask));
+        uint16x8_t odd = vorrq_u16(high, vandq_u16(vshrq_n_u16(v, 4), low_mask));
+        vst1q_u16(dst + i, vbslq_u16(odd_lanes, odd, even));
+    }
+    unpackMono10PackedScalar(src + i / 2 * 3, dst + i, count - i);
+}
+
+static void unpackMono12PackedNeon(const uint8_t *src, uint16_t *dst, size_t count) {
+    const uint8x16_t shuffle = vld1q_u8(NEON_SHUFFLE_PACKED);
+    const uint16x8_t odd_lanes = vld1q_u16(NEON_ODD_LANES);
+    const uint16x8_t high_mask = vdupq_n_u16(0x0FF0);
+    const uint16x8_t low_mask = vdupq_n_u16(0x000F);
+    const size_t total = packedBytes(count, 12);
+    size_t i = 0;
+    for (; i + 8 <= count && i / 2 * 3 + 16 <= total; i += 8) {
+        uint16x8_t v = vreinterpretq_u16_u8(vqtbl1q_u8(vld1q_u8(src + i / 2 * 3), shuffle));
+        uint16x8_t odd = vshrq_n_u16(v, 4);
+        uint16x8_t even = vorrq_u16(vandq_u16(odd, high_mask), vandq_u16(v, low_mask));
+        vst1q_u16(dst + i, vbslq_u16(odd_lanes, odd, even));
+    }
+    unpackMono12PackedScalar(src + i / 2 * 3, dst + i, count - i);
+}
+
+static void shift16To8Neon(const uint16_t *src, uint8_t *dst, size_t count, int shift) {
+    const int16x8_t bits = vdupq_n_s16(static_cast<int16_t>(-shift));
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x8_t a = vqmovn_u16(vshlq_u16(vld1q_u16(src + i), bits));
+        uint8x8_t b = vqmovn_u16(vshlq_u16(vld1q_u16(src + i + 8), bits));
+        vst1q_u8(dst + i, vcombine_u8(a, b));
+    }
+    shift16To8Scalar(src + i, dst + i, count - i, shift);
+}
+
+static inline uint8x8_t windowNeon(uint16x8_t v, uint16x8_t offset, uint16x4_t factor) {
+    uint16x8_t d = vqsubq_u16(v, offset);
+    uint16x4_t lo = vshrn_n_u32(vmull_u16(vget_low_u16(d), factor), 16);
+    uint16x4_t hi = vshrn_n_u32(vmull_u16(vget_high_u16(d), factor), 16);
+    return vqmovn_u16(vcombine_u16(lo, hi));
+}
+
+static void window16To8Neon(const uint16_t *src, uint8_t *dst, size_t count, uint16_t low, uint32_t scale) {
+    const uint16x8_t offset = vdupq_n_u16(low);
+    const uint16x4_t factor = vdup_n_u16(static_cast<uint16_t>(scale));
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x8_t a = windowNeon(vld1q_u16(src + i), offset, factor);
+        uint8x8_t b = windowNeon(vld1q_u16(src + i + 8), offset, factor);
+        vst1q_u8(dst + i, vcombine_u8(a, b));
+    }
+    window16To8Scalar(src + i, dst + i, count - i, low, scale);
+}
+
+#endif  // PIXEL_KERNELS_NEON
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+vector<PixelKernels> availablePixelKernels() {
+    vector<PixelKernels> available;
+
+#if defined(PIXEL_KERNELS_X86)
+    if (cpuHasAvx2()) {
+        available.push_back({
+            unpackMono10pAvx2,
+            unpackMono12pAvx2,
+            unpackMono10PackedAvx2,
+            unpackMono12PackedAvx2,
+            shift16To8Avx2,
+            window16To8Avx2,
+            "avx2",
+        });
+    }
+    if (cpuHasSse41()) {
+        available.push_back({
+            unpackMono10pSse41,
+            unpackMono12pSse41,
+            unpackMono10PackedSse41,
+            unpackMono12PackedSse41,
+            shift16To8Sse41,
+            window16To8Sse41,
+            "sse4.1",
+        });
+    }
+#elif defined(PIXEL_KERNELS_NEON)
+    available.push_back({
+        unpackMono10pNeon,
+        unpackMono12pNeon,
+        unpackMono10PackedNeon,
+        unpackMono12PackedNeon,
+        shift16To8Neon,
+        window16To8Neon,
+        "neon",
+    });
+#endif
+
+    available.push_back({
+        unpackMono10pScalar,
+        unpackMono12pScalar,
+        unpackMono10PackedScalar,
+        unpackMono12PackedScalar,
+        shift16To8Scalar,
+        window16To8Scalar,
+        "scalar",
+    });
+    return available;
+}
+
+static const PixelKernels &kernels() {
+    static const PixelKernels selected = availablePixelKernels().front();
+    return selected;
+}
+
+int pixelBitDepth(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::MONO8:         return 8;
+        case PixelFormat::MONO10:        return 10;
+        case PixelFormat::MONO12:        return 12;
+        case PixelFormat::MONO14:        return 14;
+        case PixelFormat::MONO16:        return 16;
+        case PixelFormat::MONO10P:       return 10;
+        case PixelFormat::MONO12P:       return 12;
+        case PixelFormat::MONO10_PACKED: return 10;
+        case PixelFormat::MONO12_PACKED: return 12;
+        default:                         return 0;
+    }
+}
+
+int pixelStorageBits(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::MONO8:         return 8;
+        case PixelFormat::MONO10:
+        case PixelFormat::MONO12:
+        case PixelFormat::MONO14:
+        case PixelFormat::MONO16:        return 16;
+        case PixelFormat::MONO10P:       return 10;
+        case PixelFormat::MONO12P:
+        case PixelFormat::MONO10_PACKED:
+        case PixelFormat::MONO12_PACKED: return 12;
+        default:                         return 0;
+    }
+}
+
+void unpackMono10p(const uint8_t *src, uint16_t *dst, size_t count) {
+    kernels().mono10p(src, dst, count);
+}
+
+void unpackMono12p(const uint8_t *src, uint16_t *dst, size_t count) {
+    kernels().mono12p(src, dst, count);
+}
+
+void unpackMono10Packed(const uint8_t *src, uint16_t *dst, size_t count) {
+    kernels().mono10_packed(src, dst, count);
+}
+
+void unpackMono12Packed(const uint8_t *src, uint16_t *dst, size_t count) {
+    kernels().mono12_packed(src, dst, count);
+}
+
+optional<ConvertError> unpackToMono16(const FrameBuffer &frame, uint16_t *dst, size_t dst_stride) {
+    if (frame.data == nullptr || dst == nullptr) {
+        return ConvertError { .message = "Frame has no data" };
+    }
+
+    const int storage_bits = pixelStorageBits(frame.pixel_format);
+    if (storage_bits == 0) {
+        return ConvertError { .message = "Unsupported pixel format" };
+    }
+
+    const uint8_t *src = static_cast<const uint8_t*>(frame.data);
+    const size_t width = static_cast<size_t>(frame.width);
+    const size_t height = static_cast<size_t>(frame.height);
+    const size_t src_stride = frame.stride != 0 ? frame.stride : packedBytes(width, storage_bits);
+    auto dst_row = [&](size_t y) {
+        return reinterpret_cast<uint16_t*>(reinterpret_cast<uint8_t*>(dst) + y * dst_stride);
+    };
+
+    if (frame.pixel_format == PixelFormat::MONO8) {
+        for (size_t y = 0; y < height; y++) {
+            const uint8_t *row = src + y * src_stride;
+            uint16_t *out = dst_row(y);
+            for (size_t x = 0; x < width; x++) {
+                out[x] = row[x];
+            }
+        }
+        return nullopt;
+    }
+
+    if (storage_bits == 16) {
+        for (size_t y = 0; y < height; y++) {
+            memcpy(dst_row(y), src + y * src_stride, width * sizeof(uint16_t));
+        }
+        return nullopt;
+    }
+
+    UnpackKernel kernel;
+    switch (frame.pixel_format) {
+        case PixelFormat::MONO10P:       kernel = kernels().mono10p; break;
+        case PixelFormat::MONO12P:       kernel = kernels().mono12p; break;
+        case PixelFormat::MONO10_PACKED: kernel = kernels().mono10_packed; break;
+        case PixelFormat::MONO12_PACKED: kernel = kernels().mono12_packed; break;
+        default: return ConvertError { .message = "Unsupported pixel format" };
+    }
+
+    if (frame.stride == 0 && (width * storage_bits) % 8 != 0) {
+        /* Rows do not start on a byte boundary; the image is one bit stream */
+        if (dst_stride != width * sizeof(uint16_t)) {
+            return ConvertError { .message = "Packed rows are not byte aligned" };
+        }
+        kernel(src, dst, width * height);
+        return nullopt;
+    }
+
+    for (size_t y = 0; y < height; y++) {
+        kernel(src + y * src_stride, dst_row(y), width);
+    }
+    return nullopt;
+}
+
+void shift16To8(const uint16_t *src, uint8_t *dst, size_t count, int shift) {
+    kernels().shift(src, dst, count, std::clamp(shift, 0, 15));
+}
+
+void window16To8(const uint16_t *src, uint8_t *dst, size_t count, uint16_t low, uint16_t high) {
+    if (high <= low) {
+        /* Degenerate window: threshold at `low` */
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = src[i] > low ? 255 : 0;
+        }
+        return;
+    }
+
+    /* 16.16 fixed-point gain, rounded up so `high` maps to exactly 255 */
+    const uint32_t range = static_cast<uint32_t>(high - low);
+    const uint32_t scale = ((255u << 16) + range - 1) / range;
+    if (scale > 0xFFFF) {
+        /* Windows narrower than 256 codes need more than 16 bits of gain */
+        window16To8Scalar(src, dst, count, low, scale);
+        return;
+    }
+    kernels().window(src, dst, count, low, scale);
+}
+
+void lut16To8(const uint16_t *src, uint8_t *dst, size_t count, const uint8_t *lut, size_t lut_size) {
+    if (lut_size == 0) {
+        return;
+    }
+    const size_t last = lut_size - 1;
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = lut[min<size_t>(src[i], last)];
+    }
+}
+
+const char *pixelKernelIsa() {
+    return kernels().isa;
+}
+
+}  // namespace camera
+}  // namespace cynlr
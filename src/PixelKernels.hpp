@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Per-instruction-set kernel tables behind PixelConvert.hpp. Internal to the
+ * library; the unit tests use it to check every kernel set against the
+ * scalar one. */
+
+namespace cynlr {
+namespace camera {
+
+typedef void (*UnpackKernel)(const uint8_t *src, uint16_t *dst, size_t count);
+typedef void (*ShiftKernel)(const uint16_t *src, uint8_t *dst, size_t count, int shift);
+typedef void (*WindowKernel)(const uint16_t *src, uint8_t *dst, size_t count, uint16_t low, uint32_t scale);
+
+typedef struct PixelKernels {
+    UnpackKernel mono10p;
+    UnpackKernel mono12p;
+    UnpackKernel mono10_packed;
+    UnpackKernel mono12_packed;
+    ShiftKernel shift;
+    WindowKernel window;    // 16.16 fixed-point `scale`; only used when it fits in 16 bits
+    const char *isa;
+} PixelKernels;
+
+/* Kernel sets this CPU can run, widest first. The scalar set, the
+ * reference for all others, is always last. */
+std::vector<PixelKernels> availablePixelKernels();
+
+}  // namespace camera
+}  // namespace cynlr
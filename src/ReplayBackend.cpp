@@ -0,0 +1,209 @@
+#include <cstdio>
+
+#include "ReplayBackend.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+unique_ptr<ReplayBackend> ReplayBackend::create(
+    const ReplayConfig &config,
+    uint32_t stream_buffer_count)
+{
+    if (config.speed <= 0.0) {
+        printf("Error : Invalid replay speed\n");
+        return nullptr;
+    }
+
+    auto file = MappedFile::open(config.path);
+    if (!file) {
+        printf("Error : Could not open recording %s\n", config.path.c_str());
+        return nullptr;
+    }
+
+    auto new_stream = make_shared<ReplayStream>(config, move(file));
+    if (auto err = new_stream->loadIndex()) {
+        printf("Error : %s\n", err->message);
+        return nullptr;
+    }
+
+    ReplayBackend *backend = new ReplayBackend(new_stream, stream_buffer_count);
+    return unique_ptr<ReplayBackend>(backend);
+}
+
+optional<CamError> ReplayBackend::startAcquisition() {
+    if (acquiring) {
+        stream->stop();
+    }
+    if (auto err = stream->start(stream_buffer_count)) {
+        return CamError { .message = err->message };
+    }
+    acquiring = true;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::stopAcquisition() {
+    stream->stop();
+    acquiring = false;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setAcquisitionMode(AcquisitionMode mode) {
+    stream->setSingleFrame(mode == AcquisitionMode::ACQUISITION_MODE_SINGLE_FRAME);
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setPixelFormat(PixelFormat format) {
+    PixelFormat recorded = stream->pixelFormat();
+    if (recorded != PixelFormat::UNKNOWN && format != recorded) {
+        return CamError { .message = "PixelFormat differs from the recording; not supported by replay" };
+    }
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setBinning(int dx, int dy) {
+    // Frames are replayed as recorded, so only "no further binning" matches
+    if (dx != 1 || dy != 1) {
+        return CamError { .message = "Binning is not supported by replay" };
+    }
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setRegion(int x, int y, int width, int height) {
+    Region recorded = stream->region();
+    Region region { .x = x, .y = y, .width = width, .height = height };
+    if (stream->frameCount() > 0 && region != recorded) {
+        return CamError { .message = "Region differs from the recording; not supported by replay" };
+    }
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setRegions(const vector<Region> &regions) {
+    if (regions.empty()) {
+        return CamError { .message = "No region given" };
+    }
+    if (regions.size() > 1) {
+        return CamError { .message = "Multiple regions are not supported by replay" };
+    }
+    return setRegion(regions[0].x, regions[0].y, regions[0].width, regions[0].height);
+}
+
+optional<CamError> ReplayBackend::setGain(double gain) {
+    (void)gain;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setAutoExposure(bool setAuto) {
+    (void)setAuto;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setExposureTime(double exposure_time_us) {
+    (void)exposure_time_us;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setFrameRate(double framerate) {
+    // Timing follows the recording; use setReplayMode to change the pace
+    (void)framerate;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::enablePtp(bool enable) {
+    (void)enable;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setTriggerMode(bool enable) {
+    trigger_mode = enable;
+    stream->setTriggerMode(enable);
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setTriggerSource(TriggerSource source) {
+    trigger_source = source;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setTriggerActivation(TriggerActivation activation) {
+    (void)activation;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setTriggerDelay(double delay_us) {
+    (void)delay_us;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::fireSoftwareTrigger() {
+    if (!trigger_mode || trigger_source != TriggerSource::SOFTWARE) {
+        return CamError { .message = "Software trigger is not enabled" };
+    }
+
+    uint64_t fired_ns = hostTimeNs();
+    if (auto err = stream->softwareTrigger()) {
+        return CamError { .message = err->message };
+    }
+    stream->recordTrigger(fired_ns);
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::enableLensPower(bool enable) {
+    (void)enable;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setupLensSerial(const char* baudRate) {
+    (void)baudRate;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setLensFocus(double voltage) {
+    (void)voltage;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::setLensResultCheck(bool enable) {
+    (void)enable;
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::checkLensResult() {
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::enableChunks(const vector<ChunkSelector> &chunks) {
+    // Recordings carry no chunk data, so FrameBuffer::chunks stays empty
+    (void)chunks;
+    return nullopt;
+}
+
+shared_ptr<IStream> ReplayBackend::getStream() {
+    return stream;
+}
+
+optional<CamError> ReplayBackend::setReplayMode(ReplayMode mode, double speed) {
+    if (speed <= 0.0) {
+        return CamError { .message = "Replay speed out of range" };
+    }
+    stream->setMode(mode, speed);
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::seekToFrameId(uint64_t frame_id) {
+    if (auto err = stream->seekToFrameId(frame_id)) {
+        return CamError { .message = err->message };
+    }
+    return nullopt;
+}
+
+optional<CamError> ReplayBackend::seekToTimestamp(uint64_t system_timestamp_ns) {
+    if (auto err = stream->seekToTimestamp(system_timestamp_ns)) {
+        return CamError { .message = err->message };
+    }
+    return nullopt;
+}
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,408 @@
+#include <algorithm>
+#include <cstring>
+
+#include "PixelConvert.hpp"
+#include "ReplayStream.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+ReplayStream::ReplayStream(const ReplayConfig &config, unique_ptr<MappedFile> file) :
+    m_config(config), m_file(move(file))
+{
+}
+
+ReplayStream::~ReplayStream() {
+    stop();
+    stopWorker();
+
+    delete static_cast<ReplayBuffer*>(takeLatest());
+    for (ReplayBuffer *buffer : m_input) {
+        delete buffer;
+    }
+    for (ReplayBuffer *buffer : m_output) {
+        delete buffer;
+    }
+}
+
+optional<StreamError> ReplayStream::loadIndex() {
+    size_t size = m_file->size();
+    if (size < sizeof(RecordingHeader)) {
+        return StreamError { .message = "Recording is too short" };
+    }
+
+    const RecordingHeader *header = reinterpret_cast<const RecordingHeader*>(m_file->data());
+    if (memcmp(header->magic, RECORDING_MAGIC, sizeof(header->magic)) != 0) {
+        return StreamError { .message = "Not a recording" };
+    }
+    if (header->version != RECORDING_VERSION || header->entry_size != sizeof(RecordingIndexEntry)) {
+        return StreamError { .message = "Unsupported recording version" };
+    }
+    if (header->frame_count > header->capacity
+        || header->index_offset % alignof(RecordingIndexEntry) != 0
+        || header->index_offset > size
+        || header->capacity > (size - header->index_offset) / sizeof(RecordingIndexEntry)) {
+        return StreamError { .message = "Recording index is corrupt" };
+    }
+
+    const RecordingIndexEntry *index = reinterpret_cast<const RecordingIndexEntry*>(
+        m_file->data() + header->index_offset);
+    for (uint64_t i = 0; i < header->frame_count; i++) {
+        const RecordingIndexEntry &entry = index[i];
+        if (entry.offset < header->data_offset || entry.offset > size
+            || entry.payload_size > size - entry.offset) {
+            return StreamError { .message = "Recording index points past the end of the file" };
+        }
+        if (entry.width <= 0 || entry.height <= 0) {
+            return StreamError { .message = "Recording index has an empty frame" };
+        }
+
+        int bits = pixelStorageBits(static_cast<PixelFormat>(entry.pixel_format));
+        if (bits == 0) {
+            return StreamError { .message = "Recording index has an unsupported pixel format" };
+        }
+
+        /* Stride 0 is a packed frame stored as one bit stream; otherwise the
+         * last row ends after height - 1 strides and one row of pixels */
+        uint64_t row_bytes = (static_cast<uint64_t>(entry.width) * bits + 7) / 8;
+        uint64_t image_size;
+        if (entry.stride == 0) {
+            image_size = (static_cast<uint64_t>(entry.width) * static_cast<uint64_t>(entry.height) * bits + 7) / 8;
+        } else {
+            if (entry.stride < row_bytes) {
+                return StreamError { .message = "Recording index has a stride shorter than a row" };
+            }
+            image_size = static_cast<uint64_t>(entry.stride) * static_cast<uint64_t>(entry.height - 1) + row_bytes;
+        }
+        if (image_size > entry.payload_size) {
+            return StreamError { .message = "Recording index has a frame larger than its payload" };
+        }
+    }
+
+    m_index = index;
+    m_count = header->frame_count;
+    return nullopt;
+}
+
+PixelFormat ReplayStream::pixelFormat() const {
+    if (m_count == 0) {
+        return PixelFormat::UNKNOWN;
+    }
+    return static_cast<PixelFormat>(m_index[0].pixel_format);
+}
+
+Region ReplayStream::region() const {
+    if (m_count == 0) {
+        return Region();
+    }
+    const RecordingIndexEntry &entry = m_index[0];
+    return Region { .x = entry.offset_x, .y = entry.offset_y, .width = entry.width, .height = entry.height };
+}
+
+void ReplayStream::setMode(ReplayMode mode, double speed) {
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+        m_config.mode = mode;
+        m_config.speed = speed;
+        m_reanchor = true;
+    }
+    m_player_cv.notify_all();
+}
+
+void ReplayStream::setLoop(bool loop) {
+    lock_guard<mutex> lock(m_queue_mutex);
+    m_config.loop = loop;
+}
+
+void ReplayStream::setSingleFrame(bool single_frame) {
+    lock_guard<mutex> lock(m_queue_mutex);
+    m_single_frame = single_frame;
+}
+
+void ReplayStream::setTriggerMode(bool enable) {
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+        m_trigger_mode = enable;
+        m_pending_triggers = 0;
+        m_reanchor = true;
+    }
+    m_player_cv.notify_all();
+}
+
+optional<StreamError> ReplayStream::seekToFrameId(uint64_t frame_id) {
+    const RecordingIndexEntry *end = m_index + m_count;
+    const RecordingIndexEntry *found = lower_bound(m_index, end, frame_id,
+        [](const RecordingIndexEntry &entry, uint64_t id) { return entry.frame_id < id; });
+    if (found == end) {
+        return StreamError { .message = "No frame at or after the requested id" };
+    }
+    return seekTo(static_cast<uint64_t>(found - m_index));
+}
+
+optional<StreamError> ReplayStream::seekToTimestamp(uint64_t system_timestamp_ns) {
+    const RecordingIndexEntry *end = m_index + m_count;
+    const RecordingIndexEntry *found = lower_bound(m_index, end, system_timestamp_ns,
+        [](const RecordingIndexEntry &entry, uint64_t ns) { return entry.system_timestamp_ns < ns; });
+    if (found == end) {
+        return StreamError { .message = "No frame at or after the requested timestamp" };
+    }
+    return seekTo(static_cast<uint64_t>(found - m_index));
+}
+
+optional<StreamError> ReplayStream::seekTo(uint64_t position) {
+    /* Frames of the old position must not surface after the seek */
+    ReplayBuffer *stale = static_cast<ReplayBuffer*>(takeLatest());
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+        if (stale != nullptr) {
+            m_output.push_back(stale);
+        }
+        for (ReplayBuffer *buffer : m_output) {
+            m_input.push_back(buffer);
+        }
+        m_output.clear();
+
+        m_position = position;
+        m_reanchor = true;
+    }
+    m_player_cv.notify_all();
+    return nullopt;
+}
+
+optional<StreamError> ReplayStream::start(uint32_t count) {
+    if (m_playing) {
+        return StreamError { .message = "Replay stream is already running" };
+    }
+    if (count == 0) {
+        return StreamError { .message = "Replay stream needs at least one buffer" };
+    }
+
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+
+        /* Frames left over from the previous run go back in line */
+        ReplayBuffer *stale = static_cast<ReplayBuffer*>(takeLatest());
+        if (stale != nullptr) {
+            m_output.push_back(stale);
+        }
+        for (ReplayBuffer *buffer : m_output) {
+            m_input.push_back(buffer);
+        }
+        m_output.clear();
+
+        if (count != m_buffer_count) {
+            /* Borrowed descriptors of the old generation are freed when released */
+            for (ReplayBuffer *buffer : m_input) {
+                delete buffer;
+            }
+            m_input.clear();
+
+            m_generation++;
+            m_buffer_count = count;
+            for (uint32_t i = 0; i < count; i++) {
+                ReplayBuffer *buffer = new ReplayBuffer();
+                buffer->generation = m_generation;
+                m_input.push_back(buffer);
+            }
+        }
+
+        m_reanchor = true;
+        m_pending_triggers = 0;
+    }
+
+    /* The player may have ended by itself at the end of the recording */
+    if (m_player.joinable()) {
+        m_player.join();
+    }
+    m_playing = true;
+    m_player = thread(&ReplayStream::playerLoop, this);
+
+    return nullopt;
+}
+
+void ReplayStream::stop() {
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+        m_playing = false;
+    }
+    m_player_cv.notify_all();
+    if (m_player.joinable()) {
+        m_player.join();
+    }
+}
+
+optional<StreamError> ReplayStream::softwareTrigger() {
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+        if (!m_playing) {
+            return StreamError { .message = "Replay stream is not acquiring" };
+        }
+        m_pending_triggers++;
+    }
+    m_player_cv.notify_all();
+    return nullopt;
+}
+
+void *ReplayStream::popBuffer(chrono::microseconds timeout) {
+    unique_lock<mutex> lock(m_queue_mutex);
+
+    auto ready = [this] { return !m_output.empty(); };
+    if (timeout == WAIT_FOREVER) {
+        /* Playback ends at the last frame, so give up once nothing more can arrive */
+        m_output_cv.wait(lock, [this] { return !m_output.empty() || !m_playing; });
+    } else if (timeout > NO_WAIT) {
+        m_output_cv.wait_for(lock, timeout, ready);
+    }
+
+    if (m_output.empty()) {
+        return nullptr;
+    }
+    ReplayBuffer *buffer = m_output.front();
+    m_output.pop_front();
+    return buffer;
+}
+
+void ReplayStream::pushBuffer(void *data) {
+    ReplayBuffer *buffer = static_cast<ReplayBuffer*>(data);
+
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+        if (buffer->generation != m_generation) {
+            /* Left over from before the buffer count changed */
+            delete buffer;
+            return;
+        }
+        m_input.push_back(buffer);
+    }
+    /* FAST mode waits for free descriptors */
+    m_player_cv.notify_all();
+}
+
+int ReplayStream::queuedFrameCount() {
+    lock_guard<mutex> lock(m_queue_mutex);
+    return static_cast<int>(m_output.size());
+}
+
+int ReplayStream::freeBufferCount() {
+    lock_guard<mutex> lock(m_queue_mutex);
+    return static_cast<int>(m_input.size());
+}
+
+void ReplayStream::transportCounters(StreamStats &stats) {
+    stats.completed = m_completed;
+    stats.failures = m_failures;
+    stats.underruns = m_underruns;
+}
+
+FrameStatus ReplayStream::bufferStatus(void *buffer) {
+    return static_cast<FrameStatus>(static_cast<ReplayBuffer*>(buffer)->entry->status);
+}
+
+uint64_t ReplayStream::bufferCompletedNs(void *buffer) {
+    return static_cast<ReplayBuffer*>(buffer)->completed_ns;
+}
+
+void ReplayStream::fillFrameBuffer(void *data, FrameBuffer &frame) {
+    const RecordingIndexEntry &entry = *static_cast<ReplayBuffer*>(data)->entry;
+    frame.parent_buffer = data;
+    /* Points into the read-only mapping */
+    frame.data = m_file->data() + entry.offset;
+    frame.width = entry.width;
+    frame.height = entry.height;
+    frame.channels = 1;
+    frame.offset_x = entry.offset_x;
+    frame.offset_y = entry.offset_y;
+    frame.stride = entry.stride;
+    frame.payload_size = entry.payload_size;
+    frame.pixel_format = static_cast<PixelFormat>(entry.pixel_format);
+    frame.frame_id = entry.frame_id;
+    frame.timestamp_ns = entry.timestamp_ns;
+    frame.system_timestamp_ns = entry.system_timestamp_ns;
+    frame.status = static_cast<FrameStatus>(entry.status);
+}
+
+void ReplayStream::playerLoop() {
+    chrono::steady_clock::time_point anchor_time;
+    uint64_t anchor_ns = 0;
+
+    unique_lock<mutex> lock(m_queue_mutex);
+    while (m_playing) {
+        if (m_trigger_mode) {
+            m_player_cv.wait(lock, [this] { return !m_playing || !m_trigger_mode || m_pending_triggers > 0; });
+            if (!m_playing || !m_trigger_mode) {
+                continue;
+            }
+        }
+
+        if (m_position >= m_count) {
+            if (!m_config.loop || m_count == 0) {
+                break;
+            }
+            m_position = 0;
+            m_reanchor = true;
+        }
+
+        const RecordingIndexEntry *entry = &m_index[m_position];
+
+        if (m_config.mode == ReplayMode::REAL_TIME && !m_trigger_mode) {
+            if (m_reanchor) {
+                anchor_time = chrono::steady_clock::now();
+                anchor_ns = entry->system_timestamp_ns;
+                m_reanchor = false;
+            }
+
+            /* Recorded spacing, scaled; out-of-order timestamps play at once */
+            int64_t offset_ns = static_cast<int64_t>(entry->system_timestamp_ns - anchor_ns);
+            auto due = anchor_time + chrono::nanoseconds(
+                static_cast<int64_t>(max<int64_t>(offset_ns, 0) / m_config.speed));
+
+            uint64_t position = m_position;
+            m_player_cv.wait_until(lock, due, [&] {
+                return !m_playing || m_reanchor || m_trigger_mode || m_position != position;
+            });
+            if (!m_playing || m_reanchor || m_trigger_mode || m_position != position) {
+                /* Stopped, seeked or switched mode while waiting */
+                continue;
+            }
+        } else if (m_config.mode == ReplayMode::FAST) {
+            uint64_t position = m_position;
+            m_player_cv.wait(lock, [&] {
+                return !m_playing || !m_input.empty() || m_position != position;
+            });
+            if (!m_playing || m_position != position) {
+                continue;
+            }
+        }
+
+        m_position++;
+        if (m_trigger_mode) {
+            m_pending_triggers--;
+        }
+
+        if (m_input.empty()) {
+            /* Every descriptor is held by the consumer: the frame is lost, as on a camera */
+            m_underruns++;
+            continue;
+        }
+
+        ReplayBuffer *buffer = m_input.front();
+        m_input.pop_front();
+        buffer->entry = entry;
+        buffer->completed_ns = hostTimeNs();
+        m_completed++;
+        if (entry->status != static_cast<int32_t>(FrameStatus::SUCCESS)) {
+            m_failures++;
+        }
+        m_output.push_back(buffer);
+
+        m_output_cv.notify_all();
+        if (m_single_frame) {
+            break;
+        }
+    }
+
+    /* Wake consumers blocked without a timeout; the stream plays no more */
+    m_playing = false;
+    lock.unlock();
+    m_output_cv.notify_all();
+}
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "SimulatedBackend.hpp"
+
+namespace cynlr {
+namespace camera {
+
+using namespace std;
+
+/* Largest binning factor the simulated sensor accepts on either axis */
+#define SIMULATED_MAX_BINNING 4
+
+/* Region offset and size step, and smallest region, in binned pixels */
+#define SIMULATED_REGION_INCREMENT 8
+#define SIMULATED_REGION_MIN 16
+
+unique_ptr<SimulatedBackend> SimulatedBackend::create(
+    const SimulatedConfig &config,
+    uint32_t stream_buffer_count)
+{
+    if (config.width <= 0 || config.height <= 0 || config.frame_rate <= 0.0) {
+        printf("Error : Invalid simulated sensor geometry or frame rate\n");
+        return nullptr;
+    }
+
+    auto new_stream = make_shared<SimulatedStream>(config);
+    if (auto err = new_stream->loadScene()) {
+        printf("Error : %s\n", err->message);
+        return nullptr;
+    }
+
+    SimulatedBackend *backend = new SimulatedBackend(config, new_stream, stream_buffer_count);
+    backend->settings.pixel_format = config.pixel_format;
+    backend->settings.frame_rate = config.frame_rate;
+    backend->settings.exposure_time_us = config.exposure_time_us;
+
+    return unique_ptr<SimulatedBackend>(backend);
+}
+
+optional<CamError> SimulatedBackend::startAcquisition() {
+    if (acquiring) {
+        stream->stop();
+    }
+    if (auto err = stream->start(stream_buffer_count)) {
+        return CamError { .message = err->message };
+    }
+    acquiring = true;
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::stopAcquisition() {
+    stream->stop();
+    acquiring = false;
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setAcquisitionMode(AcquisitionMode mode) {
+    /* Multi-frame has no frame count in this API and runs like continuous */
+    settings.single_frame = mode == AcquisitionMode::ACQUISITION_MODE_SINGLE_FRAME;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setPixelFormat(PixelFormat format) {
+    if (acquiring) {
+        return CamError { .message = "PixelFormat cannot be changed while acquiring" };
+    }
+    if (format == PixelFormat::UNKNOWN) {
+        return CamError { .message = "Unsupported pixel format" };
+    }
+    settings.pixel_format = format;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setBinning(int dx, int dy) {
+    if (acquiring) {
+        return CamError { .message = "Binning cannot be changed while acquiring" };
+    }
+    if (dx < 1 || dy < 1 || dx > SIMULATED_MAX_BINNING || dy > SIMULATED_MAX_BINNING) {
+        return CamError { .message = "Binning out of range" };
+    }
+    settings.binning_x = dx;
+    settings.binning_y = dy;
+    // Region coordinates are in binned pixels; fall back to the full sensor
+    settings.region = Region();
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setRegion(int x, int y, int width, int height) {
+    if (acquiring) {
+        return CamError { .message = "Region cannot be changed while acquiring" };
+    }
+
+    int width_max = config.width / settings.binning_x;
+    int height_max = config.height / settings.binning_y;
+    if (width < SIMULATED_REGION_MIN || height < SIMULATED_REGION_MIN) {
+        return CamError { .message = "Region is smaller than the sensor minimum" };
+    }
+    if (x < 0 || y < 0 || x + width > width_max || y + height > height_max) {
+        return CamError { .message = "Region exceeds the sensor" };
+    }
+    if (x % SIMULATED_REGION_INCREMENT != 0 || y % SIMULATED_REGION_INCREMENT != 0
+        || width % SIMULATED_REGION_INCREMENT != 0 || height % SIMULATED_REGION_INCREMENT != 0) {
+        return CamError { .message = "Region is not aligned to the sensor increments" };
+    }
+
+    // The pool is resized to the new payload on the next startAcquisition
+    settings.region = Region { .x = x, .y = y, .width = width, .height = height };
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setRegions(const vector<Region> &regions) {
+    if (regions.empty()) {
+        return CamError { .message = "No region given" };
+    }
+    if (regions.size() > 1) {
+        return CamError { .message = "Multiple regions are not supported by this camera" };
+    }
+    return setRegion(regions[0].x, regions[0].y, regions[0].width, regions[0].height);
+}
+
+optional<CamError> SimulatedBackend::setGain(double gain) {
+    if (gain < 0.0) {
+        return CamError { .message = "Gain out of range" };
+    }
+    settings.gain_db = gain;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setAutoExposure(bool setAuto) {
+    settings.auto_exposure = setAuto;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setExposureTime(double exposure_time_us) {
+    if (exposure_time_us <= 0.0) {
+        return CamError { .message = "Exposure time out of range" };
+    }
+    settings.exposure_time_us = exposure_time_us;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setFrameRate(double framerate) {
+    if (framerate <= 0.0) {
+        return CamError { .message = "Frame rate out of range" };
+    }
+    settings.frame_rate = framerate;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::enablePtp(bool enable) {
+    stream->setPtpEnabled(enable);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setTriggerMode(bool enable) {
+    settings.trigger_mode = enable;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setTriggerSource(TriggerSource source) {
+    settings.trigger_source = source;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setTriggerActivation(TriggerActivation activation) {
+    settings.trigger_activation = activation;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setTriggerDelay(double delay_us) {
+    if (delay_us < 0.0) {
+        return CamError { .message = "Trigger delay out of range" };
+    }
+    settings.trigger_delay_us = delay_us;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::fireSoftwareTrigger() {
+    if (!settings.trigger_mode || settings.trigger_source != TriggerSource::SOFTWARE) {
+        return CamError { .message = "Software trigger is not enabled" };
+    }
+
+    uint64_t fired_ns = hostTimeNs();
+    if (auto err = stream->softwareTrigger()) {
+        return CamError { .message = err->message };
+    }
+    stream->recordTrigger(fired_ns);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::enableLensPower(bool enable) {
+    settings.lens_powered = enable;
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setupLensSerial(const char* baudRate) {
+    (void)baudRate;
+    serial_port_open = true;
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setLensFocus(double voltage) {
+    if (!serial_port_open) {
+        return CamError { .message = "Lens serial port is not open" };
+    }
+
+    // Same safe range as the real lens driver
+    settings.lens_voltage = std::max(24.0, std::min(voltage, 70.0));
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::setLensResultCheck(bool enable) {
+    (void)enable;
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::checkLensResult() {
+    // The simulated lens link never loses bytes
+    return nullopt;
+}
+
+optional<CamError> SimulatedBackend::enableChunks(const vector<ChunkSelector> &chunks) {
+    settings.chunks = 0;
+    for (ChunkSelector chunk : chunks) {
+        settings.chunks |= 1u << static_cast<int>(chunk);
+    }
+    stream->applySettings(settings);
+    return nullopt;
+}
+
+shared_ptr<IStream> SimulatedBackend::getStream() {
+    return stream;
+}
+
+}  // namespace camera
+}  // namespace cynlr
@@ -0,0 +1,579 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "SimulatedStream.hpp"
+#include "PixelConvert.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+/* Side of a checkerboard square in sensor pixels */
+#define CHECKER_SIZE 32
+
+/* Blur below this sigma is invisible and is skipped */
+#define MIN_BLUR_SIGMA 0.3
+
+// ---------------------------------------------------------------------------
+// Packers, the inverse of the unpack kernels in PixelConvert.cpp. Input pixels
+// are already reduced to the format's bit depth.
+// ---------------------------------------------------------------------------
+
+static void packMono10p(const uint16_t *src, uint8_t *dst, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, dst += 5) {
+        dst[0] = static_cast<uint8_t>(src[i]);
+        dst[1] = static_cast<uint8_t>((src[i] >> 8) | (src[i + 1] << 2));
+        dst[2] = static_cast<uint8_t>((src[i + 1] >> 6) | (src[i + 2] << 4));
+        dst[3] = static_cast<uint8_t>((src[i + 2] >> 4) | (src[i + 3] << 6));
+        dst[4] = static_cast<uint8_t>(src[i + 3] >> 2);
+    }
+    /* Pixels of a trailing incomplete group */
+    memset(dst, 0, ((count - i) * 10 + 7) / 8);
+    for (size_t bit = 0; i < count; i++, bit += 10) {
+        unsigned value = static_cast<unsigned>(src[i]) << (bit % 8);
+        dst[bit / 8] |= static_cast<uint8_t>(value);
+        dst[bit / 8 + 1] |= static_cast<uint8_t>(value >> 8);
+    }
+}
+
+static void packMono12p(const uint16_t *src, uint8_t *dst, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, dst += 3) {
+        dst[0] = static_cast<uint8_t>(src[i]);
+        dst[1] = static_cast<uint8_t>((src[i] >> 8) | (src[i + 1] << 4));
+        dst[2] = static_cast<uint8_t>(src[i + 1] >> 4);
+    }
+    if (i < count) {
+        dst[0] = static_cast<uint8_t>(src[i]);
+        dst[1] = static_cast<uint8_t>(src[i] >> 8);
+    }
+}
+
+static void packMono10Packed(const uint16_t *src, uint8_t *dst, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, dst += 3) {
+        dst[0] = static_cast<uint8_t>(src[i] >> 2);
+        dst[1] = static_cast<uint8_t>((src[i] & 0x03) | ((src[i + 1] & 0x03) << 4));
+        dst[2] = static_cast<uint8_t>(src[i + 1] >> 2);
+    }
+    if (i < count) {
+        dst[0] = static_cast<uint8_t>(src[i] >> 2);
+        dst[1] = static_cast<uint8_t>(src[i] & 0x03);
+    }
+}
+
+static void packMono12Packed(const uint16_t *src, uint8_t *dst, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2, dst += 3) {
+        dst[0] = static_cast<uint8_t>(src[i] >> 4);
+        dst[1] = static_cast<uint8_t>((src[i] & 0x0F) | ((src[i + 1] & 0x0F) << 4));
+        dst[2] = static_cast<uint8_t>(src[i + 1] >> 4);
+    }
+    if (i < count) {
+        dst[0] = static_cast<uint8_t>(src[i] >> 4);
+        dst[1] = static_cast<uint8_t>(src[i] & 0x0F);
+    }
+}
+
+/* Bytes per row, or 0 when packed rows do not end on a byte boundary. Such
+ * rows follow each other without padding, as GenICam lays them out, so the
+ * frame is one bit stream (see unpackToMono16). */
+static size_t rowStride(int width, PixelFormat format) {
+    size_t row_bits = static_cast<size_t>(width) * pixelStorageBits(format);
+    return row_bits % 8 == 0 ? row_bits / 8 : 0;
+}
+
+static size_t frameBytes(int width, int height, PixelFormat format) {
+    return (static_cast<size_t>(width) * static_cast<size_t>(height) * pixelStorageBits(format) + 7) / 8;
+}
+
+static void packPixels(PixelFormat format, const uint16_t *src, uint8_t *dst, size_t count) {
+    switch (format) {
+        case PixelFormat::MONO10P:       packMono10p(src, dst, count); break;
+        case PixelFormat::MONO12P:       packMono12p(src, dst, count); break;
+        case PixelFormat::MONO10_PACKED: packMono10Packed(src, dst, count); break;
+        case PixelFormat::MONO12_PACKED: packMono12Packed(src, dst, count); break;
+        default:
+            memcpy(dst, src, count * sizeof(uint16_t));
+            break;
+    }
+}
+
+SimulatedStream::SimulatedStream(const SimulatedConfig &config) :
+    m_config(config), m_epoch(chrono::steady_clock::now()), m_rng(random_device{}())
+{
+    m_settings.pixel_format = config.pixel_format;
+    m_settings.frame_rate = config.frame_rate;
+    m_settings.exposure_time_us = config.exposure_time_us;
+}
+
+SimulatedStream::~SimulatedStream() {
+    stop();
+    stopWorker();
+
+    delete static_cast<SimulatedBuffer*>(takeLatest());
+    for (SimulatedBuffer *buffer : m_input) {
+        delete buffer;
+    }
+    for (SimulatedBuffer *buffer : m_output) {
+        delete buffer;
+    }
+}
+
+optional<StreamError> SimulatedStream::loadScene() {
+    int width = m_config.width;
+    int height = m_config.height;
+    m_scenes.clear();
+
+    switch (m_config.pattern) {
+        case SimulatedPattern::GRADIENT: {
+            cv::Mat scene(height, width, CV_16UC1);
+            double scale = 65535.0 / max(width + height - 2, 1);
+            for (int y = 0; y < height; y++) {
+                uint16_t *row = scene.ptr<uint16_t>(y);
+                for (int x = 0; x < width; x++) {
+                    row[x] = static_cast<uint16_t>((x + y) * scale);
+                }
+            }
+            m_scenes.push_back(scene);
+            break;
+        }
+        case SimulatedPattern::CHECKERBOARD: {
+            cv::Mat scene(height, width, CV_16UC1);
+            for (int y = 0; y < height; y++) {
+                uint16_t *row = scene.ptr<uint16_t>(y);
+                for (int x = 0; x < width; x++) {
+                    bool bright = ((x / CHECKER_SIZE) + (y / CHECKER_SIZE)) % 2 == 0;
+                    row[x] = bright ? 57344 : 8192;
+                }
+            }
+            m_scenes.push_back(scene);
+            break;
+        }
+        case SimulatedPattern::NOISE:
+            /* Rendered fresh for every frame */
+            break;
+        case SimulatedPattern::FILES:
+            if (m_config.files.empty()) {
+                return StreamError { .message = "No images given for the simulated scene" };
+            }
+            for (const string &file : m_config.files) {
+                cv::Mat image = cv::imread(file, cv::IMREAD_GRAYSCALE | cv::IMREAD_ANYDEPTH);
+                if (image.empty()) {
+                    return StreamError { .message = "Failed to load simulated scene image" };
+                }
+                if (image.depth() == CV_8U) {
+                    image.convertTo(image, CV_16U, 257.0);
+                } else if (image.depth() != CV_16U) {
+                    image.convertTo(image, CV_16U);
+                }
+                if (image.cols != width || image.rows != height) {
+                    cv::resize(image, image, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+                }
+                m_scenes.push_back(image);
+            }
+            break;
+    }
+
+    m_sensor.create(height, width, CV_16UC1);
+    return nullopt;
+}
+
+void SimulatedStream::applySettings(const SimulatedSettings &settings) {
+    lock_guard<mutex> lock(m_settings_mutex);
+
+    if (settings.lens_powered != m_settings.lens_powered ||
+        settings.lens_voltage != m_settings.lens_voltage) {
+        /* Start the transition from wherever the lens is right now */
+        uint64_t now = deviceTimeNs();
+        m_lens_from = lensVoltageAt(now);
+        m_lens_changed_ns = now;
+    }
+    m_settings = settings;
+}
+
+/* Readout window in binned pixels */
+static cv::Rect binnedRegion(const SimulatedConfig &config, const SimulatedSettings &settings) {
+    if (settings.region.width <= 0 || settings.region.height <= 0) {
+        return cv::Rect(0, 0, config.width / settings.binning_x, config.height / settings.binning_y);
+    }
+    return cv::Rect(settings.region.x, settings.region.y, settings.region.width, settings.region.height);
+}
+
+size_t SimulatedStream::payloadSize(const SimulatedSettings &settings) const {
+    cv::Rect region = binnedRegion(m_config, settings);
+    return frameBytes(region.width, region.height, settings.pixel_format);
+}
+
+optional<StreamError> SimulatedStream::start(uint32_t count) {
+    if (m_generating) {
+        return StreamError { .message = "Simulated stream is already running" };
+    }
+
+    size_t payload;
+    {
+        lock_guard<mutex> lock(m_settings_mutex);
+        payload = payloadSize(m_settings);
+    }
+
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+
+        /* Frames left over from the previous acquisition go back in line */
+        SimulatedBuffer *stale = static_cast<SimulatedBuffer*>(takeLatest());
+        if (stale != nullptr) {
+            m_output.push_back(stale);
+        }
+        for (SimulatedBuffer *buffer : m_output) {
+            m_input.push_back(buffer);
+        }
+        m_output.clear();
+
+        if (!m_pool || m_pool->bufferSize() != payload || m_pool->count() != count) {
+            /* Borrowed frames of the old pool are freed when released */
+            for (SimulatedBuffer *buffer : m_input) {
+                delete buffer;
+            }
+            m_input.clear();
+
+            m_pool = BufferPool::create(payload, count, m_config.pool_config);
+            if (!m_pool) {
+                return StreamError { .message = "Failed to allocate stream buffer pool" };
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                SimulatedBuffer *buffer = new SimulatedBuffer();
+                buffer->pool = m_pool;
+                buffer->data = m_pool->buffer(i);
+                m_input.push_back(buffer);
+            }
+        }
+    }
+
+    m_generating = true;
+    m_pending_triggers = 0;
+    m_generator = thread(&SimulatedStream::generatorLoop, this);
+
+    return nullopt;
+}
+
+void SimulatedStream::stop() {
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+        m_generating = false;
+    }
+    m_generator_cv.notify_all();
+    if (m_generator.joinable()) {
+        m_generator.join();
+    }
+}
+
+optional<StreamError> SimulatedStream::softwareTrigger() {
+    {
+        lock_guard<mutex> lock(m_queue_mutex);
+        if (!m_generating) {
+            return StreamError { .message = "Simulated stream is not acquiring" };
+        }
+        m_pending_triggers++;
+    }
+    m_generator_cv.notify_all();
+    return nullopt;
+}
+
+void *SimulatedStream::popBuffer(chrono::microseconds timeout) {
+    unique_lock<mutex> lock(m_queue_mutex);
+
+    auto ready = [this] { return !m_output.empty(); };
+    if (timeout == WAIT_FOREVER) {
+        /* Unlike a camera the generator can be stopped for good, so give up
+         * once nothing more can arrive */
+        m_output_cv.wait(lock, [this] { return !m_output.empty() || !m_generating; });
+    } else if (timeout > NO_WAIT) {
+        m_output_cv.wait_for(lock, timeout, ready);
+    }
+
+    if (m_output.empty()) {
+        return nullptr;
+    }
+    SimulatedBuffer *buffer = m_output.front();
+    m_output.pop_front();
+    return buffer;
+}
+
+void SimulatedStream::pushBuffer(void *data) {
+    SimulatedBuffer *buffer = static_cast<SimulatedBuffer*>(data);
+
+    lock_guard<mutex> lock(m_queue_mutex);
+    if (buffer->pool == m_pool) {
+        m_input.push_back(buffer);
+    } else {
+        /* Left over from before the pool was resized */
+        delete buffer;
+    }
+}
+
+int SimulatedStream::queuedFrameCount() {
+    lock_guard<mutex> lock(m_queue_mutex);
+    return static_cast<int>(m_output.size());
+}
+
+int SimulatedStream::freeBufferCount() {
+    lock_guard<mutex> lock(m_queue_mutex);
+    return static_cast<int>(m_input.size());
+}
+
+void SimulatedStream::transportCounters(StreamStats &stats) {
+    stats.completed = m_completed;
+    stats.failures = m_failures;
+    stats.underruns = m_underruns;
+}
+
+FrameStatus SimulatedStream::bufferStatus(void *buffer) {
+    return static_cast<SimulatedBuffer*>(buffer)->status;
+}
+
+uint64_t SimulatedStream::bufferCompletedNs(void *buffer) {
+    return static_cast<SimulatedBuffer*>(buffer)->system_timestamp_ns;
+}
+
+void SimulatedStream::fillFrameBuffer(void *data, FrameBuffer &frame) {
+    SimulatedBuffer *buffer = static_cast<SimulatedBuffer*>(data);
+    frame.parent_buffer = data;
+    frame.data = buffer->data;
+    frame.width = buffer->width;
+    frame.height = buffer->height;
+    frame.channels = 1;
+    frame.offset_x = buffer->offset_x;
+    frame.offset_y = buffer->offset_y;
+    frame.stride = buffer->stride;
+    frame.payload_size = buffer->payload_size;
+    frame.pixel_format = buffer->pixel_format;
+    frame.frame_id = buffer->frame_id;
+    frame.timestamp_ns = buffer->timestamp_ns;
+    frame.system_timestamp_ns = buffer->system_timestamp_ns;
+    frame.status = buffer->status;
+    frame.chunks = buffer->chunks;
+}
+
+void SimulatedStream::generatorLoop() {
+    uniform_real_distribution<double> failure(0.0, 1.0);
+    auto next = chrono::steady_clock::now();
+
+    while (m_generating) {
+        SimulatedSettings settings;
+        double lens_voltage;
+        {
+            lock_guard<mutex> lock(m_settings_mutex);
+            settings = m_settings;
+            lens_voltage = lensVoltageAt(deviceTimeNs());
+        }
+
+        /* Exposure longer than the frame period caps the rate, as on a sensor */
+        double period_us = max(1e6 / settings.frame_rate, settings.exposure_time_us);
+
+        SimulatedBuffer *buffer = nullptr;
+        {
+            unique_lock<mutex> lock(m_queue_mutex);
+            if (settings.trigger_mode) {
+                /* Poll the settings now and then in case trigger mode is turned off */
+                if (!m_generator_cv.wait_for(lock, chrono::microseconds(STREAM_WORKER_WAKEUP_US),
+                        [this] { return !m_generating || m_pending_triggers > 0; })) {
+                    continue;
+                }
+                if (!m_generating) {
+                    break;
+                }
+                m_pending_triggers--;
+
+                /* The frame completes after the trigger delay and the exposure */
+                next = chrono::steady_clock::now() + chrono::microseconds(
+                    static_cast<int64_t>(settings.trigger_delay_us + settings.exposure_time_us));
+            } else {
+                next += chrono::microseconds(static_cast<int64_t>(period_us));
+            }
+
+            m_generator_cv.wait_until(lock, next, [this] { return !m_generating; });
+            if (!m_generating) {
+                break;
+            }
+            if (!m_input.empty()) {
+                buffer = m_input.front();
+                m_input.pop_front();
+            }
+        }
+
+        /* Do not try to catch up after a stall; restart the schedule */
+        auto now = chrono::steady_clock::now();
+        if (now - next > chrono::microseconds(static_cast<int64_t>(period_us))) {
+            next = now;
+        }
+
+        uint64_t frame_id = ++m_frame_id;
+        if (buffer == nullptr) {
+            /* Every buffer is held by the consumer: the frame is lost */
+            m_underruns++;
+            continue;
+        }
+
+        renderFrame(*buffer, settings, lens_voltage);
+        buffer->frame_id = frame_id;
+        buffer->timestamp_ns = deviceTimeNs();
+        buffer->system_timestamp_ns = hostTimeNs();
+        buffer->status = failure(m_rng) < m_config.failure_rate
+            ? FrameStatus::MISSING_PACKETS : FrameStatus::SUCCESS;
+        stampChunks(*buffer, settings);
+        m_completed++;
+        if (buffer->status != FrameStatus::SUCCESS) {
+            m_failures++;
+        }
+
+        {
+            lock_guard<mutex> lock(m_queue_mutex);
+            m_output.push_back(buffer);
+        }
+        m_output_cv.notify_all();
+
+        if (settings.single_frame) {
+            break;
+        }
+    }
+
+    /* Wake consumers blocked without a timeout */
+    { lock_guard<mutex> lock(m_queue_mutex); }
+    m_output_cv.notify_all();
+}
+
+void SimulatedStream::renderFrame(SimulatedBuffer &buffer, const SimulatedSettings &settings, double lens_voltage) {
+    int width = m_config.width;
+
+    /* Scene at sensor resolution, scrolled by the accumulated motion */
+    if (m_scenes.empty()) {
+        cv::randu(m_sensor, 0, 65536);
+    } else {
+        const cv::Mat &scene = m_scenes[m_frame_id % m_scenes.size()];
+        int shift = static_cast<int>((m_frame_id * static_cast<uint64_t>(max(m_config.scroll_px, 0))) % width);
+        scene.colRange(shift, width).copyTo(m_sensor.colRange(0, width - shift));
+        if (shift > 0) {
+            scene.colRange(0, shift).copyTo(m_sensor.colRange(width - shift, width));
+        }
+    }
+
+    /* Only the window is read out, so everything below scales with its area */
+    cv::Rect region = binnedRegion(m_config, settings);
+    cv::Rect window(region.x * settings.binning_x, region.y * settings.binning_y,
+                    region.width * settings.binning_x, region.height * settings.binning_y);
+    cv::Mat image = m_sensor(window);
+    if (settings.binning_x > 1 || settings.binning_y > 1) {
+        cv::resize(image, m_binned, region.size(), 0, 0, cv::INTER_AREA);
+        image = m_binned;
+    }
+
+    double sigma = m_config.lens.max_blur;
+    if (settings.lens_powered) {
+        sigma = min(sigma, m_config.lens.blur_per_volt * fabs(lens_voltage - m_config.lens.focus_voltage));
+    }
+    sigma /= (settings.binning_x + settings.binning_y) / 2.0;
+    if (sigma > MIN_BLUR_SIGMA) {
+        cv::GaussianBlur(image, image, cv::Size(0, 0), sigma);
+    }
+
+    /* Auto exposure always lands on the nominal brightness */
+    double brightness = 1.0;
+    if (!settings.auto_exposure) {
+        brightness = settings.exposure_time_us / m_config.exposure_time_us * pow(10.0, settings.gain_db / 20.0);
+    }
+    if (brightness != 1.0) {
+        image.convertTo(image, CV_16U, brightness);
+    }
+
+    buffer.width = image.cols;
+    buffer.height = image.rows;
+    buffer.offset_x = region.x;
+    buffer.offset_y = region.y;
+    buffer.pixel_format = settings.pixel_format;
+    buffer.stride = rowStride(image.cols, settings.pixel_format);
+    buffer.payload_size = frameBytes(image.cols, image.rows, settings.pixel_format);
+    packFrame(image, buffer);
+}
+
+void SimulatedStream::packFrame(const cv::Mat &image, SimulatedBuffer &buffer) {
+    int shift = 16 - pixelBitDepth(buffer.pixel_format);
+    size_t width = static_cast<size_t>(image.cols);
+    size_t height = static_cast<size_t>(image.rows);
+    uint8_t *data = static_cast<uint8_t*>(buffer.data);
+
+    /* A bit-stream frame is packed in one go, other frames row by row */
+    bool bit_stream = buffer.stride == 0;
+    m_row.resize(bit_stream ? width * height : width);
+
+    for (size_t y = 0; y < height; y++) {
+        const uint16_t *src = image.ptr<uint16_t>(static_cast<int>(y));
+
+        if (buffer.pixel_format == PixelFormat::MONO8) {
+            uint8_t *dst = data + y * buffer.stride;
+            for (size_t x = 0; x < width; x++) {
+                dst[x] = static_cast<uint8_t>(src[x] >> 8);
+            }
+            continue;
+        }
+
+        uint16_t *row = m_row.data() + (bit_stream ? y * width : 0);
+        for (size_t x = 0; x < width; x++) {
+            row[x] = static_cast<uint16_t>(src[x] >> shift);
+        }
+        if (!bit_stream) {
+            packPixels(buffer.pixel_format, row, data + y * buffer.stride, width);
+        }
+    }
+
+    if (bit_stream) {
+        packPixels(buffer.pixel_format, m_row.data(), data, width * height);
+    }
+}
+
+void SimulatedStream::stampChunks(SimulatedBuffer &buffer, const SimulatedSettings &settings) const {
+    auto enabled = [&](ChunkSelector chunk) { return (settings.chunks & (1u << static_cast<int>(chunk))) != 0; };
+
+    buffer.chunks = FrameChunks();
+    if (enabled(ChunkSelector::EXPOSURE_TIME)) {
+        /* Auto exposure settles on the nominal exposure */
+        buffer.chunks.exposure_time_us = settings.auto_exposure ? m_config.exposure_time_us : settings.exposure_time_us;
+    }
+    if (enabled(ChunkSelector::GAIN)) {
+        buffer.chunks.gain = settings.auto_exposure ? 0.0 : settings.gain_db;
+    }
+    if (enabled(ChunkSelector::TIMESTAMP)) {
+        buffer.chunks.timestamp = buffer.timestamp_ns;
+    }
+    if (enabled(ChunkSelector::FRAME_ID)) {
+        buffer.chunks.frame_id = buffer.frame_id;
+    }
+    if (enabled(ChunkSelector::LINE_STATUS_ALL)) {
+        /* No I/O lines are simulated; all read low */
+        buffer.chunks.line_status_all = 0;
+    }
+    if (enabled(ChunkSelector::COUNTER_VALUE)) {
+        /* The simulated counter counts frame starts, lost frames included */
+        buffer.chunks.counter_value = buffer.frame_id;
+    }
+}
+
+double SimulatedStream::lensVoltageAt(uint64_t now_ns) const {
+    if (!m_settings.lens_powered) {
+        return 0.0;
+    }
+
+    double settle_ns = m_config.lens.settle_time_us * 1000.0;
+    double progress = settle_ns > 0.0 ? (now_ns - m_lens_changed_ns) / settle_ns : 1.0;
+    progress = min(progress, 1.0);
+
+    return m_lens_from + (m_settings.lens_voltage - m_lens_from) * progress;
+}
+
+uint64_t SimulatedStream::deviceTimeNs() const {
+    if (m_ptp) {
+        return hostTimeNs();
+    }
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now() - m_epoch).count());
+}
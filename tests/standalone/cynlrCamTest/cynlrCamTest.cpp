@@ -27,72 +27,48 @@ int main(int argc, char *argv[]) {
     printf("Starting acquisition...\n");
     abortOnError(cam.startAcquisition());
 
-    FrameBuffer curr_frame;
-    FrameBuffer prev_frame;
+    /* Handles release their frame when overwritten or destroyed, so the
+     * previous frame stays alive while the current one is displayed */
+    FrameHandle curr_frame;
+    FrameHandle prev_frame;
 
     abortOnError(cam.borrowNewestFrame(prev_frame));
 
     /* Test newest frame */
     while(1) {
         abortOnError(cam.borrowNewestFrame(curr_frame));
-        cv::Mat cv_frame(
-            curr_frame.height,
-            curr_frame.width,
-            CV_8UC1,
-            curr_frame.data
-        );
-
-        cv::imshow("Camera Grabber Test (newest frame)", cv_frame);
+
+        cv::imshow("Camera Grabber Test (newest frame)", curr_frame.mat());
         if(cv::waitKey(1) == 27) {
             break;
         }
 
-        cam.releaseFrame(prev_frame);
-        prev_frame = curr_frame;
+        prev_frame = std::move(curr_frame);
     }
 
     /* Test oldest frame */
     while(1) {
         abortOnError(cam.borrowOldestFrame(curr_frame));
 
-        cv::Mat cv_frame(
-            curr_frame.height,
-            curr_frame.width,
-            CV_8UC1,
-            curr_frame.data
-        );
-
-        cv::imshow("Camera Grabber Test (oldest frame)", cv_frame);
+        cv::imshow("Camera Grabber Test (oldest frame)", curr_frame.mat());
         if(cv::waitKey(1) == 27) {
             break;
         }
 
-        cam.releaseFrame(prev_frame);
-        prev_frame = curr_frame;
+        prev_frame = std::move(curr_frame);
     }  
 
     /* Test next new frame */
     while(1) {
         abortOnError(cam.borrowNextNewFrame(curr_frame));
 
-        cv::Mat cv_frame(
-            curr_frame.height,
-            curr_frame.width,
-            CV_8UC1,
-            curr_frame.data
-        );
-
-        cv::imshow("Camera Grabber Test (next new frame)", cv_frame);
+        cv::imshow("Camera Grabber Test (next new frame)", curr_frame.mat());
         if(cv::waitKey(1) == 27) {
             break;
         }
 
-        cam.releaseFrame(prev_frame);
-        prev_frame = curr_frame;
+        prev_frame = std::move(curr_frame);
     }
 
-    cam.releaseFrame(curr_frame);
-    cam.releaseFrame(prev_frame);
-
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,323 @@
+/* Acquisition throughput and latency benchmark.
+ *
+ * Runs the frame path against the in-process simulator and/or the Aravis
+ * "Fake" GenICam device across buffer counts, resolutions and pixel formats,
+ * and writes one JSON document with a result object per case, so runs can be
+ * diffed between releases. No camera is needed.
+ *
+ * Usage: frameBenchmark [--backend sim|fake|all] [--frames N] [--fps F]
+ *                       [--output results.json]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+extern "C" {
+    #include <arv.h>
+}
+
+#include "AravisBackend.hpp"
+#include "Camera.hpp"
+#include "PixelConvert.hpp"
+#include "SimulatedBackend.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+/* Frames consumed before measuring, so pool faults and thread start-up are
+ * not counted */
+#define WARMUP_FRAMES 20
+
+/* Device ID of the first Aravis fake camera */
+#define FAKE_DEVICE_ID "Fake_1"
+
+typedef struct BenchCase {
+    const char *backend;
+    uint32_t buffers;
+    int width;          // sensor size for the simulator
+    int height;
+    int binning;        // resolution axis for the fake camera
+    PixelFormat format;
+} BenchCase;
+
+typedef struct Percentiles {
+    double p50 = 0, p90 = 0, p99 = 0, max = 0;
+} Percentiles;
+
+static const char *formatName(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::MONO8:         return "Mono8";
+        case PixelFormat::MONO10:        return "Mono10";
+        case PixelFormat::MONO12:        return "Mono12";
+        case PixelFormat::MONO14:        return "Mono14";
+        case PixelFormat::MONO16:        return "Mono16";
+        case PixelFormat::MONO10P:       return "Mono10p";
+        case PixelFormat::MONO12P:       return "Mono12p";
+        case PixelFormat::MONO10_PACKED: return "Mono10Packed";
+        case PixelFormat::MONO12_PACKED: return "Mono12Packed";
+        default:                         return "Unknown";
+    }
+}
+
+/* Process CPU time (all threads) in microseconds */
+static double cpuTimeUs() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto to_us = [](FILETIME t) {
+        return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10.0;
+    };
+    return to_us(kernel) + to_us(user);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6
+        + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+static double elapsedUs(chrono::steady_clock::time_point since) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - since).count();
+}
+
+static Percentiles percentiles(vector<double> samples) {
+    Percentiles result;
+    if (samples.empty()) {
+        return result;
+    }
+    sort(samples.begin(), samples.end());
+    auto at = [&samples](double q) {
+        return samples[static_cast<size_t>(q * (samples.size() - 1) + 0.5)];
+    };
+    result.p50 = at(0.50);
+    result.p90 = at(0.90);
+    result.p99 = at(0.99);
+    result.max = samples.back();
+    return result;
+}
+
+static void writePercentiles(FILE *out, const char *name, const Percentiles &p) {
+    fprintf(out, "\"%s\": {\"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"max\": %.2f}",
+            name, p.p50, p.p90, p.p99, p.max);
+}
+
+/* Write `text` as a JSON string, quotes included. Camera error messages come
+ * from the device and may hold quotes, backslashes or control characters. */
+static void writeJsonString(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const unsigned char *c = reinterpret_cast<const unsigned char*>(text); *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static unique_ptr<ICameraBackend> createBackend(const BenchCase &bench, double fps) {
+    if (strcmp(bench.backend, "sim") == 0) {
+        SimulatedConfig config;
+        config.width = bench.width;
+        config.height = bench.height;
+        config.pixel_format = bench.format;
+        config.frame_rate = fps;
+        config.exposure_time_us = min(config.exposure_time_us, 1e6 / fps);
+        config.pattern = SimulatedPattern::GRADIENT;
+        config.lens.max_blur = 0.0;     // measure the frame path, not the blur
+        return SimulatedBackend::create(config, bench.buffers);
+    }
+    return AravisBackend::create(FAKE_DEVICE_ID, bench.buffers);
+}
+
+/* Run one case and append its JSON object to `out`. */
+static void runCase(FILE *out, const BenchCase &bench, uint32_t frames, double fps, bool first) {
+    fprintf(stderr, "%s buffers=%u %dx%d bin=%d %s ... ", bench.backend, bench.buffers,
+            bench.width, bench.height, bench.binning, formatName(bench.format));
+
+    fprintf(out, "%s\n    {\"backend\": \"%s\", \"buffers\": %u, \"pixel_format\": \"%s\", \"binning\": %d, ",
+            first ? "" : ",", bench.backend, bench.buffers, formatName(bench.format), bench.binning);
+
+    auto backend = createBackend(bench, fps);
+    if (!backend) {
+        fprintf(out, "\"error\": \"backend could not be created\"}");
+        fprintf(stderr, "skipped\n");
+        return;
+    }
+    Camera cam(move(backend));
+
+    /* The fake device caps its frame rate; run at its maximum instead */
+    bool rate_applied = !cam.setFrameRate(fps).has_value();
+
+    optional<CamError> setup;
+    if (!(setup = cam.setPixelFormat(bench.format)) &&
+        !(setup = cam.setBinning(bench.binning, bench.binning)) &&
+        !(setup = cam.setAcquisitionMode(AcquisitionMode::ACQUISITION_MODE_CONTINUOUS))) {
+        setup = cam.startAcquisition();
+    }
+    if (setup) {
+        fprintf(out, "\"error\": ");
+        writeJsonString(out, setup->message);
+        fprintf(out, "}");
+        fprintf(stderr, "skipped (%s)\n", setup->message);
+        return;
+    }
+
+    FrameHandle frame;
+    for (int i = 0; i < WARMUP_FRAMES; i++) {
+        if (cam.borrowOldestFrame(frame, chrono::seconds(1))) {
+            break;
+        }
+        frame.reset();
+    }
+
+    vector<double> borrow_us, release_us, delivery_us;
+    borrow_us.reserve(frames);
+    release_us.reserve(frames);
+    delivery_us.reserve(frames);
+
+    uint64_t dropped = 0;
+    uint64_t errors = 0;
+    uint64_t last_id = 0;
+    uint32_t received = 0;
+    int width = 0;
+    int height = 0;
+    size_t payload = 0;
+
+    double cpu_start = cpuTimeUs();
+    auto start = chrono::steady_clock::now();
+
+    while (received < frames) {
+        auto t0 = chrono::steady_clock::now();
+        if (cam.borrowOldestFrame(frame, chrono::seconds(1))) {
+            /* A stalled stream ends the case instead of hanging the suite */
+            if (++errors > 3) {
+                break;
+            }
+            continue;
+        }
+        borrow_us.push_back(elapsedUs(t0));
+
+        uint64_t now_ns = hostTimeNs();
+        if (now_ns > frame->system_timestamp_ns) {
+            delivery_us.push_back((now_ns - frame->system_timestamp_ns) / 1000.0);
+        }
+        if (last_id != 0 && frame->frame_id > last_id + 1) {
+            dropped += frame->frame_id - last_id - 1;
+        }
+        last_id = frame->frame_id;
+        width = frame->width;
+        height = frame->height;
+        payload = frame->payload_size;
+
+        auto t1 = chrono::steady_clock::now();
+        frame.reset();
+        release_us.push_back(elapsedUs(t1));
+
+        received++;
+    }
+
+    double wall_us = elapsedUs(start);
+    double cpu_us = cpuTimeUs() - cpu_start;
+    StreamStats stats = cam.getStreamStats();
+    cam.stopAcquisition();
+
+    double measured_fps = received > 0 ? received / (wall_us / 1e6) : 0.0;
+    fprintf(out, "\"width\": %d, \"height\": %d, \"payload_bytes\": %zu, ", width, height, payload);
+    fprintf(out, "\"frames\": %u, \"dropped\": %llu, \"errors\": %llu, \"underruns\": %llu, \"failures\": %llu, ",
+            received, static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(errors),
+            static_cast<unsigned long long>(stats.underruns), static_cast<unsigned long long>(stats.failures));
+    fprintf(out, "\"target_fps\": %.1f, \"fps\": %.2f, \"mbytes_per_s\": %.2f, \"cpu_us_per_frame\": %.2f, ",
+            rate_applied ? fps : 0.0, measured_fps, measured_fps * payload / 1e6, received > 0 ? cpu_us / received : 0.0);
+    writePercentiles(out, "borrow_us", percentiles(borrow_us));
+    fprintf(out, ", ");
+    writePercentiles(out, "release_us", percentiles(release_us));
+    fprintf(out, ", ");
+    writePercentiles(out, "delivery_us", percentiles(delivery_us));
+    fprintf(out, "}");
+
+    fprintf(stderr, "%.1f fps, %llu dropped\n", measured_fps, static_cast<unsigned long long>(dropped));
+}
+
+int main(int argc, char *argv[]) {
+    const char *backend = "all";
+    const char *output = nullptr;
+    uint32_t frames = 500;
+    double fps = 1000.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            backend = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--backend sim|fake|all] [--frames N] [--fps F] [--output file.json]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    bool run_sim = strcmp(backend, "sim") == 0 || strcmp(backend, "all") == 0;
+    bool run_fake = strcmp(backend, "fake") == 0 || strcmp(backend, "all") == 0;
+    if (run_fake) {
+        arv_enable_interface("Fake");
+    }
+
+    const uint32_t buffer_counts[] = { 3, 10, 30 };
+    const int sensor_sizes[][2] = { { 640, 480 }, { 1280, 1024 }, { 2448, 2048 } };
+    const int binnings[] = { 1, 2 };
+    const PixelFormat formats[] = { PixelFormat::MONO8, PixelFormat::MONO12P, PixelFormat::MONO16 };
+
+    vector<BenchCase> cases;
+    for (uint32_t buffers : buffer_counts) {
+        for (PixelFormat format : formats) {
+            if (run_sim) {
+                for (const auto &size : sensor_sizes) {
+                    cases.push_back({ "sim", buffers, size[0], size[1], 1, format });
+                }
+            }
+            if (run_fake) {
+                for (int binning : binnings) {
+                    cases.push_back({ "fake", buffers, 0, 0, binning, format });
+                }
+            }
+        }
+    }
+
+    FILE *out = stdout;
+    if (output != nullptr) {
+        out = fopen(output, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "Could not open %s\n", output);
+            return -1;
+        }
+    }
+
+    fprintf(out, "{\n  \"benchmark\": \"frameBenchmark\",\n  \"pixel_kernel_isa\": \"%s\",\n", pixelKernelIsa());
+    fprintf(out, "  \"frames_per_case\": %u,\n  \"cases\": [", frames);
+    for (size_t i = 0; i < cases.size(); i++) {
+        runCase(out, cases[i], frames, fps, i == 0);
+        fflush(out);
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
@@ -1,11 +1,13 @@
 #include <opencv2/opencv.hpp>
 #include "Camera.hpp"
 #include "AravisBackend.hpp"
+#include "Autofocus.hpp"
 #include <cstdio>
 #include <csignal>
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <future>
 
 using namespace cynlr::camera;
 
@@ -66,27 +68,26 @@ int main() {
     printf("  x : Focus down (-step)\n");
     printf("  e : Focus up   (+5.0V)\n");
     printf("  z : Focus down (-5.0V)\n");
+    printf("  a : Autofocus\n");
     printf("  +/- : Change step size\n");
     printf("  s   : Save snapshot\n");
     printf("  q   : Quit\n");
     printf("  Focus range: 24.0V - 70.0V\n");
     printf("================\n\n");
 
-    FrameBuffer frame{};
-    FrameBuffer prev_frame{};
-    bool has_prev = false;
-
-    // Grab an initial frame so we always have a prev_frame to release
-    abortOnError(cam.borrowNewestFrame(prev_frame));
-    has_prev = true;
+    FrameHandle frame;
+    std::future<ControlResult> focus_result;   // last focus change, sent by the control thread
 
     while (g_running) {
-        auto err = cam.borrowNewestFrame(frame);
-        if (err.has_value()) continue;
-
-        if (has_prev) cam.releaseFrame(prev_frame);
+        // Sleep until a frame arrives instead of spinning on an empty queue
+        auto err = cam.borrowNewestFrame(frame, std::chrono::milliseconds(1000));
+        if (err.has_value()) {
+            if (err->code == StreamErrorCode::TIMEOUT)
+                printf("No frame received within 1s\n");
+            continue;
+        }
 
-        cv::Mat mat(frame.height, frame.width, CV_8UC1, frame.data);
+        cv::Mat mat = frame.mat();
         cv::Mat display;
         cv::cvtColor(mat, display, cv::COLOR_GRAY2BGR);
 
@@ -97,6 +98,15 @@ int main() {
 
         cv::imshow("Camera", display);
 
+        if (focus_result.valid()
+            && focus_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            ControlResult result = focus_result.get();
+            if (result.error.has_value())
+                printf("  setLensFocus FAILED: %s\n", result.error->message);
+            else if (!result.superseded)
+                printf("  focus applied in %.1f ms\n", (result.completed_ns - result.queued_ns) / 1e6);
+        }
+
         int key = cv::waitKeyEx(1);
         if (key == 'q' || key == 27) break;
 
@@ -127,6 +137,23 @@ int main() {
                 focus_step = std::max(focus_step / 2.0, 0.1);
                 printf("Step size: %.1fV\n", focus_step);
                 break;
+            case 'a': case 'A': {
+                // Hand the stream to the search; it borrows its own frames
+                frame.reset();
+                AutofocusConfig af_config;
+                af_config.frame_latency_us = 1000000 / 24;   // one frame period at 24 fps
+                Autofocus autofocus(cam, af_config);
+                AutofocusResult af;
+                if (auto af_err = autofocus.run(af)) {
+                    printf("  Autofocus FAILED: %s\n", af_err->message);
+                    break;
+                }
+                focus_voltage = af.voltage;
+                printf("Autofocus: %.2fV (sharpness %.1f) in %.1f ms, %u frames, %u voltages%s\n",
+                       af.voltage, af.sharpness, af.time_to_focus.count() / 1000.0,
+                       af.frames, af.evaluations, af.converged ? "" : " (frame budget ran out)");
+                continue;
+            }
             case 's':
                 cv::imwrite("snapshot.png", mat);
                 printf("Snapshot saved (focus=%.1fV)\n", focus_voltage);
@@ -135,15 +162,18 @@ int main() {
 
         if (focus_changed) {
             printf("Focus: %.1fV\n", focus_voltage);
-            auto ferr = cam.setLensFocus(focus_voltage);
-            if (ferr.has_value())
-                printf("  setLensFocus FAILED: %s\n", ferr->message);
+            // Queued so the display loop keeps consuming frames meanwhile
+            focus_result = cam.setLensFocusAsync(focus_voltage);
         }
     }
 
     // Cleanup — runs on q/ESC exit AND on Ctrl+C
     printf("\nCleaning up...\n");
-    if (has_prev) cam.releaseFrame(prev_frame);
+    frame.reset();
+    // The lens must see the last setpoint before it is powered down
+    if (focus_result.valid()) {
+        focus_result.wait();
+    }
     cam.stopAcquisition();
     cam.enableLensPower(false);
     cv::destroyAllWindows();
@@ -0,0 +1,140 @@
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Camera.hpp"
+#include "FrameFanout.hpp"
+#include "SimulatedBackend.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+#define BORROW_TIMEOUT chrono::milliseconds(1000)
+#define CONSUMERS 3
+
+static unique_ptr<Camera> makeCamera() {
+    SimulatedConfig sim;
+    sim.frame_rate = 500.0;
+    sim.exposure_time_us = 1000.0;
+    sim.width = 256;
+    sim.height = 256;
+    return make_unique<Camera>(SimulatedBackend::create(sim, 8));
+}
+
+/* Buffers back in the stream, whether filled or not */
+static int buffersInStream(Camera &camera) {
+    StreamStats stats = camera.getStreamStats();
+    return stats.free_buffers + stats.queued_frames;
+}
+
+TEST(FrameFanout, BufferReturnsWhenTheLastReferenceIsDropped) {
+    auto camera = makeCamera();
+    ASSERT_FALSE(camera->startAcquisition().has_value());
+    FrameHandle frame;
+    ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+    const uint8_t *data = frame.bytes().data();
+    /* Stopped, so only releases change the buffer count */
+    ASSERT_FALSE(camera->stopAcquisition().has_value());
+    int in_stream = buffersInStream(*camera);
+
+    FrameFanout fanout(vector<FanoutConsumer>(CONSUMERS));
+    SharedFrame producer = fanout.share(move(frame));
+    ASSERT_TRUE(producer.valid());
+
+    /* Each consumer thread holds its reference until told to drop it */
+    vector<promise<void>> drop(CONSUMERS);
+    vector<thread> consumers;
+    for (size_t i = 0; i < CONSUMERS; i++) {
+        SharedFrame reference = fanout.retain(producer, i);
+        ASSERT_TRUE(reference.valid());
+        consumers.emplace_back([&, i, reference = move(reference)]() mutable {
+            /* The same buffer, not a copy */
+            EXPECT_EQ(reference.bytes().data(), data);
+            drop[i].get_future().wait();
+            reference.reset();
+        });
+    }
+    EXPECT_EQ(producer.useCount(), CONSUMERS + 1u);
+    producer.reset();
+
+    for (size_t i = 0; i < CONSUMERS; i++) {
+        EXPECT_EQ(buffersInStream(*camera), in_stream);
+        drop[i].set_value();
+        consumers[i].join();
+    }
+    EXPECT_EQ(buffersInStream(*camera), in_stream + 1);
+
+    FanoutStats stats = fanout.getStats();
+    EXPECT_EQ(stats.shared, 1u);
+    EXPECT_EQ(stats.in_flight, 0u);
+    for (const FanoutConsumerStats &consumer : stats.consumers) {
+        EXPECT_EQ(consumer.held, 0u);
+        EXPECT_EQ(consumer.peak_held, 1u);
+        EXPECT_EQ(consumer.retained, 1u);
+    }
+}
+
+TEST(FrameFanout, ConsumerIsRefusedAtItsLimit) {
+    auto camera = makeCamera();
+    ASSERT_FALSE(camera->startAcquisition().has_value());
+
+    FrameFanout fanout({ FanoutConsumer { .name = "slow", .max_held = 2 } });
+    vector<SharedFrame> producer;
+    vector<SharedFrame> held;
+    for (int i = 0; i < 3; i++) {
+        FrameHandle frame;
+        ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        producer.push_back(fanout.share(move(frame)));
+        ASSERT_TRUE(producer.back().valid());
+        held.push_back(fanout.retain(producer.back(), 0));
+    }
+    EXPECT_TRUE(held[0].valid());
+    EXPECT_TRUE(held[1].valid());
+    EXPECT_FALSE(held[2].valid());
+
+    FanoutConsumerStats stats = fanout.getStats().consumers[0];
+    EXPECT_EQ(stats.held, 2u);
+    EXPECT_EQ(stats.retained, 2u);
+    EXPECT_EQ(stats.refused, 1u);
+
+    /* Dropping a reference makes room again */
+    held[0].reset();
+    held[2] = fanout.retain(producer[2], 0);
+    EXPECT_TRUE(held[2].valid());
+
+    held.clear();
+    producer.clear();
+    EXPECT_FALSE(camera->stopAcquisition().has_value());
+}
+
+TEST(FrameFanout, SharingPastCapacityReleasesTheFrame) {
+    auto camera = makeCamera();
+    ASSERT_FALSE(camera->startAcquisition().has_value());
+
+    FrameFanout fanout(vector<FanoutConsumer>(1), 2);
+    vector<SharedFrame> shared;
+    for (int i = 0; i < 2; i++) {
+        FrameHandle frame;
+        ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        shared.push_back(fanout.share(move(frame)));
+        ASSERT_TRUE(shared.back().valid());
+    }
+
+    FrameHandle frame;
+    ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+    ASSERT_FALSE(camera->stopAcquisition().has_value());
+    int in_stream = buffersInStream(*camera);
+
+    /* No block left: the frame goes straight back to the stream */
+    EXPECT_FALSE(fanout.share(move(frame)).valid());
+    EXPECT_EQ(buffersInStream(*camera), in_stream + 1);
+
+    FanoutStats stats = fanout.getStats();
+    EXPECT_EQ(stats.shared, 2u);
+    EXPECT_EQ(stats.exhausted, 1u);
+    EXPECT_EQ(stats.in_flight, 2u);
+}
@@ -0,0 +1,154 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+    #include <process.h>
+    #define getpid _getpid
+#else
+    #include <unistd.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "Camera.hpp"
+#include "FramePublisher.hpp"
+#include "FrameSubscriber.hpp"
+#include "SimulatedBackend.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+#define BORROW_TIMEOUT chrono::milliseconds(1000)
+#define HOLD_FRAMES 4
+
+/* Publisher and subscriber in one process, on a simulated camera whose
+ * buffer pool lives in shared memory */
+class FramePublisherTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        /* Unique per test and process, so parallel runs do not collide, and
+         * short enough for the pool name to fit SHARED_SEGMENT_NAME_SIZE */
+        static int test_counter = 0;
+        m_name = "pubtest-" + to_string(getpid()) + "-" + to_string(test_counter++);
+
+        SimulatedConfig sim;
+        sim.frame_rate = 500.0;
+        sim.exposure_time_us = 1000.0;
+        sim.width = 256;
+        sim.height = 256;
+        sim.pool_config.shared_name = m_name;
+        m_camera = make_unique<Camera>(SimulatedBackend::create(sim, 16));
+
+        FramePublisherConfig config;
+        config.name = m_name;
+        config.hold_frames = HOLD_FRAMES;
+        m_publisher = FramePublisher::create(config);
+        ASSERT_TRUE(m_publisher);
+
+        m_subscriber = FrameSubscriber::create(m_name, 1);
+        ASSERT_TRUE(m_subscriber);
+        ASSERT_FALSE(m_camera->startAcquisition().has_value());
+    }
+
+    void TearDown() override {
+        m_subscriber.reset();
+        m_publisher.reset();
+        if (m_camera) {
+            m_camera->stopAcquisition();
+        }
+    }
+
+    /* Publish the next camera frame and return where its payload lives */
+    uint8_t *publishNext() {
+        FrameHandle frame;
+        EXPECT_FALSE(m_camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        if (!frame.valid()) {
+            return nullptr;
+        }
+        uint8_t *data = const_cast<uint8_t*>(frame.bytes().data());
+        EXPECT_TRUE(m_publisher->publish(move(frame)));
+        return data;
+    }
+
+    FrameHandle borrowFromSubscriber(chrono::milliseconds timeout = BORROW_TIMEOUT) {
+        FrameBuffer buffer;
+        if (m_subscriber->borrowOldestFrame(buffer, timeout)) {
+            return FrameHandle();
+        }
+        return FrameHandle(m_subscriber, buffer);
+    }
+
+    string m_name;
+    unique_ptr<Camera> m_camera;
+    unique_ptr<FramePublisher> m_publisher;
+    shared_ptr<FrameSubscriber> m_subscriber;
+};
+
+TEST_F(FramePublisherTest, SubscriberReadsThePublishedBuffer) {
+    uint8_t *published = publishNext();
+    ASSERT_NE(published, nullptr);
+
+    FrameHandle frame = borrowFromSubscriber();
+    ASSERT_TRUE(frame.valid());
+    EXPECT_EQ(frame->width, 256);
+    EXPECT_EQ(frame->height, 256);
+    span<const uint8_t> bytes = frame.bytes();
+    ASSERT_EQ(bytes.size(), 256u * 256);
+    EXPECT_EQ(memcmp(bytes.data(), published, bytes.size()), 0);
+
+    /* Not a copy: a write on the publisher's side shows through */
+    published[0] ^= 0xFF;
+    published[bytes.size() - 1] ^= 0xFF;
+    EXPECT_EQ(bytes[0], published[0]);
+    EXPECT_EQ(bytes[bytes.size() - 1], published[bytes.size() - 1]);
+    EXPECT_TRUE(m_subscriber->isCurrent(frame.frame()));
+}
+
+TEST_F(FramePublisherTest, StalledSubscriberSkipsFramesWithoutBlocking) {
+    ASSERT_NE(publishNext(), nullptr);
+    FrameHandle held = borrowFromSubscriber();
+    ASSERT_TRUE(held.valid());
+    uint64_t held_id = held->frame_id;
+
+    /* The only subscriber buffer is taken; publishing goes on regardless */
+    for (int i = 0; i < 4 * HOLD_FRAMES; i++) {
+        auto start = chrono::steady_clock::now();
+        ASSERT_NE(publishNext(), nullptr);
+        EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(500));
+    }
+    EXPECT_EQ(m_publisher->getStats().published, 4u * HOLD_FRAMES + 1);
+
+    held.reset();
+    FrameHandle next = borrowFromSubscriber();
+    ASSERT_TRUE(next.valid());
+    EXPECT_GT(next->frame_id, held_id + 1);
+    EXPECT_GT(m_subscriber->getStreamStats().underruns, 0u);
+}
+
+TEST_F(FramePublisherTest, FrameIsNoLongerCurrentAfterHoldFrames) {
+    ASSERT_NE(publishNext(), nullptr);
+    FrameHandle frame = borrowFromSubscriber();
+    ASSERT_TRUE(frame.valid());
+
+    for (int i = 0; i < HOLD_FRAMES - 1; i++) {
+        ASSERT_NE(publishNext(), nullptr);
+        EXPECT_TRUE(m_subscriber->isCurrent(frame.frame()));
+    }
+
+    /* The publisher gives the frame back to the camera */
+    ASSERT_NE(publishNext(), nullptr);
+    EXPECT_FALSE(m_subscriber->isCurrent(frame.frame()));
+}
+
+TEST_F(FramePublisherTest, SubscriberSeesThePublisherClose) {
+    EXPECT_FALSE(m_subscriber->publisherClosed());
+    m_publisher.reset();
+    EXPECT_TRUE(m_subscriber->publisherClosed());
+
+    /* No more frames will come, so a blocking borrow gives up at once */
+    auto start = chrono::steady_clock::now();
+    EXPECT_FALSE(borrowFromSubscriber().valid());
+    EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(500));
+}
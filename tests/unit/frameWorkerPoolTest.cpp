@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Camera.hpp"
+#include "FrameWorkerPool.hpp"
+#include "SimulatedBackend.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+#define BORROW_TIMEOUT chrono::milliseconds(1000)
+#define SUBMITTED_FRAMES 120
+
+/* Every third frame takes much longer, so later frames finish first */
+static uint64_t slowProcess(FrameHandle &frame) {
+    this_thread::sleep_for(chrono::milliseconds(frame->frame_id % 3 == 0 ? 40 : 10));
+    return frame->frame_id;
+}
+
+/* Feed SUBMITTED_FRAMES frames of a 500 fps simulated camera into `pool` */
+static void submitFrames(FrameWorkerPool<uint64_t> &pool) {
+    SimulatedConfig sim;
+    sim.frame_rate = 500.0;
+    sim.exposure_time_us = 1000.0;
+    sim.width = 256;
+    sim.height = 256;
+    Camera camera(SimulatedBackend::create(sim, 16));
+    ASSERT_FALSE(camera.startAcquisition().has_value());
+
+    for (int i = 0; i < SUBMITTED_FRAMES; i++) {
+        FrameHandle frame;
+        ASSERT_FALSE(camera.borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        pool.submit(move(frame));
+    }
+    pool.stop();
+    ASSERT_FALSE(camera.stopAcquisition().has_value());
+}
+
+TEST(FrameWorkerPool, OrderedDeliveryDropsOldestAndKeepsOrder) {
+    vector<uint64_t> delivered;
+    /* About 100 frames/s against a 500 fps camera */
+    FrameWorkerPoolConfig config {
+        .workers = 2,
+        .queue_depth = 1,
+        .backpressure = BackpressurePolicy::DROP_OLDEST,
+        .ordered = true,
+    };
+    FrameWorkerPool<uint64_t> pool(config, slowProcess,
+        [&](uint64_t frame_id, uint64_t &result) {
+            EXPECT_EQ(frame_id, result);
+            delivered.push_back(frame_id);
+        });
+
+    submitFrames(pool);
+    FrameWorkerPoolStats stats = pool.getStats();
+
+    /* The pool cannot keep up, so frames are dropped but never reordered */
+    EXPECT_EQ(stats.submitted, SUBMITTED_FRAMES);
+    EXPECT_GT(stats.dropped, 0u);
+    EXPECT_EQ(stats.processed + stats.dropped, stats.submitted);
+    EXPECT_EQ(stats.delivered, stats.processed);
+    ASSERT_EQ(delivered.size(), stats.delivered);
+    for (size_t i = 1; i < delivered.size(); i++) {
+        EXPECT_LT(delivered[i - 1], delivered[i]);
+    }
+}
+
+TEST(FrameWorkerPool, OrderedDeliveryWithBlockKeepsEveryFrame) {
+    vector<uint64_t> delivered;
+    FrameWorkerPoolConfig config {
+        .workers = 3,
+        .queue_depth = 1,
+        .backpressure = BackpressurePolicy::BLOCK,
+        .ordered = true,
+    };
+    FrameWorkerPool<uint64_t> pool(config, slowProcess,
+        [&](uint64_t frame_id, uint64_t &result) {
+            EXPECT_EQ(frame_id, result);
+            delivered.push_back(frame_id);
+        });
+
+    submitFrames(pool);
+    FrameWorkerPoolStats stats = pool.getStats();
+
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(stats.delivered, SUBMITTED_FRAMES);
+    EXPECT_GT(stats.peak_reorder, 0u);
+    ASSERT_EQ(delivered.size(), static_cast<size_t>(SUBMITTED_FRAMES));
+    for (size_t i = 1; i < delivered.size(); i++) {
+        EXPECT_LT(delivered[i - 1], delivered[i]);
+    }
+}
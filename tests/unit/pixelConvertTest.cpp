@@ -0,0 +1,234 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "PixelConvert.hpp"
+#include "PixelKernels.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+namespace cynlr {
+namespace camera {
+
+/* Name test parameters by instruction set in GTest output */
+void PrintTo(const PixelKernels &kernels, ostream *os) {
+    *os << kernels.isa;
+}
+
+}  // namespace camera
+}  // namespace cynlr
+
+/* Pixel counts around every SIMD step (8, 16, 32 pixels) and odd tails */
+static vector<size_t> testCounts() {
+    vector<size_t> counts;
+    for (size_t count = 0; count <= 70; count++) {
+        counts.push_back(count);
+    }
+    for (size_t count : {127, 128, 129, 255, 426, 1000, 1001, 1279, 1280, 1283}) {
+        counts.push_back(count);
+    }
+    return counts;
+}
+
+static vector<uint8_t> randomBytes(size_t size, uint32_t seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> byte(0, 255);
+    vector<uint8_t> bytes(size);
+    for (uint8_t &b : bytes) {
+        b = static_cast<uint8_t>(byte(rng));
+    }
+    return bytes;
+}
+
+static vector<uint16_t> randomPixels(size_t count, uint32_t seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> value(0, 65535);
+    vector<uint16_t> pixels(count);
+    for (uint16_t &p : pixels) {
+        p = static_cast<uint16_t>(value(rng));
+    }
+    return pixels;
+}
+
+/* Pixel i of a PFNC LSB-first bit stream of `bits`-bit pixels */
+static uint16_t streamPixel(const vector<uint8_t> &src, size_t i, int bits) {
+    uint32_t value = 0;
+    for (int b = 0; b < bits; b++) {
+        size_t bit = i * bits + b;
+        value |= ((src[bit / 8] >> (bit % 8)) & 1u) << b;
+    }
+    return static_cast<uint16_t>(value);
+}
+
+class PixelKernelTest : public ::testing::TestWithParam<PixelKernels> {
+protected:
+    /* Source sized exactly to the packed pixels, so reading past it trips ASan */
+    void checkUnpack(UnpackKernel kernel, UnpackKernel reference, int bits) {
+        for (size_t count : testCounts()) {
+            vector<uint8_t> src = randomBytes((count * bits + 7) / 8, static_cast<uint32_t>(count));
+            vector<uint16_t> expected(count);
+            vector<uint16_t> actual(count);
+            reference(src.data(), expected.data(), count);
+            kernel(src.data(), actual.data(), count);
+            ASSERT_EQ(expected, actual) << GetParam().isa << ", " << count << " pixels";
+        }
+    }
+
+    const PixelKernels &scalar() {
+        static const PixelKernels kernels = availablePixelKernels().back();
+        return kernels;
+    }
+};
+
+TEST_P(PixelKernelTest, UnpackMono10p) {
+    checkUnpack(GetParam().mono10p, scalar().mono10p, 10);
+}
+
+TEST_P(PixelKernelTest, UnpackMono12p) {
+    checkUnpack(GetParam().mono12p, scalar().mono12p, 12);
+}
+
+TEST_P(PixelKernelTest, UnpackMono10Packed) {
+    checkUnpack(GetParam().mono10_packed, scalar().mono10_packed, 12);
+}
+
+TEST_P(PixelKernelTest, UnpackMono12Packed) {
+    checkUnpack(GetParam().mono12_packed, scalar().mono12_packed, 12);
+}
+
+TEST_P(PixelKernelTest, Shift16To8) {
+    for (size_t count : testCounts()) {
+        vector<uint16_t> src = randomPixels(count, static_cast<uint32_t>(count));
+        for (int shift = 0; shift <= 15; shift++) {
+            vector<uint8_t> expected(count);
+            vector<uint8_t> actual(count);
+            scalar().shift(src.data(), expected.data(), count, shift);
+            GetParam().shift(src.data(), actual.data(), count, shift);
+            ASSERT_EQ(expected, actual) << GetParam().isa << ", " << count << " pixels, shift " << shift;
+        }
+    }
+}
+
+TEST_P(PixelKernelTest, Window16To8) {
+    /* Windows of at least 256 codes, where the SIMD kernels are used */
+    const pair<uint16_t, uint16_t> windows[] = { {0, 65535}, {0, 256}, {100, 4095}, {1000, 1256}, {60000, 65535} };
+    for (size_t count : testCounts()) {
+        vector<uint16_t> src = randomPixels(count, static_cast<uint32_t>(count) + 1);
+        for (auto [low, high] : windows) {
+            uint32_t range = high - low;
+            uint32_t scale = ((255u << 16) + range - 1) / range;
+            ASSERT_LE(scale, 0xFFFFu);
+            vector<uint8_t> expected(count);
+            vector<uint8_t> actual(count);
+            scalar().window(src.data(), expected.data(), count, low, scale);
+            GetParam().window(src.data(), actual.data(), count, low, scale);
+            ASSERT_EQ(expected, actual) << GetParam().isa << ", " << count << " pixels, window " << low << "-" << high;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AllIsas,
+    PixelKernelTest,
+    ::testing::ValuesIn(availablePixelKernels()),
+    [](const ::testing::TestParamInfo<PixelKernels> &info) {
+        string name = info.param.isa;
+        erase(name, '.');
+        return name;
+    });
+
+TEST(PixelConvertTest, ScalarUnpackMatchesBitStream) {
+    const PixelKernels scalar = availablePixelKernels().back();
+    for (size_t count : testCounts()) {
+        for (int bits : {10, 12}) {
+            vector<uint8_t> src = randomBytes((count * bits + 7) / 8, static_cast<uint32_t>(count * bits));
+            vector<uint16_t> actual(count);
+            (bits == 10 ? scalar.mono10p : scalar.mono12p)(src.data(), actual.data(), count);
+            for (size_t i = 0; i < count; i++) {
+                ASSERT_EQ(streamPixel(src, i, bits), actual[i]) << bits << "-bit pixel " << i << " of " << count;
+            }
+        }
+    }
+}
+
+TEST(PixelConvertTest, ScalarUnpackGigEPacked) {
+    const PixelKernels scalar = availablePixelKernels().back();
+    /* Two pixels in three bytes: high bits in bytes 0 and 2, low bits in byte 1 */
+    const uint8_t src[3] = { 0xAB, 0x5C, 0xDE };
+    uint16_t mono10[2];
+    uint16_t mono12[2];
+    scalar.mono10_packed(src, mono10, 2);
+    scalar.mono12_packed(src, mono12, 2);
+    EXPECT_EQ(mono10[0], (0xAB << 2) | 0x0);
+    EXPECT_EQ(mono10[1], (0xDE << 2) | 0x1);
+    EXPECT_EQ(mono12[0], (0xAB << 4) | 0xC);
+    EXPECT_EQ(mono12[1], (0xDE << 4) | 0x5);
+}
+
+TEST(PixelConvertTest, WindowDegenerateThresholds) {
+    const vector<uint16_t> src = { 0, 99, 100, 101, 65535 };
+    vector<uint8_t> dst(src.size());
+
+    window16To8(src.data(), dst.data(), src.size(), 100, 100);
+    EXPECT_EQ(dst, (vector<uint8_t>{ 0, 0, 0, 255, 255 }));
+
+    window16To8(src.data(), dst.data(), src.size(), 100, 50);
+    EXPECT_EQ(dst, (vector<uint8_t>{ 0, 0, 0, 255, 255 }));
+}
+
+TEST(PixelConvertTest, WindowNarrowerThan256Codes) {
+    /* 10 codes need more than 16 bits of gain */
+    vector<uint16_t> src;
+    for (uint16_t v = 90; v <= 120; v++) {
+        src.push_back(v);
+    }
+    vector<uint8_t> dst(src.size());
+    window16To8(src.data(), dst.data(), src.size(), 100, 110);
+
+    for (size_t i = 0; i < src.size(); i++) {
+        if (src[i] <= 100) {
+            EXPECT_EQ(dst[i], 0) << src[i];
+        } else if (src[i] >= 110) {
+            EXPECT_EQ(dst[i], 255) << src[i];
+        } else {
+            EXPECT_GT(dst[i], dst[i - 1]) << src[i];
+        }
+    }
+}
+
+TEST(PixelConvertTest, WindowFullRangeEndpoints) {
+    const uint16_t src[] = { 0, 4095, 4096, 65535 };
+    uint8_t dst[4];
+    window16To8(src, dst, 4, 0, 4095);
+    EXPECT_EQ(dst[0], 0);
+    EXPECT_EQ(dst[1], 255);
+    EXPECT_EQ(dst[2], 255);
+    EXPECT_EQ(dst[3], 255);
+}
+
+TEST(PixelConvertTest, UnpackToMono16HonoursStride) {
+    /* 6 Mono12p pixels (9 bytes) per row, padded to 12 bytes */
+    const int width = 6;
+    const int height = 3;
+    const size_t stride = 12;
+    vector<uint8_t> src = randomBytes(stride * height, 7);
+
+    FrameBuffer frame;
+    frame.data = src.data();
+    frame.width = width;
+    frame.height = height;
+    frame.stride = stride;
+    frame.pixel_format = PixelFormat::MONO12P;
+
+    vector<uint16_t> dst(width * height);
+    ASSERT_FALSE(unpackToMono16(frame, dst.data(), width * sizeof(uint16_t)));
+    for (int y = 0; y < height; y++) {
+        vector<uint8_t> row(src.begin() + y * stride, src.begin() + (y + 1) * stride);
+        for (int x = 0; x < width; x++) {
+            EXPECT_EQ(dst[y * width + x], streamPixel(row, x, 12)) << x << "," << y;
+        }
+    }
+}
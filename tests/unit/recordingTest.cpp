@@ -0,0 +1,234 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Camera.hpp"
+#include "FrameRecorder.hpp"
+#include "MappedFile.hpp"
+#include "ReplayBackend.hpp"
+#include "ReplayStream.hpp"
+#include "SimulatedBackend.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+#define BORROW_TIMEOUT chrono::milliseconds(1000)
+#define RECORDED_FRAMES 24
+
+/* What a recorded frame must look like on replay */
+typedef struct RecordedFrame {
+    uint64_t frame_id;
+    uint64_t system_timestamp_ns;
+    int width;
+    int height;
+    size_t stride;
+    vector<uint8_t> payload;
+} RecordedFrame;
+
+class RecordingTest : public ::testing::Test {
+protected:
+    /* Record RECORDED_FRAMES simulated Mono10p frames binned to 426 px, so
+     * the payloads are bit streams with stride 0 */
+    void SetUp() override {
+        m_path = ::testing::TempDir() + "recordingTest.cynrec";
+
+        SimulatedConfig sim;
+        sim.pixel_format = PixelFormat::MONO10P;
+        sim.frame_rate = 200.0;
+        sim.exposure_time_us = 1000.0;
+        Camera camera(SimulatedBackend::create(sim));
+        ASSERT_FALSE(camera.setBinning(3, 3).has_value());
+
+        FrameRecorderConfig config;
+        config.path = m_path;
+        config.max_frames = RECORDED_FRAMES;
+        config.max_bytes = 16ull << 20;
+        auto recorder = FrameRecorder::create(config);
+        ASSERT_TRUE(recorder);
+
+        ASSERT_FALSE(camera.startAcquisition().has_value());
+        while (m_frames.size() < RECORDED_FRAMES) {
+            FrameHandle frame;
+            ASSERT_FALSE(camera.borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+            span<const uint8_t> bytes = frame.bytes();
+            RecordedFrame recorded {
+                .frame_id = frame->frame_id,
+                .system_timestamp_ns = frame->system_timestamp_ns,
+                .width = frame->width,
+                .height = frame->height,
+                .stride = frame->stride,
+                .payload = vector<uint8_t>(bytes.begin(), bytes.end()),
+            };
+            if (recorder->submit(move(frame))) {
+                m_frames.push_back(move(recorded));
+            }
+        }
+        ASSERT_FALSE(recorder->close().has_value());
+        ASSERT_FALSE(camera.stopAcquisition().has_value());
+        ASSERT_EQ(recorder->getStats().written, RECORDED_FRAMES);
+    }
+
+    void TearDown() override {
+        remove(m_path.c_str());
+    }
+
+    unique_ptr<Camera> openReplay(ReplayBackend **player = nullptr) {
+        ReplayConfig config;
+        config.path = m_path;
+        config.mode = ReplayMode::FAST;
+        auto backend = ReplayBackend::create(config);
+        if (!backend) {
+            return nullptr;
+        }
+        if (player != nullptr) {
+            *player = backend.get();
+        }
+        return make_unique<Camera>(move(backend));
+    }
+
+    void expectFrame(const FrameHandle &frame, const RecordedFrame &recorded) {
+        EXPECT_EQ(frame->frame_id, recorded.frame_id);
+        EXPECT_EQ(frame->system_timestamp_ns, recorded.system_timestamp_ns);
+        EXPECT_EQ(frame->width, recorded.width);
+        EXPECT_EQ(frame->height, recorded.height);
+        EXPECT_EQ(frame->stride, recorded.stride);
+        EXPECT_EQ(frame->pixel_format, PixelFormat::MONO10P);
+        span<const uint8_t> bytes = frame.bytes();
+        ASSERT_EQ(bytes.size(), recorded.payload.size());
+        EXPECT_EQ(memcmp(bytes.data(), recorded.payload.data(), bytes.size()), 0);
+    }
+
+    /* Rewrite field `field` of index entry `entry` in the recording */
+    template<typename T>
+    void patchEntry(size_t entry, size_t field, T value) {
+        fstream file(m_path, ios::in | ios::out | ios::binary);
+        RecordingHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        file.seekp(static_cast<streamoff>(header.index_offset + entry * sizeof(RecordingIndexEntry) + field));
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    string m_path;
+    vector<RecordedFrame> m_frames;
+};
+
+TEST_F(RecordingTest, IndexLoadsWithEveryFrame) {
+    ReplayConfig config;
+    config.path = m_path;
+    auto file = MappedFile::open(m_path);
+    ASSERT_TRUE(file);
+    ReplayStream stream(config, move(file));
+    ASSERT_FALSE(stream.loadIndex().has_value());
+
+    EXPECT_EQ(stream.frameCount(), RECORDED_FRAMES);
+    EXPECT_EQ(stream.pixelFormat(), PixelFormat::MONO10P);
+    Region region = stream.region();
+    EXPECT_EQ(region.width, 426);
+    EXPECT_EQ(region.height, 341);
+}
+
+TEST_F(RecordingTest, ReplaysFramesAsRecorded) {
+    auto camera = openReplay();
+    ASSERT_TRUE(camera);
+    ASSERT_FALSE(camera->startAcquisition().has_value());
+
+    for (const RecordedFrame &recorded : m_frames) {
+        FrameHandle frame;
+        ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        expectFrame(frame, recorded);
+    }
+
+    /* Playback ends after the last frame */
+    FrameHandle frame;
+    EXPECT_TRUE(camera->borrowOldestFrame(frame, chrono::milliseconds(50)).has_value());
+    EXPECT_FALSE(camera->stopAcquisition().has_value());
+}
+
+TEST_F(RecordingTest, SeeksByFrameIdAndTimestamp) {
+    ReplayBackend *player = nullptr;
+    auto camera = openReplay(&player);
+    ASSERT_TRUE(camera);
+
+    const RecordedFrame &middle = m_frames[RECORDED_FRAMES / 2];
+    ASSERT_FALSE(player->seekToFrameId(middle.frame_id).has_value());
+    ASSERT_FALSE(camera->startAcquisition().has_value());
+    {
+        FrameHandle frame;
+        ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        expectFrame(frame, middle);
+    }
+
+    /* A timestamp between two frames lands on the later one */
+    const RecordedFrame &early = m_frames[2];
+    ASSERT_FALSE(player->seekToTimestamp(m_frames[1].system_timestamp_ns + 1).has_value());
+    {
+        FrameHandle frame;
+        ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        expectFrame(frame, early);
+    }
+
+    EXPECT_TRUE(player->seekToFrameId(m_frames.back().frame_id + 1).has_value());
+    EXPECT_TRUE(player->seekToTimestamp(m_frames.back().system_timestamp_ns + 1).has_value());
+    EXPECT_FALSE(camera->stopAcquisition().has_value());
+}
+
+TEST_F(RecordingTest, OnlyTheRecordedGeometryIsAccepted) {
+    auto camera = openReplay();
+    ASSERT_TRUE(camera);
+
+    EXPECT_FALSE(camera->setPixelFormat(PixelFormat::MONO10P).has_value());
+    EXPECT_TRUE(camera->setPixelFormat(PixelFormat::MONO8).has_value());
+    EXPECT_FALSE(camera->setBinning(1, 1).has_value());
+    EXPECT_TRUE(camera->setBinning(2, 2).has_value());
+    EXPECT_FALSE(camera->setRegion(0, 0, 426, 341).has_value());
+    EXPECT_TRUE(camera->setRegion(0, 0, 256, 256).has_value());
+}
+
+TEST_F(RecordingTest, IndexWithBadGeometryIsRejected) {
+    ReplayConfig config;
+    config.path = m_path;
+
+    patchEntry<int32_t>(3, offsetof(RecordingIndexEntry, height), 0);
+    EXPECT_FALSE(ReplayBackend::create(config));
+
+    patchEntry<int32_t>(3, offsetof(RecordingIndexEntry, height), 341);
+    EXPECT_TRUE(ReplayBackend::create(config));
+
+    /* Rows that would run past the payload */
+    patchEntry<uint32_t>(3, offsetof(RecordingIndexEntry, stride), 1 << 20);
+    EXPECT_FALSE(ReplayBackend::create(config));
+
+    /* A bit stream larger than the payload */
+    patchEntry<uint32_t>(3, offsetof(RecordingIndexEntry, stride), 0);
+    patchEntry<int32_t>(3, offsetof(RecordingIndexEntry, width), 4096);
+    EXPECT_FALSE(ReplayBackend::create(config));
+}
+
+TEST_F(RecordingTest, IndexWithOverlappingRowsIsRejected) {
+    ReplayConfig config;
+    config.path = m_path;
+
+    /* Ten Mono8 rows of 100 pixels squeezed into 10 bytes */
+    patchEntry<int32_t>(3, offsetof(RecordingIndexEntry, pixel_format), static_cast<int32_t>(PixelFormat::MONO8));
+    patchEntry<int32_t>(3, offsetof(RecordingIndexEntry, width), 100);
+    patchEntry<int32_t>(3, offsetof(RecordingIndexEntry, height), 10);
+    patchEntry<uint32_t>(3, offsetof(RecordingIndexEntry, stride), 1);
+    patchEntry<uint64_t>(3, offsetof(RecordingIndexEntry, payload_size), 10);
+    EXPECT_FALSE(ReplayBackend::create(config));
+
+    /* Whole rows, but the last one ends past the payload */
+    patchEntry<uint32_t>(3, offsetof(RecordingIndexEntry, stride), 100);
+    patchEntry<uint64_t>(3, offsetof(RecordingIndexEntry, payload_size), 999);
+    EXPECT_FALSE(ReplayBackend::create(config));
+
+    patchEntry<uint64_t>(3, offsetof(RecordingIndexEntry, payload_size), 1000);
+    EXPECT_TRUE(ReplayBackend::create(config));
+}
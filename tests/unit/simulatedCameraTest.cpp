@@ -0,0 +1,174 @@
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Camera.hpp"
+#include "PixelConvert.hpp"
+#include "SimulatedBackend.hpp"
+
+using namespace std;
+using namespace cynlr::camera;
+
+#define BORROW_TIMEOUT chrono::milliseconds(1000)
+
+static SimulatedConfig testConfig(PixelFormat format = PixelFormat::MONO8) {
+    SimulatedConfig config;
+    config.pixel_format = format;
+    config.frame_rate = 200.0;
+    config.exposure_time_us = 1000.0;
+    config.scroll_px = 0;
+    return config;
+}
+
+static unique_ptr<Camera> makeCamera(const SimulatedConfig &config) {
+    auto backend = SimulatedBackend::create(config);
+    if (!backend) {
+        return nullptr;
+    }
+    return make_unique<Camera>(move(backend));
+}
+
+/* Unpacked pixels of one frame, row after row */
+static vector<uint16_t> unpackFrame(const FrameHandle &frame) {
+    vector<uint16_t> pixels(static_cast<size_t>(frame->width) * frame->height);
+    auto err = unpackToMono16(frame.frame(), pixels.data(), frame->width * sizeof(uint16_t));
+    EXPECT_FALSE(err.has_value()) << err->message;
+    return pixels;
+}
+
+TEST(SimulatedCamera, BorrowTimesOutWhenNotAcquiring) {
+    auto camera = makeCamera(testConfig());
+    ASSERT_TRUE(camera);
+
+    FrameHandle frame;
+    auto start = chrono::steady_clock::now();
+    EXPECT_TRUE(camera->borrowOldestFrame(frame, chrono::milliseconds(50)).has_value());
+    EXPECT_GE(chrono::steady_clock::now() - start, chrono::milliseconds(40));
+    EXPECT_FALSE(frame.valid());
+}
+
+TEST(SimulatedCamera, StartsAndDeliversConsecutiveFrames) {
+    auto camera = makeCamera(testConfig());
+    ASSERT_TRUE(camera);
+    ASSERT_FALSE(camera->startAcquisition().has_value());
+
+    uint64_t previous = 0;
+    for (int i = 0; i < 20; i++) {
+        FrameHandle frame;
+        auto err = camera->borrowOldestFrame(frame, BORROW_TIMEOUT);
+        ASSERT_FALSE(err.has_value()) << err->message;
+        EXPECT_EQ(frame->status, FrameStatus::SUCCESS);
+        EXPECT_EQ(frame->width, 1280);
+        EXPECT_EQ(frame->height, 1024);
+        EXPECT_EQ(frame->stride, 1280u);
+        /* Frames are released at once, so the generator never runs dry */
+        if (i > 0) {
+            EXPECT_EQ(frame->frame_id, previous + 1);
+        }
+        previous = frame->frame_id;
+    }
+
+    EXPECT_FALSE(camera->stopAcquisition().has_value());
+}
+
+TEST(SimulatedCamera, BinningAndRegionSetTheGeometry) {
+    auto camera = makeCamera(testConfig(PixelFormat::MONO16));
+    ASSERT_TRUE(camera);
+
+    ASSERT_FALSE(camera->setBinning(2, 2).has_value());
+    ASSERT_FALSE(camera->startAcquisition().has_value());
+    {
+        FrameHandle frame;
+        ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        EXPECT_EQ(frame->width, 640);
+        EXPECT_EQ(frame->height, 512);
+        EXPECT_EQ(frame->stride, 640u * 2);
+        EXPECT_EQ(frame->payload_size, 640u * 512 * 2);
+    }
+    EXPECT_TRUE(camera->setRegion(64, 32, 256, 128).has_value());
+    ASSERT_FALSE(camera->stopAcquisition().has_value());
+
+    /* Region is in binned pixels and must fit the binned sensor */
+    EXPECT_TRUE(camera->setRegion(512, 0, 256, 128).has_value());
+    EXPECT_TRUE(camera->setRegion(4, 0, 256, 128).has_value());
+    ASSERT_FALSE(camera->setRegion(64, 32, 256, 128).has_value());
+    ASSERT_FALSE(camera->startAcquisition().has_value());
+    {
+        FrameHandle frame;
+        ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        EXPECT_EQ(frame->width, 256);
+        EXPECT_EQ(frame->height, 128);
+        EXPECT_EQ(frame->offset_x, 64);
+        EXPECT_EQ(frame->offset_y, 32);
+        EXPECT_EQ(frame->payload_size, 256u * 128 * 2);
+    }
+    ASSERT_FALSE(camera->stopAcquisition().has_value());
+
+    /* New binning falls back to the full binned sensor */
+    ASSERT_FALSE(camera->setBinning(4, 2).has_value());
+    ASSERT_FALSE(camera->startAcquisition().has_value());
+    {
+        FrameHandle frame;
+        ASSERT_FALSE(camera->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        EXPECT_EQ(frame->width, 320);
+        EXPECT_EQ(frame->height, 512);
+        EXPECT_EQ(frame->offset_x, 0);
+        EXPECT_EQ(frame->offset_y, 0);
+    }
+    ASSERT_FALSE(camera->stopAcquisition().has_value());
+}
+
+/* 1280 / 3 = 426 pixels of 10 bits is not a whole number of bytes, so the
+ * frame is one bit stream; it must unpack to the same image as Mono16 */
+TEST(SimulatedCamera, PackedFramesUnpackToTheMono16Image) {
+    auto reference = makeCamera(testConfig(PixelFormat::MONO16));
+    ASSERT_TRUE(reference);
+
+    for (PixelFormat format : { PixelFormat::MONO10P, PixelFormat::MONO12P,
+                                PixelFormat::MONO10_PACKED, PixelFormat::MONO12_PACKED }) {
+        SCOPED_TRACE(static_cast<int>(format));
+        auto packed = makeCamera(testConfig(format));
+        ASSERT_TRUE(packed);
+
+        for (Camera *camera : { reference.get(), packed.get() }) {
+            ASSERT_FALSE(camera->setBinning(3, 3).has_value());
+            ASSERT_FALSE(camera->startAcquisition().has_value());
+        }
+
+        FrameHandle mono16;
+        FrameHandle frame;
+        ASSERT_FALSE(reference->borrowOldestFrame(mono16, BORROW_TIMEOUT).has_value());
+        ASSERT_FALSE(packed->borrowOldestFrame(frame, BORROW_TIMEOUT).has_value());
+        ASSERT_EQ(frame->width, 426);
+        ASSERT_EQ(frame->height, 341);
+
+        int bits = pixelBitDepth(format);
+        int storage_bits = pixelStorageBits(format);
+        if ((426 * storage_bits) % 8 != 0) {
+            EXPECT_EQ(frame->stride, 0u);
+            EXPECT_TRUE(frame.row(0).empty());
+        } else {
+            EXPECT_EQ(frame->stride, 426u * storage_bits / 8);
+        }
+        EXPECT_EQ(frame->payload_size, (426u * 341 * storage_bits + 7) / 8);
+
+        vector<uint16_t> expected = unpackFrame(mono16);
+        vector<uint16_t> actual = unpackFrame(frame);
+        ASSERT_EQ(actual.size(), expected.size());
+        size_t mismatches = 0;
+        for (size_t i = 0; i < actual.size(); i++) {
+            if (actual[i] != (expected[i] >> (16 - bits))) {
+                mismatches++;
+            }
+        }
+        EXPECT_EQ(mismatches, 0u);
+
+        mono16.reset();
+        frame.reset();
+        for (Camera *camera : { reference.get(), packed.get() }) {
+            ASSERT_FALSE(camera->stopAcquisition().has_value());
+        }
+    }
+}